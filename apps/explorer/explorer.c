@@ -6,6 +6,7 @@
 #include <drivers/input.h>
 #include <stddef.h>
 #include <graphics.h>
+#include <kernel/trace.h>
 
 typedef struct {
     window_t *window;
@@ -50,6 +51,7 @@ void explorer_app_init(void) {
 
 void explorer_app_update(void) {
     if (!explorer.running || !explorer.window) return;
+    TRACE_BEGIN(TRACE_EXPLORER_UPDATE, 0, 0);
 
     if (explorer.window->needs_redraw) {
         wm_draw_window(explorer.window);
@@ -61,4 +63,5 @@ void explorer_app_update(void) {
         }
         explorer.window->needs_redraw = false;
     }
+    TRACE_END(TRACE_EXPLORER_UPDATE);
 }
@@ -7,6 +7,12 @@
 #include <drivers/input.h>
 #include <kernel/process.h>
 #include <kernel/kernel.h>
+#include <kernel/lockstat.h>
+#include <kernel/bench.h>
+#include <kernel/percpu.h>
+#include <kernel/idt.h>
+#include <kernel/trace.h>
+#include <kernel/prof.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
@@ -34,6 +40,18 @@ static void cmd_help(void) {
     graphics_draw_string(terminal.window->x + 10, terminal.window->y + 70,
                         "  ps       - List processes", COLOR_WHITE, terminal.window->background_color);
     graphics_draw_string(terminal.window->x + 10, terminal.window->y + 80,
+                        "  lockstat - Dump lock statistics", COLOR_WHITE, terminal.window->background_color);
+    graphics_draw_string(terminal.window->x + 10, terminal.window->y + 90,
+                        "  bench    - Run benchmarks (bench [name])", COLOR_WHITE, terminal.window->background_color);
+    graphics_draw_string(terminal.window->x + 10, terminal.window->y + 100,
+                        "  cpustat  - Per-CPU counters", COLOR_WHITE, terminal.window->background_color);
+    graphics_draw_string(terminal.window->x + 10, terminal.window->y + 110,
+                        "  irqstat  - Per-vector interrupt counters", COLOR_WHITE, terminal.window->background_color);
+    graphics_draw_string(terminal.window->x + 10, terminal.window->y + 120,
+                        "  trace    - Tracepoints (trace start|stop|dump|clear)", COLOR_WHITE, terminal.window->background_color);
+    graphics_draw_string(terminal.window->x + 10, terminal.window->y + 130,
+                        "  prof     - Sampling profiler (prof start|stop)", COLOR_WHITE, terminal.window->background_color);
+    graphics_draw_string(terminal.window->x + 10, terminal.window->y + 140,
                         "  exit     - Close terminal", COLOR_WHITE, terminal.window->background_color);
 }
 
@@ -57,6 +75,80 @@ static void cmd_ps(void) {
     terminal.cursor_y += 15;
 }
 
+static void cmd_lockstat(const char *args) {
+    if (strcmp(args, "reset") == 0) {
+        lockstat_reset();
+        graphics_draw_string(terminal.window->x + 10, terminal.cursor_y,
+                            "Lock statistics cleared", COLOR_WHITE, terminal.window->background_color);
+    } else {
+        lockstat_dump();
+        graphics_draw_string(terminal.window->x + 10, terminal.cursor_y,
+                            lockstat_enabled() ? "  (See kernel log for details)"
+                                               : "  lockstat disabled (build with LOCKSTAT=1)",
+                            COLOR_YELLOW, terminal.window->background_color);
+    }
+    terminal.cursor_y += 15;
+}
+
+static void cmd_bench(const char *args) {
+    if (strcmp(args, "list") == 0) {
+        bench_list();
+    } else if (bench_run(args) != 0) {
+        graphics_draw_string(terminal.window->x + 10, terminal.cursor_y,
+                            "  Unknown benchmark (try 'bench list')", COLOR_RED, terminal.window->background_color);
+        terminal.cursor_y += 15;
+        return;
+    }
+    graphics_draw_string(terminal.window->x + 10, terminal.cursor_y,
+                        "  (See kernel log for results)", COLOR_YELLOW, terminal.window->background_color);
+    terminal.cursor_y += 15;
+}
+
+static void cmd_trace(const char *args) {
+    const char *msg;
+    if (strcmp(args, "start") == 0) {
+        trace_start(TRACE_ALL);
+        msg = "Tracing started";
+    } else if (strcmp(args, "stop") == 0) {
+        trace_stop();
+        msg = "Tracing stopped";
+    } else if (strcmp(args, "clear") == 0) {
+        trace_clear();
+        msg = "Trace buffers cleared";
+    } else if (strcmp(args, "dump") == 0) {
+        trace_dump();
+        msg = "  (Chrome trace JSON written to COM1)";
+    } else {
+        graphics_draw_string(terminal.window->x + 10, terminal.cursor_y,
+                            "  Usage: trace start|stop|dump|clear", COLOR_RED, terminal.window->background_color);
+        terminal.cursor_y += 15;
+        return;
+    }
+    graphics_draw_string(terminal.window->x + 10, terminal.cursor_y,
+                        msg, COLOR_YELLOW, terminal.window->background_color);
+    terminal.cursor_y += 15;
+}
+
+static void cmd_prof(const char *args) {
+    const char *msg;
+    if (strcmp(args, "start") == 0) {
+        prof_start();
+        msg = "Profiling started";
+    } else if (strcmp(args, "stop") == 0) {
+        prof_stop();
+        prof_dump();
+        msg = "  (Folded stacks written to COM1)";
+    } else {
+        graphics_draw_string(terminal.window->x + 10, terminal.cursor_y,
+                            "  Usage: prof start|stop", COLOR_RED, terminal.window->background_color);
+        terminal.cursor_y += 15;
+        return;
+    }
+    graphics_draw_string(terminal.window->x + 10, terminal.cursor_y,
+                        msg, COLOR_YELLOW, terminal.window->background_color);
+    terminal.cursor_y += 15;
+}
+
 static void cmd_echo(const char *args) {
     graphics_draw_string(terminal.cursor_x, terminal.cursor_y,
                         (char *)args, COLOR_WHITE, terminal.window->background_color);
@@ -76,6 +168,32 @@ static void terminal_execute_command(const char *cmd) {
         cmd_clear();
     } else if (strcmp(cmd, "ps") == 0) {
         cmd_ps();
+    } else if (strcmp(cmd, "lockstat") == 0) {
+        cmd_lockstat("");
+    } else if (strncmp(cmd, "lockstat ", 9) == 0) {
+        cmd_lockstat(cmd + 9);
+    } else if (strcmp(cmd, "cpustat") == 0) {
+        percpu_dump_stats();
+        graphics_draw_string(terminal.window->x + 10, terminal.cursor_y,
+                            "  (See kernel log for details)", COLOR_YELLOW, terminal.window->background_color);
+        terminal.cursor_y += 15;
+    } else if (strcmp(cmd, "irqstat") == 0) {
+        irq_dump_stats();
+        graphics_draw_string(terminal.window->x + 10, terminal.cursor_y,
+                            "  (See kernel log for details)", COLOR_YELLOW, terminal.window->background_color);
+        terminal.cursor_y += 15;
+    } else if (strcmp(cmd, "bench") == 0) {
+        cmd_bench("");
+    } else if (strncmp(cmd, "bench ", 6) == 0) {
+        cmd_bench(cmd + 6);
+    } else if (strcmp(cmd, "trace") == 0) {
+        cmd_trace("");
+    } else if (strncmp(cmd, "trace ", 6) == 0) {
+        cmd_trace(cmd + 6);
+    } else if (strcmp(cmd, "prof") == 0) {
+        cmd_prof("");
+    } else if (strncmp(cmd, "prof ", 5) == 0) {
+        cmd_prof(cmd + 5);
     } else if (strcmp(cmd, "exit") == 0) {
         terminal.running = false;
     } else if (strncmp(cmd, "echo ", 5) == 0) {
@@ -159,6 +277,7 @@ void terminal_app_init(void) {
 
 void terminal_app_update(void) {
     if (!terminal.running || !terminal.window) return;
+    TRACE_BEGIN(TRACE_TERMINAL_UPDATE, 0, 0);
     
     if (terminal.window->needs_redraw) {
         wm_draw_window(terminal.window);
@@ -170,4 +289,5 @@ void terminal_app_update(void) {
         
         terminal.window->needs_redraw = false;
     }
+    TRACE_END(TRACE_TERMINAL_UPDATE);
 }
@@ -0,0 +1,189 @@
+/*
+ * Framebuffer Console Implementation
+ * Cell grid, changed-cell rendering and pixel-row scrolling
+ *
+ * fbcon_shown mirrors what the framebuffer currently displays, cell by
+ * cell; fbcon_cells is what it should display. Rows between dirty_first
+ * and dirty_last are compared on a flush and only differing cells are
+ * drawn. A scroll shifts both grids along with the pixels, so the cells
+ * that merely moved stay clean.
+ */
+
+#include <drivers/fbcon.h>
+#include <drivers/display.h>
+#include <kernel/kernel.h>
+#include <font.h>
+#include <string.h>
+
+/* ===== STATE ===== */
+static fbcon_cell_t fbcon_cells[FBCON_MAX_ROWS * FBCON_MAX_COLS];
+static fbcon_cell_t fbcon_shown[FBCON_MAX_ROWS * FBCON_MAX_COLS];
+static color_t fbcon_palette[16];
+
+static uint8_t *fbcon_fb = NULL;
+static uint32_t fbcon_pitch;
+static uint32_t fbcon_cols, fbcon_rows;
+static uint32_t fbcon_row, fbcon_col;
+static uint8_t fbcon_attr = (VGA_COLOR_BLACK << 4) | VGA_COLOR_WHITE;
+static uint32_t fbcon_dirty_first, fbcon_dirty_last;    /* Empty when first > last */
+
+/* VGA text colours */
+static const uint8_t fbcon_rgb[16][3] = {
+    {0x00, 0x00, 0x00}, {0x00, 0x00, 0xAA}, {0x00, 0xAA, 0x00}, {0x00, 0xAA, 0xAA},
+    {0xAA, 0x00, 0x00}, {0xAA, 0x00, 0xAA}, {0xAA, 0x55, 0x00}, {0xAA, 0xAA, 0xAA},
+    {0x55, 0x55, 0x55}, {0x55, 0x55, 0xFF}, {0x55, 0xFF, 0x55}, {0x55, 0xFF, 0xFF},
+    {0xFF, 0x55, 0x55}, {0xFF, 0x55, 0xFF}, {0xFF, 0xFF, 0x55}, {0xFF, 0xFF, 0xFF},
+};
+
+static inline void fbcon_mark(uint32_t row) {
+    if (row < fbcon_dirty_first) fbcon_dirty_first = row;
+    if (row > fbcon_dirty_last) fbcon_dirty_last = row;
+}
+
+static inline void fbcon_clean(void) {
+    fbcon_dirty_first = UINT32_MAX;
+    fbcon_dirty_last = 0;
+}
+
+/* ===== RENDERING ===== */
+static void fbcon_draw_cell(uint32_t row, uint32_t col, fbcon_cell_t cell) {
+    const uint8_t *glyph = font_glyph((char)cell.ch);
+    color_t fg = fbcon_palette[cell.attr & 0x0F];
+    color_t bg = fbcon_palette[cell.attr >> 4];
+    uint8_t *line = fbcon_fb + (uint64_t)row * FONT_HEIGHT * fbcon_pitch +
+                    (uint64_t)col * FONT_WIDTH * sizeof(color_t);
+
+    for (uint32_t y = 0; y < FONT_HEIGHT; y++) {
+        volatile color_t *px = (volatile color_t *)line;
+        uint8_t bits = glyph[y];
+        for (uint32_t x = 0; x < FONT_WIDTH; x++) {
+            px[x] = (bits & (0x80 >> x)) ? fg : bg;
+        }
+        line += fbcon_pitch;
+    }
+}
+
+void fbcon_flush(void) {
+    if (!fbcon_fb) return;
+
+    for (uint32_t row = fbcon_dirty_first; row <= fbcon_dirty_last && row < fbcon_rows; row++) {
+        fbcon_cell_t *want = &fbcon_cells[row * fbcon_cols];
+        fbcon_cell_t *shown = &fbcon_shown[row * fbcon_cols];
+        for (uint32_t col = 0; col < fbcon_cols; col++) {
+            if (want[col].ch != shown[col].ch || want[col].attr != shown[col].attr) {
+                fbcon_draw_cell(row, col, want[col]);
+                shown[col] = want[col];
+            }
+        }
+    }
+    fbcon_clean();
+}
+
+/* ===== SCROLLING ===== */
+static void fbcon_scroll(void) {
+    uint64_t text_row = (uint64_t)FONT_HEIGHT * fbcon_pitch;
+    uint32_t moved = (fbcon_rows - 1) * fbcon_cols;
+
+    memmove(fbcon_fb, fbcon_fb + text_row, text_row * (fbcon_rows - 1));
+    memmove(fbcon_shown, fbcon_shown + fbcon_cols, moved * sizeof(fbcon_cell_t));
+    memmove(fbcon_cells, fbcon_cells + fbcon_cols, moved * sizeof(fbcon_cell_t));
+    /* The last row of pixels, and so of fbcon_shown, is left as it was */
+
+    fbcon_cell_t blank = { ' ', fbcon_attr };
+    for (uint32_t col = 0; col < fbcon_cols; col++) {
+        fbcon_cells[moved + col] = blank;
+    }
+
+    /* Pending rows moved up with everything else */
+    if (fbcon_dirty_first <= fbcon_dirty_last) {
+        if (fbcon_dirty_first > 0) fbcon_dirty_first--;
+        if (fbcon_dirty_last > 0) fbcon_dirty_last--;
+    }
+    fbcon_mark(fbcon_rows - 1);
+}
+
+static void fbcon_newline(void) {
+    fbcon_col = 0;
+    if (++fbcon_row >= fbcon_rows) {
+        fbcon_scroll();
+        fbcon_row = fbcon_rows - 1;
+    }
+}
+
+/* ===== OUTPUT ===== */
+static void fbcon_put(char c) {
+    if (c == '\n') {
+        fbcon_newline();
+        return;
+    }
+    if (c == '\r') {
+        fbcon_col = 0;
+        return;
+    }
+    if (c == '\t') {
+        fbcon_col = (fbcon_col + 4) & ~3U;
+        if (fbcon_col >= fbcon_cols) fbcon_newline();
+        return;
+    }
+
+    fbcon_cells[fbcon_row * fbcon_cols + fbcon_col] = (fbcon_cell_t){ (uint8_t)c, fbcon_attr };
+    fbcon_mark(fbcon_row);
+    if (++fbcon_col >= fbcon_cols) fbcon_newline();
+}
+
+void fbcon_putchar(char c) {
+    if (!fbcon_fb) return;
+    fbcon_put(c);
+    fbcon_flush();
+}
+
+void fbcon_write(const char *str) {
+    if (!fbcon_fb) return;
+    while (*str) {
+        fbcon_put(*str++);
+    }
+    fbcon_flush();
+}
+
+void fbcon_set_color(vga_color_t fg, vga_color_t bg) {
+    fbcon_attr = (uint8_t)((bg << 4) | (fg & 0x0F));
+}
+
+/* Drawn in full: someone else (the window manager) may have drawn over us */
+void fbcon_clear(void) {
+    if (!fbcon_fb) return;
+
+    fbcon_cell_t blank = { ' ', fbcon_attr };
+    for (uint32_t i = 0; i < fbcon_rows * fbcon_cols; i++) {
+        fbcon_cells[i] = blank;
+        fbcon_shown[i] = (fbcon_cell_t){ 0, 0xFF };     /* Matches no real cell */
+    }
+    fbcon_row = fbcon_col = 0;
+    fbcon_dirty_first = 0;
+    fbcon_dirty_last = fbcon_rows - 1;
+    fbcon_flush();
+}
+
+/* ===== INITIALIZATION ===== */
+int fbcon_init(void) {
+    if (!bootinfo.framebuffer || bootinfo.framebuffer_bpp != 32) return -1;
+
+    fbcon_cols = bootinfo.framebuffer_width / FONT_WIDTH;
+    fbcon_rows = bootinfo.framebuffer_height / FONT_HEIGHT;
+    if (fbcon_cols > FBCON_MAX_COLS) fbcon_cols = FBCON_MAX_COLS;
+    if (fbcon_rows > FBCON_MAX_ROWS) fbcon_rows = FBCON_MAX_ROWS;
+    if (fbcon_cols == 0 || fbcon_rows < 2) return -1;
+
+    for (uint32_t i = 0; i < 16; i++) {
+        fbcon_palette[i] = graphics_make_color(fbcon_rgb[i][0], fbcon_rgb[i][1], fbcon_rgb[i][2]);
+    }
+
+    fbcon_fb = (uint8_t *)bootinfo.framebuffer;
+    fbcon_pitch = bootinfo.framebuffer_pitch;
+    fbcon_clear();
+    return 0;
+}
+
+bool fbcon_ready(void) {
+    return fbcon_fb != NULL;
+}
@@ -5,11 +5,13 @@
 
 #include <drivers/display.h>
 #include <kernel/kernel.h>
+#include <memory.h>
 #include <string.h>
 
 /* ===== GRAPHICS CONTEXT ===== */
 static graphics_context_t gfx_ctx = {0};
 static bool graphics_initialized = false;
+static color_t graphics_back[GRAPHICS_BACK_PIXELS];
 
 /* ===== SIMPLE FONT DATA (4x6 monospace) ===== */
 static const uint8_t simple_font[256][6] = {
@@ -37,57 +39,193 @@ void graphics_init(void) {
     gfx_ctx.current_x = 0;
     gfx_ctx.current_y = 0;
     
+    if ((uint64_t)gfx_ctx.info.width * gfx_ctx.info.height <= GRAPHICS_BACK_PIXELS) {
+        gfx_ctx.back_buffer = graphics_back;
+        gfx_ctx.back_pitch = gfx_ctx.info.width * sizeof(color_t);
+    }
+    gfx_ctx.num_dirty = 0;
+    
     graphics_initialized = true;
     
-    KINFO("Graphics initialized: %dx%d, %d bpp", 
-          gfx_ctx.info.width, gfx_ctx.info.height, gfx_ctx.info.bpp);
+    /* Firmware may leave the framebuffer uncached; stores should combine */
+    bool wc = gfx_ctx.info.framebuffer &&
+              paging_set_cache(gfx_ctx.info.framebuffer,
+                               (uint64_t)gfx_ctx.info.pitch * gfx_ctx.info.height,
+                               PAGING_CACHE_WC) == 0;
+    
+    KINFO("Graphics initialized: %dx%d, %d bpp%s%s", 
+          gfx_ctx.info.width, gfx_ctx.info.height, gfx_ctx.info.bpp,
+          wc ? ", write-combining" : "",
+          gfx_ctx.back_buffer ? ", back buffer" : "");
+}
+
+/* ===== DIRTY RECTANGLES ===== */
+static inline uint64_t graphics_area(const graphics_rect_t *r) {
+    return (uint64_t)r->width * r->height;
+}
+
+static inline graphics_rect_t graphics_union(const graphics_rect_t *a, const graphics_rect_t *b) {
+    uint32_t x0 = a->x < b->x ? a->x : b->x;
+    uint32_t y0 = a->y < b->y ? a->y : b->y;
+    uint32_t x1 = a->x + a->width > b->x + b->width ? a->x + a->width : b->x + b->width;
+    uint32_t y1 = a->y + a->height > b->y + b->height ? a->y + a->height : b->y + b->height;
+    return (graphics_rect_t){ x0, y0, x1 - x0, y1 - y0 };
+}
+
+/*
+ * Record a clipped, non-empty rectangle. Nothing changes if an entry
+ * already covers it; otherwise it joins an entry when their union
+ * wastes at most GRAPHICS_DIRTY_SLACK pixels, which keeps runs of
+ * pixels, glyphs and adjoining spans down to one entry.
+ */
+static void graphics_damage(uint32_t x, uint32_t y, uint32_t width, uint32_t height) {
+    if (!gfx_ctx.back_buffer) return;
+
+    graphics_rect_t rect = { x, y, width, height };
+    for (uint32_t i = 0; i < gfx_ctx.num_dirty; i++) {
+        graphics_rect_t *d = &gfx_ctx.dirty[i];
+        if (x >= d->x && y >= d->y && x + width <= d->x + d->width && y + height <= d->y + d->height) {
+            return;
+        }
+        graphics_rect_t u = graphics_union(d, &rect);
+        if (graphics_area(&u) <= graphics_area(d) + graphics_area(&rect) + GRAPHICS_DIRTY_SLACK) {
+            *d = u;
+            return;
+        }
+    }
+
+    if (gfx_ctx.num_dirty < GRAPHICS_MAX_DIRTY) {
+        gfx_ctx.dirty[gfx_ctx.num_dirty++] = rect;
+        return;
+    }
+
+    for (uint32_t i = 1; i < gfx_ctx.num_dirty; i++) {
+        rect = graphics_union(&rect, &gfx_ctx.dirty[i]);
+    }
+    gfx_ctx.dirty[0] = graphics_union(&rect, &gfx_ctx.dirty[0]);
+    gfx_ctx.num_dirty = 1;
+}
+
+/* ===== PRESENT ===== */
+/* Eight bytes per move once dst is 8-byte aligned, like fill_span32() */
+static inline void copy_span32(color_t *dst, const color_t *src, uint32_t count) {
+    if (count && ((uintptr_t)dst & 7)) {
+        *dst++ = *src++;
+        count--;
+    }
+
+    uint64_t qwords = count / 2;
+    __asm__ volatile("rep movsq" : "+D"(dst), "+S"(src), "+c"(qwords) :: "memory");
+
+    if (count & 1) {
+        *dst = *src;
+    }
+}
+
+void graphics_present(void) {
+    if (!graphics_initialized || !gfx_ctx.back_buffer) return;
+
+    for (uint32_t i = 0; i < gfx_ctx.num_dirty; i++) {
+        const graphics_rect_t *d = &gfx_ctx.dirty[i];
+        const uint8_t *src = (const uint8_t *)gfx_ctx.back_buffer +
+                             (uint64_t)d->y * gfx_ctx.back_pitch + (uint64_t)d->x * sizeof(color_t);
+        uint8_t *dst = (uint8_t *)gfx_ctx.info.framebuffer +
+                       (uint64_t)d->y * gfx_ctx.info.pitch + (uint64_t)d->x * sizeof(color_t);
+
+        for (uint32_t row = 0; row < d->height; row++) {
+            copy_span32((color_t *)dst, (const color_t *)src, d->width);
+            src += gfx_ctx.back_pitch;
+            dst += gfx_ctx.info.pitch;
+        }
+    }
+    gfx_ctx.num_dirty = 0;
+}
+
+/* ===== SPANS ===== */
+/* A row of the drawing target; scanlines are pitch bytes apart, which may be more than width pixels */
+static inline color_t *graphics_row(uint32_t y) {
+    if (gfx_ctx.back_buffer) {
+        return (color_t *)((uint8_t *)gfx_ctx.back_buffer + (uint64_t)y * gfx_ctx.back_pitch);
+    }
+    return (color_t *)((uint8_t *)gfx_ctx.info.framebuffer + (uint64_t)y * gfx_ctx.info.pitch);
+}
+
+/*
+ * count pixels from dst, already clipped. Eight bytes per store once
+ * dst is 8-byte aligned; a stray pixel at either end is stored alone.
+ */
+static inline void fill_span32(color_t *dst, uint32_t count, color_t color) {
+    if (count && ((uintptr_t)dst & 7)) {
+        *dst++ = color;
+        count--;
+    }
+
+    uint64_t pair = ((uint64_t)color << 32) | color;
+    uint64_t qwords = count / 2;
+    __asm__ volatile("rep stosq" : "+D"(dst), "+c"(qwords) : "a"(pair) : "memory");
+
+    if (count & 1) {
+        *dst = color;
+    }
+}
+
+/* Clip once to the screen; false if nothing is left */
+static inline bool graphics_clip(uint32_t *x, uint32_t *y, uint32_t *width, uint32_t *height) {
+    if (*x >= gfx_ctx.info.width || *y >= gfx_ctx.info.height) return false;
+    if (*width > gfx_ctx.info.width - *x) *width = gfx_ctx.info.width - *x;
+    if (*height > gfx_ctx.info.height - *y) *height = gfx_ctx.info.height - *y;
+    return *width && *height;
+}
+
+static void fill_rect(uint32_t x, uint32_t y, uint32_t width, uint32_t height, color_t color) {
+    if (!graphics_clip(&x, &y, &width, &height)) return;
+
+    for (uint32_t row = y; row < y + height; row++) {
+        fill_span32(graphics_row(row) + x, width, color);
+    }
+    graphics_damage(x, y, width, height);
 }
 
 /* ===== BASIC DRAWING ===== */
 void graphics_clear(color_t color) {
     if (!graphics_initialized) return;
-    
-    color_t *fb = (color_t *)gfx_ctx.info.framebuffer;
-    uint32_t pixel_count = gfx_ctx.info.width * gfx_ctx.info.height;
-    
-    for (uint32_t i = 0; i < pixel_count; i++) {
-        fb[i] = color;
-    }
+    fill_rect(0, 0, gfx_ctx.info.width, gfx_ctx.info.height, color);
 }
 
 void graphics_draw_pixel(uint32_t x, uint32_t y, color_t color) {
     if (!graphics_initialized) return;
     if (x >= gfx_ctx.info.width || y >= gfx_ctx.info.height) return;
     
-    color_t *fb = (color_t *)gfx_ctx.info.framebuffer;
-    fb[y * gfx_ctx.info.width + x] = color;
+    graphics_row(y)[x] = color;
+    graphics_damage(x, y, 1, 1);
+}
+
+void graphics_fill_span32(uint32_t x, uint32_t y, uint32_t width, color_t color) {
+    if (!graphics_initialized) return;
+    fill_rect(x, y, width, 1, color);
 }
 
+/* Two horizontal spans and the two one-pixel columns between them */
 void graphics_draw_rect(uint32_t x, uint32_t y, uint32_t width, uint32_t height, 
                        color_t color) {
-    if (!graphics_initialized) return;
+    if (!graphics_initialized || !width || !height) return;
     
-    /* Draw outline */
-    for (uint32_t i = 0; i < width; i++) {
-        graphics_draw_pixel(x + i, y, color);
-        graphics_draw_pixel(x + i, y + height - 1, color);
+    fill_rect(x, y, width, 1, color);
+    if (height > 1) {
+        fill_rect(x, y + height - 1, width, 1, color);
     }
-    
-    for (uint32_t i = 0; i < height; i++) {
-        graphics_draw_pixel(x, y + i, color);
-        graphics_draw_pixel(x + width - 1, y + i, color);
+    if (height > 2) {
+        fill_rect(x, y + 1, 1, height - 2, color);
+        if (width > 1) {
+            fill_rect(x + width - 1, y + 1, 1, height - 2, color);
+        }
     }
 }
 
 void graphics_fill_rect(uint32_t x, uint32_t y, uint32_t width, uint32_t height, 
                        color_t color) {
     if (!graphics_initialized) return;
-    
-    for (uint32_t yy = y; yy < y + height && yy < gfx_ctx.info.height; yy++) {
-        for (uint32_t xx = x; xx < x + width && xx < gfx_ctx.info.width; xx++) {
-            graphics_draw_pixel(xx, yy, color);
-        }
-    }
+    fill_rect(x, y, width, height, color);
 }
 
 void graphics_draw_line(uint32_t x1, uint32_t y1, uint32_t x2, uint32_t y2, 
@@ -179,15 +317,17 @@ void graphics_blit(uint32_t x, uint32_t y, uint32_t width, uint32_t height,
                   const color_t *data) {
     if (!graphics_initialized) return;
     
-    color_t *fb = (color_t *)gfx_ctx.info.framebuffer;
-    
     for (uint32_t yy = 0; yy < height && y + yy < gfx_ctx.info.height; yy++) {
+        color_t *dst = graphics_row(y + yy);
         for (uint32_t xx = 0; xx < width && x + xx < gfx_ctx.info.width; xx++) {
-            uint32_t src_idx = yy * width + xx;
-            uint32_t dst_idx = (y + yy) * gfx_ctx.info.width + (x + xx);
-            fb[dst_idx] = data[src_idx];
+            dst[x + xx] = data[yy * width + xx];
         }
     }
+
+    uint32_t w = width, h = height;
+    if (graphics_clip(&x, &y, &w, &h)) {
+        graphics_damage(x, y, w, h);
+    }
 }
 
 /* ===== COLOR UTILITIES ===== */
@@ -5,6 +5,7 @@
 
 #include <drivers/input.h>
 #include <kernel/kernel.h>
+#include <kernel/trace.h>
 #include <stddef.h>
 
 /* ===== INPUT DEVICE MANAGEMENT ===== */
@@ -144,6 +145,7 @@ bool input_has_event(void) {
 }
 
 void input_process_events(void) {
+    TRACE_BEGIN(TRACE_INPUT_EVENTS, 0, 0);
     while (input_has_event()) {
         input_event_t event = input_get_event();
         
@@ -158,6 +160,7 @@ void input_process_events(void) {
             }
         }
     }
+    TRACE_END(TRACE_INPUT_EVENTS);
 }
 
 void input_register_key_handler(key_handler_t handler) {
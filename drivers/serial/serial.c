@@ -0,0 +1,230 @@
+/*
+ * Serial Port Driver Implementation
+ * 16550 UART with a TX ring refilled from the THRE interrupt
+ *
+ * Writers append to the ring under serial_lock with interrupts off and,
+ * if the transmitter is idle, load the first FIFO-full themselves; the
+ * THRE interrupt then moves up to a FIFO-full per interrupt until the
+ * ring is empty and turns itself off. Nothing waits on the UART unless
+ * the ring is full or someone asks for serial_flush().
+ *
+ * A panic can come while serial_lock is held, by this CPU or one that
+ * will never release it, so serial_panic() switches every writer to
+ * polling the UART without the lock.
+ */
+
+#include <drivers/serial.h>
+#include <kernel/kernel.h>
+#include <kernel/cpu.h>
+#include <kernel/idt.h>
+
+#define SERIAL_TX_MASK      (SERIAL_TX_RING - 1)
+
+_Static_assert((SERIAL_TX_RING & SERIAL_TX_MASK) == 0, "SERIAL_TX_RING must be a power of two");
+
+/* ===== STATE ===== */
+static bool serial_present = false;
+static bool serial_irq_mode = false;
+static volatile bool serial_panicked = false;
+static uint32_t serial_fifo_size = 1;
+static uint8_t serial_ier = 0;
+
+static spinlock_t serial_lock;
+static char serial_tx[SERIAL_TX_RING];
+static uint32_t serial_tx_head = 0;     /* Next byte to queue */
+static uint32_t serial_tx_tail = 0;     /* Next byte to send */
+
+static inline uint32_t serial_tx_used(void) {
+    return serial_tx_head - serial_tx_tail;
+}
+
+static void serial_set_ier(uint8_t ier) {
+    if (ier != serial_ier) {
+        serial_ier = ier;
+        outb(SERIAL_COM1 + SERIAL_IER, ier);
+    }
+}
+
+/* ===== TRANSMIT (serial_lock held, interrupts off) ===== */
+/* Load one FIFO-full if the transmitter has room; true if it did */
+static bool serial_tx_fill(void) {
+    if (!(inb(SERIAL_COM1 + SERIAL_LSR) & SERIAL_LSR_THRE)) return false;
+
+    for (uint32_t i = 0; i < serial_fifo_size && serial_tx_used(); i++) {
+        outb(SERIAL_COM1 + SERIAL_DATA, (uint8_t)serial_tx[serial_tx_tail & SERIAL_TX_MASK]);
+        serial_tx_tail++;
+    }
+    return true;
+}
+
+/* Interrupt-driven: THRE stays enabled exactly while bytes are queued */
+static void serial_tx_kick(void) {
+    if (serial_irq_mode) {
+        serial_tx_fill();
+        serial_set_ier(serial_tx_used() ? SERIAL_IER_THRE : 0);
+        return;
+    }
+    while (serial_tx_used()) {
+        if (!serial_tx_fill()) cpu_relax();
+    }
+}
+
+static void serial_tx_put(char c) {
+    /* Full: make room by feeding the FIFO from here */
+    while (serial_tx_used() == SERIAL_TX_RING) {
+        if (!serial_tx_fill()) cpu_relax();
+    }
+    serial_tx[serial_tx_head & SERIAL_TX_MASK] = c;
+    serial_tx_head++;
+}
+
+/* ===== PANIC (no lock) ===== */
+static void serial_poll_putc(char c) {
+    while (!(inb(SERIAL_COM1 + SERIAL_LSR) & SERIAL_LSR_THRE)) {
+        cpu_relax();
+    }
+    outb(SERIAL_COM1 + SERIAL_DATA, (uint8_t)c);
+}
+
+static void serial_poll_write(const char *str) {
+    for (; *str; str++) {
+        if (*str == '\n') serial_poll_putc('\r');
+        serial_poll_putc(*str);
+    }
+}
+
+/* Caller has interrupts off; whatever the ring still holds goes first, best effort */
+void serial_panic(void) {
+    if (!serial_present || serial_panicked) return;
+
+    serial_panicked = true;
+    outb(SERIAL_COM1 + SERIAL_IER, 0);
+
+    uint32_t tail = serial_tx_tail;
+    uint32_t head = serial_tx_head;
+    if (head - tail > SERIAL_TX_RING) tail = head - SERIAL_TX_RING;
+    for (; tail != head; tail++) {
+        serial_poll_putc(serial_tx[tail & SERIAL_TX_MASK]);
+    }
+}
+
+/* ===== INTERRUPT ===== */
+static void serial_irq(uint32_t irq) {
+    (void)irq;
+    spinlock_acquire(&serial_lock);
+
+    uint8_t iir;
+    while (!((iir = inb(SERIAL_COM1 + SERIAL_IIR)) & SERIAL_IIR_NONE)) {
+        switch ((iir >> 1) & 0x07) {
+            case 0: inb(SERIAL_COM1 + SERIAL_MSR); break;     /* Modem status */
+            case 1: serial_tx_fill(); break;                  /* THR empty */
+            case 3: inb(SERIAL_COM1 + SERIAL_LSR); break;     /* Line status */
+            default: inb(SERIAL_COM1 + SERIAL_DATA); break;   /* RX data or timeout */
+        }
+        if (!serial_tx_used()) {
+            serial_set_ier(0);
+        }
+    }
+
+    spinlock_release(&serial_lock);
+}
+
+/* ===== INITIALIZATION ===== */
+void serial_init(void) {
+    uint16_t divisor = 115200 / SERIAL_BAUD;
+
+    spinlock_init(&serial_lock);
+
+    outb(SERIAL_COM1 + SERIAL_IER, 0x00);              /* Interrupts come later */
+    outb(SERIAL_COM1 + SERIAL_LCR, SERIAL_LCR_DLAB);
+    outb(SERIAL_COM1 + SERIAL_DATA, divisor & 0xFF);
+    outb(SERIAL_COM1 + SERIAL_IER, divisor >> 8);
+    outb(SERIAL_COM1 + SERIAL_LCR, SERIAL_LCR_8N1);
+    outb(SERIAL_COM1 + SERIAL_FCR, SERIAL_FCR_ENABLE);
+
+    /* An 8250/16450 has no FIFO: one byte per THRE */
+    if ((inb(SERIAL_COM1 + SERIAL_IIR) & SERIAL_IIR_FIFO) == SERIAL_IIR_FIFO) {
+        serial_fifo_size = SERIAL_FIFO_SIZE;
+    }
+
+    /* Loopback self-test: a missing UART reads back 0xFF */
+    outb(SERIAL_COM1 + SERIAL_MCR, 0x1E);
+    outb(SERIAL_COM1 + SERIAL_DATA, 0xAE);
+    serial_present = inb(SERIAL_COM1 + SERIAL_DATA) == 0xAE;
+
+    /* Normal operation: DTR, RTS, OUT2 */
+    outb(SERIAL_COM1 + SERIAL_MCR, 0x03 | SERIAL_MCR_OUT2);
+}
+
+void serial_enable_interrupts(void) {
+    if (!serial_present || serial_irq_mode) return;
+
+    uint64_t flags = interrupts_save();
+    spinlock_acquire(&serial_lock);
+    serial_irq_mode = true;
+    irq_register(IRQ_COM1, serial_irq);
+    serial_tx_kick();
+    spinlock_release(&serial_lock);
+    interrupts_restore(flags);
+}
+
+bool serial_ready(void) {
+    return serial_present;
+}
+
+/* ===== OUTPUT ===== */
+void serial_putc(char c) {
+    if (!serial_present) return;
+    if (serial_panicked) {
+        serial_poll_putc(c);
+        return;
+    }
+
+    uint64_t flags = interrupts_save();
+    spinlock_acquire(&serial_lock);
+    serial_tx_put(c);
+    serial_tx_kick();
+    spinlock_release(&serial_lock);
+    interrupts_restore(flags);
+}
+
+void serial_write(const char *str) {
+    if (!serial_present) return;
+    if (serial_panicked) {
+        serial_poll_write(str);
+        return;
+    }
+
+    uint64_t flags = interrupts_save();
+    spinlock_acquire(&serial_lock);
+    for (; *str; str++) {
+        if (*str == '\n') serial_tx_put('\r');
+        serial_tx_put(*str);
+    }
+    serial_tx_kick();
+    spinlock_release(&serial_lock);
+    interrupts_restore(flags);
+}
+
+/* Polls: also works with interrupts off, e.g. on the way to a halt */
+void serial_flush(void) {
+    if (!serial_present) return;
+    if (serial_panicked) {
+        while (!(inb(SERIAL_COM1 + SERIAL_LSR) & SERIAL_LSR_TEMT)) {
+            cpu_relax();
+        }
+        return;
+    }
+
+    uint64_t flags = interrupts_save();
+    spinlock_acquire(&serial_lock);
+    while (serial_tx_used()) {
+        if (!serial_tx_fill()) cpu_relax();
+    }
+    serial_set_ier(0);
+    while (!(inb(SERIAL_COM1 + SERIAL_LSR) & SERIAL_LSR_TEMT)) {
+        cpu_relax();
+    }
+    spinlock_release(&serial_lock);
+    interrupts_restore(flags);
+}
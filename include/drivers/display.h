@@ -44,6 +44,23 @@ typedef struct {
     color_format_t format;
 } display_info_t;
 
+/* ===== BACK BUFFER =====
+ * Drawing goes to a RAM copy of the screen; every draw call records
+ * the rectangle it touched, and graphics_present() copies just those
+ * to the framebuffer. Screens larger than the reserve are drawn
+ * directly, and graphics_present() has nothing to do.
+ */
+#define GRAPHICS_BACK_PIXELS    (1280 * 1024)
+#define GRAPHICS_MAX_DIRTY      32      /* Past this, the list collapses to its bounding box */
+#define GRAPHICS_DIRTY_SLACK    (64 * 64)   /* Pixels a merge may add that nobody drew */
+
+typedef struct {
+    uint32_t x;
+    uint32_t y;
+    uint32_t width;
+    uint32_t height;
+} graphics_rect_t;
+
 /* ===== GRAPHICS CONTEXT ===== */
 typedef struct {
     display_info_t info;
@@ -51,14 +68,21 @@ typedef struct {
     color_t background;
     uint32_t current_x;
     uint32_t current_y;
+
+    color_t *back_buffer;   /* NULL: draw straight to info.framebuffer */
+    uint32_t back_pitch;    /* Bytes per back buffer row */
+    graphics_rect_t dirty[GRAPHICS_MAX_DIRTY];
+    uint32_t num_dirty;
 } graphics_context_t;
 
 /* ===== GRAPHICS FUNCTIONS ===== */
 void graphics_init(void);
+void graphics_present(void);        /* Copy what was drawn since the last call to the screen */
 void graphics_clear(color_t color);
 void graphics_draw_pixel(uint32_t x, uint32_t y, color_t color);
 void graphics_draw_rect(uint32_t x, uint32_t y, uint32_t width, uint32_t height, color_t color);
 void graphics_fill_rect(uint32_t x, uint32_t y, uint32_t width, uint32_t height, color_t color);
+void graphics_fill_span32(uint32_t x, uint32_t y, uint32_t width, color_t color);  /* One scanline */
 void graphics_draw_line(uint32_t x1, uint32_t y1, uint32_t x2, uint32_t y2, color_t color);
 void graphics_draw_circle(uint32_t x, uint32_t y, uint32_t radius, color_t color);
 
@@ -0,0 +1,38 @@
+/*
+ * Framebuffer Console
+ * Text output on the linear framebuffer, for boots without VGA text mode
+ *
+ * A grid of character cells is what callers write to; the pixels only
+ * catch up in fbcon_flush(), which draws just the cells that differ
+ * from what is on screen. Scrolling moves the framebuffer's pixel rows
+ * up one text row, so only the new bottom row is drawn afterwards.
+ * Colours are the 16 VGA text colours, so code that drives <vga.h> can
+ * drive this the same way.
+ */
+
+#ifndef FBCON_H
+#define FBCON_H
+
+#include <kernel/kernel.h>
+#include <vga.h>
+
+/* ===== CONFIGURATION ===== */
+#define FBCON_MAX_COLS      240     /* 1920 pixels of 8x8 glyphs */
+#define FBCON_MAX_ROWS      135
+
+/* ===== CELLS ===== */
+typedef struct {
+    uint8_t ch;
+    uint8_t attr;                   /* Background << 4 | foreground, as in VGA text */
+} fbcon_cell_t;
+
+/* ===== FBCON FUNCTIONS ===== */
+int fbcon_init(void);               /* From bootinfo; needs a 32 bpp framebuffer */
+bool fbcon_ready(void);
+void fbcon_set_color(vga_color_t fg, vga_color_t bg);
+void fbcon_clear(void);
+void fbcon_putchar(char c);
+void fbcon_write(const char *str);  /* One flush for the whole string */
+void fbcon_flush(void);
+
+#endif /* FBCON_H */
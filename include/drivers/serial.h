@@ -0,0 +1,53 @@
+/*
+ * Serial Port Driver
+ * Interrupt-driven 16550 UART on COM1, used as the headless log console
+ *
+ * Output is queued in a TX ring and moved into the UART's 16-byte FIFO
+ * from the THRE interrupt, so writers only copy bytes. Until
+ * serial_enable_interrupts() has run, and whenever the ring is full,
+ * the writer feeds the FIFO itself. After serial_panic() every call
+ * polls the UART directly and takes no lock.
+ */
+
+#ifndef SERIAL_H
+#define SERIAL_H
+
+#include <kernel/kernel.h>
+
+/* ===== PORTS ===== */
+#define SERIAL_COM1         0x3F8
+#define SERIAL_BAUD         115200
+
+/* 16550 registers, as offsets from the base port */
+#define SERIAL_DATA         0   /* DLAB=0: RX/TX buffer; DLAB=1: divisor low */
+#define SERIAL_IER          1   /* DLAB=0: interrupt enable; DLAB=1: divisor high */
+#define SERIAL_IIR          2   /* Read: interrupt identification */
+#define SERIAL_FCR          2   /* Write: FIFO control */
+#define SERIAL_LCR          3
+#define SERIAL_MCR          4
+#define SERIAL_LSR          5
+#define SERIAL_MSR          6
+
+#define SERIAL_IER_THRE     0x02    /* Interrupt when the transmit FIFO empties */
+#define SERIAL_IIR_NONE     0x01    /* No interrupt pending */
+#define SERIAL_IIR_FIFO     0xC0    /* Both set: FIFOs work (16550A) */
+#define SERIAL_FCR_ENABLE   0xC7    /* Enable and clear FIFOs, RX trigger at 14 */
+#define SERIAL_LCR_8N1      0x03
+#define SERIAL_LCR_DLAB     0x80
+#define SERIAL_MCR_OUT2     0x08    /* Routes the UART interrupt to the PIC */
+#define SERIAL_LSR_THRE     0x20    /* Transmit holding register (FIFO) empty */
+#define SERIAL_LSR_TEMT     0x40    /* FIFO and shift register both empty */
+
+#define SERIAL_FIFO_SIZE    16
+#define SERIAL_TX_RING      16384   /* Power of two */
+
+/* ===== SERIAL FUNCTIONS ===== */
+void serial_init(void);
+void serial_enable_interrupts(void);    /* After irq_init() */
+bool serial_ready(void);            /* A UART answered during serial_init() */
+void serial_putc(char c);
+void serial_write(const char *str); /* Expands \n to \r\n */
+void serial_flush(void);            /* Wait until every queued byte has left the UART */
+void serial_panic(void);            /* Lock-free polled output from now on (kernel_panic) */
+
+#endif /* SERIAL_H */
@@ -3,6 +3,21 @@
 
 #include <stdint.h>
 
+/* 8x8 glyphs for printable ASCII; font_bitmap[0] is ' ' (32) */
+#define FONT_WIDTH  8
+#define FONT_HEIGHT 8
+#define FONT_FIRST  32
+#define FONT_LAST   127
+
+extern const uint8_t font_bitmap[128][FONT_HEIGHT];
+
+/* Rows top first, leftmost pixel in bit 7; anything unprintable is blank */
+static inline const uint8_t *font_glyph(char c) {
+    unsigned char uc = (unsigned char)c;
+    if (uc < FONT_FIRST || uc > FONT_LAST) uc = ' ';
+    return font_bitmap[uc - FONT_FIRST];
+}
+
 void font_draw_char(uint32_t x, uint32_t y, char c, uint32_t fg_color, uint32_t bg_color);
 void font_draw_string(uint32_t x, uint32_t y, const char *str, uint32_t fg_color, uint32_t bg_color);
 
@@ -0,0 +1,38 @@
+/*
+ * Local APIC
+ * Inter-processor interrupts and end-of-interrupt for APIC vectors
+ *
+ * Only what cross-CPU TLB shootdowns and the profiler need: the xAPIC
+ * register page is reached through the direct map, IPIs and NMIs go to
+ * one physical APIC ID. Legacy IRQs still come through the 8259 (see
+ * <kernel/idt.h>) and are acknowledged there.
+ */
+
+#ifndef APIC_H
+#define APIC_H
+
+#include <kernel/kernel.h>
+
+/* ===== REGISTERS ===== */
+#define MSR_APIC_BASE           0x1B
+#define APIC_BASE_ENABLE        (1ULL << 11)
+
+#define LAPIC_ID                0x020
+#define LAPIC_EOI               0x0B0
+#define LAPIC_SVR               0x0F0
+#define LAPIC_ICR_LOW           0x300
+#define LAPIC_ICR_HIGH          0x310
+
+#define LAPIC_SVR_ENABLE        0x100
+#define LAPIC_ICR_NMI           (4U << 8)   /* Delivery mode; the vector field is ignored */
+#define LAPIC_ICR_PENDING       (1U << 12)
+
+/* ===== APIC FUNCTIONS ===== */
+/* Per CPU during SMP bring-up, once the direct map is up; no IPIs before that */
+void lapic_init(void);          /* Enable this CPU's APIC, record its ID in cpu_local_t */
+bool lapic_ready(void);
+void lapic_send_ipi(uint32_t apic_id, uint8_t vector);
+void lapic_send_nmi(uint32_t apic_id);
+void lapic_eoi(void);
+
+#endif /* APIC_H */
@@ -0,0 +1,49 @@
+/*
+ * In-Kernel Benchmarks
+ * Micro-benchmark registry and machine-parsable result reporting
+ *
+ * Every result is logged as one line:
+ *     BENCH <suite>.<metric> <value> <unit>
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <kernel/kernel.h>
+
+/* ===== REGISTRY ===== */
+typedef struct {
+    const char *name;
+    const char *description;
+    void (*run)(void);
+} bench_suite_t;
+
+/* Run one suite by name, or every suite when name is NULL/empty */
+int bench_run(const char *name);
+void bench_list(void);
+
+/*
+ * Headless boot mode (make BENCH=1): run every suite, log "BENCH done"
+ * and power QEMU off through its isa-debug-exit device.
+ */
+#define BENCH_EXIT_PORT 0xF4
+
+void bench_boot(void) __attribute__((noreturn));
+
+/* ===== REPORTING ===== */
+void bench_report(const char *suite, const char *metric, uint64_t value, const char *unit);
+
+/* ===== SUITES ===== */
+void bench_fork(void);
+void bench_syscall(void);
+void bench_ipc(void);
+void bench_sched_scan(void);
+void bench_rt_latency(void);
+void bench_sched(void);
+void bench_uring(void);
+void bench_as_switch(void);
+void bench_pagefault(void);
+void bench_fb_fill(void);
+void bench_fill_rect(void);
+
+#endif /* BENCH_H */
@@ -0,0 +1,109 @@
+/*
+ * CPU Intrinsics
+ * Thin wrappers around x86-64 instructions used by the kernel
+ */
+
+#ifndef CPU_H
+#define CPU_H
+
+#include <stdint.h>
+
+/* ===== TIME STAMP COUNTER ===== */
+static inline uint64_t rdtsc(void) {
+    uint32_t lo, hi;
+    __asm__ volatile("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+/* ===== SPIN-WAIT HINT ===== */
+static inline void cpu_relax(void) {
+    __asm__ volatile("pause" ::: "memory");
+}
+
+/* ===== PORT I/O ===== */
+static inline void outb(uint16_t port, uint8_t value) {
+    __asm__ volatile("outb %0, %1" :: "a"(value), "Nd"(port));
+}
+
+static inline void outw(uint16_t port, uint16_t value) {
+    __asm__ volatile("outw %0, %1" :: "a"(value), "Nd"(port));
+}
+
+static inline uint8_t inb(uint16_t port) {
+    uint8_t value;
+    __asm__ volatile("inb %1, %0" : "=a"(value) : "Nd"(port));
+    return value;
+}
+
+/* ===== MODEL-SPECIFIC REGISTERS ===== */
+#define MSR_EFER            0xC0000080
+#define MSR_GS_BASE         0xC0000101
+#define MSR_KERNEL_GS_BASE  0xC0000102
+#define MSR_PAT             0x00000277
+#define EFER_NXE            (1ULL << 11)
+
+static inline uint64_t rdmsr(uint32_t msr) {
+    uint32_t lo, hi;
+    __asm__ volatile("rdmsr" : "=a"(lo), "=d"(hi) : "c"(msr));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static inline void wrmsr(uint32_t msr, uint64_t value) {
+    __asm__ volatile("wrmsr" :: "c"(msr), "a"((uint32_t)value),
+                     "d"((uint32_t)(value >> 32)));
+}
+
+/* ===== CPUID ===== */
+#define CPUID_1_ECX_PCID        (1U << 17)
+#define CPUID_1_EDX_PGE         (1U << 13)
+#define CPUID_1_EDX_PAT         (1U << 16)
+#define CPUID_EXT_EDX_PAGE1GB   (1U << 26)  /* Leaf 0x80000001 */
+
+static inline void cpuid(uint32_t leaf, uint32_t *eax, uint32_t *ebx,
+                         uint32_t *ecx, uint32_t *edx) {
+    __asm__ volatile("cpuid" : "=a"(*eax), "=b"(*ebx), "=c"(*ecx), "=d"(*edx)
+                     : "a"(leaf), "c"(0));
+}
+
+/* ===== CONTROL REGISTERS & TLB ===== */
+#define CR4_PGE             (1ULL << 7)
+#define CR4_PCIDE           (1ULL << 17)
+#define CR3_PCID_MASK       0xFFFULL
+#define CR3_NOFLUSH         (1ULL << 63)    /* With CR4.PCIDE: keep the PCID's TLB entries */
+#define RFLAGS_IF           (1ULL << 9)
+
+static inline uint64_t read_cr4(void) {
+    uint64_t value;
+    __asm__ volatile("mov %%cr4, %0" : "=r"(value));
+    return value;
+}
+
+static inline void write_cr4(uint64_t value) {
+    __asm__ volatile("mov %0, %%cr4" :: "r"(value) : "memory");
+}
+
+static inline uint64_t read_cr2(void) {
+    uint64_t value;
+    __asm__ volatile("mov %%cr2, %0" : "=r"(value));
+    return value;
+}
+
+static inline uint64_t read_cr3(void) {
+    uint64_t value;
+    __asm__ volatile("mov %%cr3, %0" : "=r"(value));
+    return value;
+}
+
+static inline void write_cr3(uint64_t value) {
+    __asm__ volatile("mov %0, %%cr3" :: "r"(value) : "memory");
+}
+
+static inline void wbinvd(void) {
+    __asm__ volatile("wbinvd" ::: "memory");
+}
+
+static inline void invlpg(uint64_t addr) {
+    __asm__ volatile("invlpg (%0)" :: "r"(addr) : "memory");
+}
+
+#endif /* CPU_H */
@@ -0,0 +1,84 @@
+/*
+ * ELF64 Program Loader
+ * Maps PT_LOAD segments of an in-memory image for demand paging
+ */
+
+#ifndef ELF_H
+#define ELF_H
+
+#include <kernel/kernel.h>
+#include <kernel/vmm.h>
+
+/* ===== ELF64 FILE FORMAT ===== */
+#define ELF_MAGIC       0x464C457FU  /* "\x7FELF" little-endian */
+#define ELFCLASS64      2
+#define ELFDATA2LSB     1
+#define ET_EXEC         2
+#define EM_X86_64       62
+
+#define PT_LOAD         1
+
+#define PF_X            0x1
+#define PF_W            0x2
+#define PF_R            0x4
+
+typedef struct {
+    uint32_t e_magic;
+    uint8_t  e_class;
+    uint8_t  e_data;
+    uint8_t  e_version_ident;
+    uint8_t  e_osabi;
+    uint8_t  e_pad[8];
+    uint16_t e_type;
+    uint16_t e_machine;
+    uint32_t e_version;
+    uint64_t e_entry;
+    uint64_t e_phoff;
+    uint64_t e_shoff;
+    uint32_t e_flags;
+    uint16_t e_ehsize;
+    uint16_t e_phentsize;
+    uint16_t e_phnum;
+    uint16_t e_shentsize;
+    uint16_t e_shnum;
+    uint16_t e_shstrndx;
+} __attribute__((packed)) elf64_ehdr_t;
+
+typedef struct {
+    uint32_t p_type;
+    uint32_t p_flags;
+    uint64_t p_offset;
+    uint64_t p_vaddr;
+    uint64_t p_paddr;
+    uint64_t p_filesz;
+    uint64_t p_memsz;
+    uint64_t p_align;
+} __attribute__((packed)) elf64_phdr_t;
+
+/* ===== LOAD RESULT ===== */
+typedef struct {
+    vaddr_t entry;
+    vaddr_t code_start;     /* Executable segments */
+    vaddr_t code_end;
+    vaddr_t data_start;     /* Non-executable segments, including .bss */
+    vaddr_t data_end;
+    vaddr_t stack_start;
+    vaddr_t stack_end;
+} elf_image_t;
+
+typedef enum {
+    ELF_OK = 0,
+    ELF_ERR_FORMAT = -1,    /* Not a loadable x86-64 ELF64 executable */
+    ELF_ERR_SEGMENT = -2,   /* Segment out of bounds or outside user space */
+    ELF_ERR_MAP = -3,       /* Overlapping segments or too many areas */
+} elf_result_t;
+
+/*
+ * Describe the image's PT_LOAD segments as demand-paged areas of as.
+ * Nothing is copied: pages are filled from the image on first touch and
+ * .bss reads share the zero page. The image must stay resident for the
+ * lifetime of the address space.
+ */
+elf_result_t elf_load(address_space_t *as, const void *image, size_t size, elf_image_t *out);
+
+#endif /* ELF_H */
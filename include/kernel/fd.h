@@ -0,0 +1,71 @@
+/*
+ * File Descriptor Tables
+ * Per-process, growable fd -> open file maps with lock-free lookup
+ *
+ * The slot array starts small and doubles on demand. Lookups read the
+ * published array with acquire loads and take no lock (RCU-style);
+ * allocation, close and growth serialize on the table lock. A grown
+ * array replaces the old one with a single pointer store, and old
+ * arrays are kept until the table is destroyed so a concurrent reader
+ * never touches freed memory. Doubling bounds that overhead to the
+ * size of the current array.
+ */
+
+#ifndef FD_H
+#define FD_H
+
+#include <kernel/kernel.h>
+
+/* ===== CONFIGURATION ===== */
+#define FD_INITIAL_CAPACITY 16
+#define FD_MAX_FILES        65536
+
+/* ===== OPEN FILES =====
+ * What every descriptor slot points at. A file that lacks an operation
+ * rejects it.
+ */
+struct file;
+
+typedef struct file_ops {
+    int64_t (*read)(struct file *file, uint64_t offset, void *buffer, uint64_t size);
+    int64_t (*write)(struct file *file, uint64_t offset, const void *buffer, uint64_t size);
+} file_ops_t;
+
+typedef struct file {
+    const file_ops_t *ops;
+    void *private_data;
+    uint64_t offset;            /* Used when a request asks for the current position */
+} file_t;
+
+/* ===== TABLE ===== */
+typedef struct fd_array {
+    uint32_t capacity;
+    struct fd_array *retired;   /* Previous (smaller) array, still readable */
+    uint64_t *bitmap;           /* Bit set = fd in use; writers only */
+    file_t *files[];            /* capacity slots */
+} fd_array_t;
+
+typedef struct fd_table {
+    fd_array_t *array;          /* Published with release stores */
+    uint32_t count;             /* Open descriptors */
+    uint32_t first_free_word;   /* No free bit in bitmap words below this */
+    spinlock_t lock;            /* Writers only */
+} fd_table_t;
+
+/* ===== LOOKUP (lock-free) ===== */
+static inline file_t *fd_get(fd_table_t *table, int fd) {
+    fd_array_t *array = __atomic_load_n(&table->array, __ATOMIC_ACQUIRE);
+    if ((uint32_t)fd >= array->capacity) return NULL;
+    return __atomic_load_n(&array->files[fd], __ATOMIC_ACQUIRE);
+}
+
+/* ===== TABLE FUNCTIONS ===== */
+fd_table_t *fd_table_create(void);
+void fd_table_destroy(fd_table_t *table);
+void fd_table_clear(fd_table_t *table);                 /* Close everything, keep the arrays */
+int fd_table_copy(fd_table_t *dst, fd_table_t *src);    /* dst must be empty (fork) */
+
+int fd_alloc(fd_table_t *table, file_t *file);          /* Lowest free fd, or -1 */
+file_t *fd_close(fd_table_t *table, int fd);            /* Returns what the slot held */
+
+#endif /* FD_H */
@@ -0,0 +1,43 @@
+/*
+ * Global Descriptor Table & Task State Segment
+ * Segment selectors for ring 0/3 and the per-CPU TSS
+ */
+
+#ifndef GDT_H
+#define GDT_H
+
+#include <kernel/kernel.h>
+
+/*
+ * ===== SEGMENT SELECTORS =====
+ *
+ * The order is fixed by SYSCALL/SYSRET: SYSCALL loads CS from
+ * STAR[47:32] and SS = CS + 8; SYSRET (64-bit) loads SS from
+ * STAR[63:48] + 8 and CS from STAR[63:48] + 16.
+ */
+#define GDT_KERNEL_CODE     0x08
+#define GDT_KERNEL_DATA     0x10
+#define GDT_USER_DATA       0x18
+#define GDT_USER_CODE       0x20
+#define GDT_TSS             0x28    /* 16-byte system descriptor */
+
+#define GDT_RPL_USER        3
+#define USER_CS             (GDT_USER_CODE | GDT_RPL_USER)
+#define USER_DS             (GDT_USER_DATA | GDT_RPL_USER)
+
+/* ===== TASK STATE SEGMENT ===== */
+typedef struct __attribute__((packed)) {
+    uint32_t reserved0;
+    uint64_t rsp[3];        /* Stack loaded on a privilege change to ring N */
+    uint64_t reserved1;
+    uint64_t ist[7];        /* Interrupt stack table, IST1..IST7 */
+    uint64_t reserved2;
+    uint16_t reserved3;
+    uint16_t iomap_base;
+} tss_t;
+
+/* ===== GDT FUNCTIONS ===== */
+void gdt_init(void);
+void gdt_set_kernel_stack(uint64_t rsp0);   /* Stack for interrupts taken in ring 3 */
+
+#endif /* GDT_H */
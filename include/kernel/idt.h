@@ -0,0 +1,114 @@
+/*
+ * Interrupt Descriptor Table & IRQ Dispatch
+ * Entry stubs, handler registration and per-vector counters
+ *
+ * Every vector has an assembly stub that pushes the vector number (and
+ * a zero where the CPU pushes no error code), saves only the registers
+ * the C ABI lets a handler clobber, and calls idt_dispatch(). Handlers
+ * therefore see the caller-saved registers in interrupt_frame_t and must
+ * not expect the callee-saved ones there.
+ */
+
+#ifndef IDT_H
+#define IDT_H
+
+#include <kernel/kernel.h>
+#include <kernel/cpu.h>
+
+/* ===== VECTORS ===== */
+#define IDT_VECTORS         256
+#define IDT_EXCEPTIONS      32
+
+#define VEC_DIVIDE          0
+#define VEC_DEBUG           1
+#define VEC_NMI             2
+#define VEC_BREAKPOINT      3
+#define VEC_INVALID_OPCODE  6
+#define VEC_DOUBLE_FAULT    8
+#define VEC_GP_FAULT        13
+#define VEC_PAGE_FAULT      14
+#define VEC_MACHINE_CHECK   18
+
+#define IRQ_BASE            32      /* Legacy PIC IRQ 0-15 are remapped here */
+#define IRQ_COUNT           16
+#define IRQ_TIMER           0
+#define IRQ_KEYBOARD        1
+#define IRQ_CASCADE         2
+#define IRQ_COM1            4
+#define IRQ_MOUSE           12
+
+/* Local APIC vectors (see <kernel/apic.h>), above every device IRQ */
+#define VEC_TLB_SHOOTDOWN   0xF0
+#define VEC_APIC_SPURIOUS   0xFF
+
+/* Interrupt stack table slots (1-based, as in the gate descriptor) */
+#define IST_NMI             1
+#define IST_DOUBLE_FAULT    2
+#define IST_MACHINE_CHECK   3
+#define IST_STACK_SIZE      4096
+
+/* ===== INTERRUPT FRAME =====
+ * Lowest address first: the stub's pushes, then what the CPU pushed.
+ */
+typedef struct {
+    uint64_t r11, r10, r9, r8;
+    uint64_t rdi, rsi, rdx, rcx, rax;
+    uint64_t vector;
+    uint64_t error;                 /* 0 for vectors without an error code */
+    uint64_t rip, cs, rflags, rsp, ss;
+} interrupt_frame_t;
+
+typedef void (*interrupt_handler_t)(interrupt_frame_t *frame);
+
+/* Return address of the stubs' call into idt_dispatch(), for unwinders */
+extern const uint8_t idt_return[];
+
+static inline bool interrupt_from_user(const interrupt_frame_t *frame) {
+    return (frame->cs & 3) != 0;
+}
+
+/* ===== PER-VECTOR COUNTERS ===== */
+typedef struct {
+    uint64_t count;
+    uint64_t cycles;                /* TSC cycles spent in idt_dispatch() */
+} idt_vector_stats_t;
+
+/* ===== IDT FUNCTIONS ===== */
+/* idt_init() itself is declared in <memory.h> */
+int idt_register_handler(uint32_t vector, interrupt_handler_t handler);
+const idt_vector_stats_t *idt_get_stats(uint32_t vector);
+void idt_reset_stats(void);
+
+static inline void interrupts_enable(void) {
+    __asm__ volatile("sti" ::: "memory");
+}
+
+static inline void interrupts_disable(void) {
+    __asm__ volatile("cli" ::: "memory");
+}
+
+/* Disable, returning RFLAGS for interrupts_restore() */
+static inline uint64_t interrupts_save(void) {
+    uint64_t flags;
+    __asm__ volatile("pushfq\n\tpopq %0\n\tcli" : "=r"(flags) :: "memory");
+    return flags;
+}
+
+static inline void interrupts_restore(uint64_t flags) {
+    if (flags & RFLAGS_IF) {
+        interrupts_enable();
+    }
+}
+
+/* ===== IRQ FUNCTIONS ===== */
+#define IRQ_TIMER_HZ        1000
+
+typedef void (*irq_handler_t)(uint32_t irq);
+
+void irq_init(void);                /* Remap the PIC, exception reporting, timer */
+int irq_register(uint32_t irq, irq_handler_t handler);     /* Also unmasks the line */
+void irq_mask(uint32_t irq);
+void irq_unmask(uint32_t irq);
+void irq_dump_stats(void);
+
+#endif /* IDT_H */
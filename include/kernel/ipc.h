@@ -0,0 +1,153 @@
+/*
+ * Inter-Process Communication
+ * Shared-memory single-producer/single-consumer message rings
+ *
+ * A channel is one header page followed by a power-of-two data area,
+ * mapped at the same layout into the producer and the consumer. The
+ * producer builds each message in place inside the ring and the
+ * consumer reads it in place, so payloads never pass through the
+ * kernel. The kernel is entered only to map a channel and, when the
+ * consumer has gone to sleep on an empty ring, to ring its doorbell.
+ */
+
+#ifndef IPC_H
+#define IPC_H
+
+#include <kernel/kernel.h>
+#include <kernel/vmm.h>
+
+/* ===== CONFIGURATION ===== */
+#define IPC_MAX_CHANNELS    32
+#define IPC_RING_HEADER     PAGE_SIZE
+#define IPC_MIN_RING_SIZE   PAGE_SIZE
+#define IPC_MAX_RING_SIZE   (1024 * 1024)
+
+/* ===== MESSAGE FORMAT ===== */
+#define IPC_MSG_ALIGN       8
+#define IPC_MSG_PAD         0x1     /* Filler up to the end of the data area */
+
+typedef struct {
+    uint32_t length;                /* Payload bytes */
+    uint32_t flags;
+} ipc_msg_header_t;
+
+/* ===== SHARED RING HEADER ===== */
+typedef struct {
+    /* Written by the producer only */
+    volatile uint64_t head __attribute__((aligned(64)));   /* Bytes published */
+    uint64_t reserved_end;                                 /* End of the open reservation */
+
+    /* Written by the consumer only */
+    volatile uint64_t tail __attribute__((aligned(64)));   /* Bytes consumed */
+    volatile uint32_t consumer_waiting;                    /* Asleep on an empty ring */
+
+    /* Set up by the kernel */
+    uint64_t data_size __attribute__((aligned(64)));       /* Power of two */
+    volatile uint64_t doorbell;                            /* Bumped by each ipc_notify() */
+} ipc_ring_t;
+
+static inline uint8_t *ipc_ring_data(ipc_ring_t *ring) {
+    return (uint8_t *)ring + IPC_RING_HEADER;
+}
+
+static inline uint64_t ipc_msg_size(uint32_t length) {
+    return sizeof(ipc_msg_header_t) + ((length + IPC_MSG_ALIGN - 1) & ~(uint64_t)(IPC_MSG_ALIGN - 1));
+}
+
+/* ===== PRODUCER ===== */
+/* Space for a length-byte message, to be filled in place; NULL if full */
+static inline void *ipc_ring_reserve(ipc_ring_t *ring, uint32_t length) {
+    uint64_t size = ipc_msg_size(length);
+    uint64_t head = ring->head;
+    uint64_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    uint64_t offset = head & (ring->data_size - 1);
+    uint64_t to_end = ring->data_size - offset;
+
+    /* Messages never wrap: skip the tail end of the data area if needed */
+    uint64_t needed = size + (to_end < size ? to_end : 0);
+    if (needed > ring->data_size - (head - tail)) return NULL;
+
+    uint8_t *data = ipc_ring_data(ring);
+    if (to_end < size) {
+        ipc_msg_header_t *pad = (ipc_msg_header_t *)(data + offset);
+        pad->length = (uint32_t)(to_end - sizeof(ipc_msg_header_t));
+        pad->flags = IPC_MSG_PAD;
+        head += to_end;
+        offset = 0;
+    }
+
+    ipc_msg_header_t *msg = (ipc_msg_header_t *)(data + offset);
+    msg->length = length;
+    msg->flags = 0;
+    ring->reserved_end = head + size;
+    return msg + 1;
+}
+
+/* Publish the reserved message; true if the consumer needs ipc_notify() */
+static inline bool ipc_ring_commit(ipc_ring_t *ring) {
+    __atomic_store_n(&ring->head, ring->reserved_end, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);  /* Pairs with ipc_ring_prepare_wait() */
+    return __atomic_load_n(&ring->consumer_waiting, __ATOMIC_RELAXED) != 0;
+}
+
+/* ===== CONSUMER ===== */
+/* Oldest message, read in place; NULL if empty */
+static inline const void *ipc_ring_peek(ipc_ring_t *ring, uint32_t *length) {
+    uint64_t tail = ring->tail;
+    uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint8_t *data = ipc_ring_data(ring);
+
+    while (tail != head) {
+        ipc_msg_header_t *msg = (ipc_msg_header_t *)(data + (tail & (ring->data_size - 1)));
+        if (!(msg->flags & IPC_MSG_PAD)) {
+            *length = msg->length;
+            return msg + 1;
+        }
+        tail += sizeof(ipc_msg_header_t) + msg->length;
+        __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+/* Hand the peeked message's space back to the producer */
+static inline void ipc_ring_release(ipc_ring_t *ring, uint32_t length) {
+    __atomic_store_n(&ring->tail, ring->tail + ipc_msg_size(length), __ATOMIC_RELEASE);
+}
+
+/* Announce sleep; false if a message raced in and the caller must not wait */
+static inline bool ipc_ring_prepare_wait(ipc_ring_t *ring) {
+    __atomic_store_n(&ring->consumer_waiting, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) != ring->tail) {
+        __atomic_store_n(&ring->consumer_waiting, 0, __ATOMIC_RELAXED);
+        return false;
+    }
+    return true;
+}
+
+/* ===== CHANNEL HANDLES =====
+ *
+ * A handle names one channel and carries a random key, so it acts as
+ * a capability: only holders can map it. Each end can be bound once.
+ */
+typedef uint64_t ipc_handle_t;
+
+#define IPC_INVALID_HANDLE  0
+
+typedef enum {
+    IPC_END_PRODUCER = 0,
+    IPC_END_CONSUMER = 1,
+} ipc_end_t;
+
+/* ===== KERNEL FUNCTIONS ===== */
+void ipc_init(void);
+ipc_handle_t ipc_channel_create(uint64_t data_size);
+int ipc_channel_map(ipc_handle_t handle, address_space_t *as, vaddr_t addr,
+                    ipc_end_t end, kpid_t owner);
+ipc_ring_t *ipc_channel_ring(ipc_handle_t handle);  /* Kernel view of the ring */
+void ipc_channel_close(ipc_handle_t handle);
+
+int ipc_notify(ipc_handle_t handle);                /* Wake a sleeping consumer */
+int ipc_wait(ipc_handle_t handle, kpid_t pid);      /* Sleep until notified (if still empty) */
+
+#endif /* IPC_H */
@@ -33,9 +33,11 @@ typedef uint32_t gid_t;    /* Group ID */
 void kernel_panic(const char *format, ...) __attribute__((noreturn));
 void kernel_warn(const char *format, ...);
 void kernel_log(const char *level, const char *format, ...);
+void kernel_log_mute(bool muted);  /* Drop KINFO/KDEBUG (e.g. inside benchmark loops) */
+void kernel_console_detach(void);  /* The framebuffer belongs to the WM now; panics still draw */
 
 #define KPANIC(fmt, ...) kernel_panic("[PANIC] " fmt, ##__VA_ARGS__)
-#define KWARN(fmt, ...)  kernel_warn("[WARN] " fmt, ##__VA_ARGS__)
+#define KWARN(fmt, ...)  kernel_warn(fmt, ##__VA_ARGS__)
 #define KINFO(fmt, ...)  kernel_log("INFO", fmt, ##__VA_ARGS__)
 #define KDEBUG(fmt, ...) kernel_log("DEBUG", fmt, ##__VA_ARGS__)
 
@@ -50,24 +52,57 @@ typedef enum {
 extern kernel_state_t kernel_state;
 
 /* ===== BOOT INFORMATION ===== */
+#define BOOT_MAX_REGIONS    64      /* Usable memory map entries past this are ignored */
+
+typedef struct {
+    paddr_t base;
+    uint64_t length;
+} boot_region_t;
+
 struct boot_info {
     uint64_t memory_size;
     uint64_t usable_memory;
     uint32_t num_cpus;
+    uint64_t phys_offset;           /* Where the bootloader maps all physical memory (Limine's HHDM) */
     vaddr_t framebuffer;
     uint32_t framebuffer_width;
     uint32_t framebuffer_height;
     uint32_t framebuffer_pitch;
     uint32_t framebuffer_bpp;
+    paddr_t phys_top;                           /* End of the highest memory map entry, any type */
+    boot_region_t usable[BOOT_MAX_REGIONS];     /* RAM the PMM may hand out */
+    uint32_t num_usable;
 };
 
 extern struct boot_info bootinfo;
 
 /* ===== SPINLOCK (Basic synchronization) ===== */
+struct lockstat_site;
+
 typedef struct {
     volatile uint32_t locked;
+#ifdef CONFIG_LOCKSTAT
+    const char *name;                   /* Set by spinlock_init() */
+    uint64_t acquired_at;               /* TSC when the current holder got it */
+    struct lockstat_site *holder_site;  /* Acquire site of the current holder */
+#endif
 } spinlock_t;
 
+#ifdef CONFIG_LOCKSTAT
+/*
+ * Lockstat build (make LOCKSTAT=1): every acquisition is accounted to
+ * its lock name and call site. See <kernel/lockstat.h>.
+ */
+void lockstat_lock_init(spinlock_t *lock, const char *name);
+void lockstat_acquire(spinlock_t *lock, const char *file, int line);
+bool lockstat_try_acquire(spinlock_t *lock, const char *file, int line);
+void lockstat_release(spinlock_t *lock);
+
+#define spinlock_init(lock)    lockstat_lock_init((lock), #lock)
+#define spinlock_acquire(lock) lockstat_acquire((lock), __FILE__, __LINE__)
+#define spinlock_try_acquire(lock) lockstat_try_acquire((lock), __FILE__, __LINE__)
+#define spinlock_release(lock) lockstat_release(lock)
+#else
 static inline void spinlock_init(spinlock_t *lock) {
     lock->locked = 0;
 }
@@ -78,9 +113,15 @@ static inline void spinlock_acquire(spinlock_t *lock) {
     }
 }
 
+/* Never spins: false if the lock is held, e.g. by the code an interrupt cut into */
+static inline bool spinlock_try_acquire(spinlock_t *lock) {
+    return !__atomic_test_and_set(&lock->locked, __ATOMIC_ACQUIRE);
+}
+
 static inline void spinlock_release(spinlock_t *lock) {
     __atomic_clear(&lock->locked, __ATOMIC_RELEASE);
 }
+#endif /* CONFIG_LOCKSTAT */
 
 /* ===== ASSERT MACROS ===== */
 #define KASSERT(cond) \
@@ -0,0 +1,63 @@
+/*
+ * Kernel Log Ring
+ * Lock-free per-CPU log records, drained to the console in batches
+ *
+ * kernel_log() formats straight into a slot of the calling CPU's ring
+ * and returns; no lock is taken and nothing is printed. Whoever drains
+ * (the klogd thread once klog_start() has run, the logging CPU itself
+ * before that) merges the rings in timestamp order and hands each
+ * record to the registered sinks. The rings are plain static memory:
+ * after a panic they can still be replayed, or read from a debugger
+ * through klog_rings.
+ */
+
+#ifndef KLOG_H
+#define KLOG_H
+
+#include <kernel/kernel.h>
+#include <stdarg.h>
+
+/* ===== CONFIGURATION ===== */
+#define KLOG_RINGS          8       /* CPUs past this share a ring (cpu_id % KLOG_RINGS) */
+#define KLOG_RING_SLOTS     64      /* Power of two */
+#define KLOG_TEXT_MAX       228     /* Longer lines are cut */
+#define KLOG_DRAIN_MS       10      /* klogd polling period */
+
+/* ===== RECORDS ===== */
+typedef struct {
+    uint64_t seq;                   /* Position + 1 once committed, 0 while being written */
+    uint64_t tsc;
+    const char *level;              /* "INFO", "DEBUG", "WARN", "FAULT", ... */
+    uint16_t cpu;
+    uint16_t len;
+    char text[KLOG_TEXT_MAX];
+} klog_record_t;
+
+_Static_assert(sizeof(klog_record_t) == 256, "klog_record_t is one 256-byte slot");
+
+typedef struct {
+    uint64_t head;                  /* Next position to reserve; producers only */
+    uint64_t tail;                  /* Next position to drain; drainer only */
+    uint64_t dropped;               /* Overwritten before they were drained */
+    klog_record_t slots[KLOG_RING_SLOTS];
+} __attribute__((aligned(64))) klog_ring_t;
+
+extern klog_ring_t klog_rings[KLOG_RINGS];
+
+typedef void (*klog_sink_t)(const klog_record_t *rec);
+
+/* ===== KLOG FUNCTIONS ===== */
+void klog_init(void);
+int klog_add_sink(klog_sink_t sink);
+int klog_remove_sink(klog_sink_t sink);
+int klog_start(void);               /* Hand draining to klogd; needs the scheduler */
+
+void klog_write(const char *level, const char *format, va_list args);
+size_t klog_vformat(char *buf, size_t size, const char *format, va_list args);
+size_t klog_format(char *buf, size_t size, const char *format, ...);
+void klog_flush(void);              /* Drain now, unless another CPU already is */
+
+void klog_panic(void);              /* Drain everything, ignoring any drainer that never returns */
+void klog_replay(uint32_t count, klog_sink_t sink);    /* Last count records, drained or not */
+
+#endif /* KLOG_H */
@@ -0,0 +1,27 @@
+/*
+ * Kernel Symbol Table
+ * Function addresses and names, embedded in the image at link time
+ *
+ * The Limine kernel is linked twice: `nm` lists the text symbols of the
+ * first link and the second adds them as a sorted table. .rodata follows
+ * .text, so the table does not move any code it describes. Without the
+ * second link (other build paths) the table is simply empty.
+ */
+
+#ifndef KSYMS_H
+#define KSYMS_H
+
+#include <kernel/kernel.h>
+
+typedef struct {
+    uint64_t addr;
+    const char *name;
+} ksym_t;
+
+extern const ksym_t ksyms[];        /* Sorted by address */
+extern const uint64_t ksyms_count;
+
+/* Function containing addr, with addr's offset into it; NULL if none */
+const char *ksym_lookup(uint64_t addr, uint64_t *offset);
+
+#endif /* KSYMS_H */
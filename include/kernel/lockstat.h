@@ -0,0 +1,37 @@
+/*
+ * Lock Contention Statistics (lockstat)
+ * Per lock-name / acquire-site accounting for spinlock_t
+ *
+ * Only collected when the kernel is built with LOCKSTAT=1
+ * (CONFIG_LOCKSTAT). In normal builds spinlock_t is unchanged and
+ * the dump/reset calls just report that lockstat is disabled.
+ */
+
+#ifndef LOCKSTAT_H
+#define LOCKSTAT_H
+
+#include <kernel/kernel.h>
+
+/* ===== CONFIGURATION ===== */
+#define LOCKSTAT_MAX_SITES 128
+
+/* ===== PER-SITE STATISTICS ===== */
+typedef struct lockstat_site {
+    const char *name;         /* Lock name given to spinlock_init() */
+    const char *file;         /* Acquire site */
+    int line;
+    volatile uint32_t ready;  /* Slot published */
+
+    uint64_t acquisitions;    /* Total acquisitions */
+    uint64_t contended;       /* Acquisitions that had to spin */
+    uint64_t wait_total;      /* Cycles spent spinning */
+    uint64_t wait_max;        /* Longest single spin */
+    uint64_t hold_max;        /* Longest hold (acquire -> release) */
+} lockstat_site_t;
+
+/* ===== REPORTING ===== */
+void lockstat_dump(void);
+void lockstat_reset(void);
+bool lockstat_enabled(void);
+
+#endif /* LOCKSTAT_H */
@@ -0,0 +1,99 @@
+/*
+ * Per-CPU Data
+ * One cpu_local_t per processor, reached through the GS segment base
+ *
+ * In the kernel IA32_GS_BASE points at the running CPU's block and
+ * IA32_KERNEL_GS_BASE holds the user GS; every kernel entry from ring
+ * 3 does swapgs first and every exit does it again. A field is then one
+ * gs:-relative instruction away (this_cpu_read/write/inc) with no
+ * lookup of the CPU number.
+ */
+
+#ifndef PERCPU_H
+#define PERCPU_H
+
+#include <kernel/kernel.h>
+#include <stddef.h>
+
+#define MAX_CPUS 64
+
+struct process;
+struct run_queue;
+struct address_space;
+
+/* ===== HOT COUNTERS =====
+ * Written on every event by the owning CPU only; kept on their own
+ * cache line so readers of the fields above don't share it.
+ */
+typedef struct {
+    uint64_t syscalls;
+    uint64_t context_switches;
+    uint64_t ticks;
+    uint64_t page_faults;           /* #PF taken here */
+    uint64_t fault_minor;           /* Resolved without reading backing data (zero page, zeroed frame) */
+    uint64_t fault_major;           /* Filled from a backing image */
+    uint64_t fault_cow;             /* First write to a copy-on-write page */
+    uint64_t fault_invalid;         /* No area, protection violation or out of memory */
+    uint64_t tlb_ipis;              /* Shootdown IPIs sent */
+    uint64_t tlb_pages;             /* Single pages invalidated here */
+    uint64_t tlb_full_flushes;      /* Whole-PCID flushes done here */
+} __attribute__((aligned(64))) cpu_stats_t;
+
+/* ===== PER-CPU BLOCK ===== */
+typedef struct cpu_local {
+    struct cpu_local *self;         /* Address of this block, for this_cpu_ptr() */
+    uint64_t kernel_rsp;            /* SYSCALL entry stack: the innermost syscall_run_user() frame */
+    uint64_t user_rsp;              /* Scratch for the SYSCALL stub */
+    struct process *current;        /* Running process */
+    struct run_queue *run_queue;
+    uint32_t cpu_id;
+    uint32_t need_resched;          /* Set by the tick, cleared by scheduler_switch() */
+    uint64_t boot_rsp;              /* Context that was running before any kernel thread */
+    uint64_t switch_tsc;            /* When the current thread was switched in */
+
+    cpu_stats_t stats;
+
+    /* Scheduler-private, touched only on a switch to or from the boot context */
+    uint64_t boot_kernel_rsp;       /* kernel_rsp of the boot context while a thread runs */
+
+    /* Read by other CPUs deciding whom to send a TLB shootdown */
+    struct address_space *active_as;    /* Loaded in CR3; NULL for the kernel tables */
+    uint32_t apic_id;
+} __attribute__((aligned(64))) cpu_local_t;
+
+/* Offsets used from assembly (checked in percpu.c) */
+#define PERCPU_SELF             0
+#define PERCPU_KERNEL_RSP       8
+#define PERCPU_USER_RSP         16
+#define PERCPU_STATS_SYSCALLS   64
+
+/* ===== ACCESSORS ===== */
+#define this_cpu_read(field) ({                                         \
+    __typeof__(((cpu_local_t *)0)->field) __val;                        \
+    __asm__ volatile("mov %%gs:%c1, %0"                                 \
+                     : "=r"(__val) : "i"(offsetof(cpu_local_t, field))); \
+    __val; })
+
+#define this_cpu_write(field, value) do {                               \
+    __typeof__(((cpu_local_t *)0)->field) __val = (value);              \
+    __asm__ volatile("mov %0, %%gs:%c1"                                 \
+                     :: "r"(__val), "i"(offsetof(cpu_local_t, field))   \
+                     : "memory");                                       \
+} while (0)
+
+/* 64-bit counters only */
+#define this_cpu_inc(field)                                             \
+    __asm__ volatile("incq %%gs:%c0"                                    \
+                     :: "i"(offsetof(cpu_local_t, field)) : "memory")
+
+static inline cpu_local_t *this_cpu_ptr(void) {
+    return this_cpu_read(self);
+}
+
+/* ===== PER-CPU FUNCTIONS ===== */
+void percpu_init(uint32_t cpu_id);          /* Point GS at this CPU's block */
+cpu_local_t *percpu_get(uint32_t cpu_id);
+uint32_t percpu_count(void);
+void percpu_dump_stats(void);
+
+#endif /* PERCPU_H */
@@ -18,15 +18,69 @@ typedef enum {
     PROCESS_STATE_TERMINATED,
 } process_state_t;
 
-/* ===== PROCESS STRUCTURE ===== */
-typedef struct process {
+/* ===== SCHEDULING ENTITY (hot) =====
+ *
+ * Everything the scheduler reads on a scan, one cache line per process,
+ * stored densely in the scheduler's table. The rest of the process lives
+ * in the cold process_t below and is only touched once a process has
+ * been picked.
+ */
+#define PROCESS_PRIORITY_DEFAULT 0
+
+/* Scheduling classes: any runnable SCHED_FIFO entity within its budget
+ * runs before every SCHED_NORMAL one */
+typedef enum {
+    SCHED_NORMAL = 0,
+    SCHED_FIFO = 1,
+} sched_policy_t;
+
+#define SCHED_F_CONTEXT 0x01    /* Has a kernel context the scheduler can switch to */
+
+typedef struct sched_entity {
     kpid_t pid;
+    process_state_t state;
+    int32_t priority;           /* Higher runs first, within a class */
+    uint64_t cpu_ticks;
+    struct process *process;    /* Cold descriptor */
+    
+    uint8_t policy;             /* sched_policy_t */
+    uint8_t flags;              /* SCHED_F_* */
+    uint16_t reserved;
+    uint32_t reserved2;
+    uint64_t runtime_budget;    /* SCHED_FIFO: cycles allowed per period */
+    uint64_t runtime_used;      /* Cycles used in the current period */
+    uint64_t period_end;        /* TSC at which the budget is replenished */
+} __attribute__((aligned(64))) sched_entity_t;
+
+/* ===== RUN QUEUE ===== */
+typedef struct run_queue {
+    sched_entity_t *entities;   /* Dense, [0, count) */
+    uint32_t count;
+    uint32_t last;              /* Index picked last: round-robin cursor */
+} run_queue_t;
+
+/* ===== PROCESS STRUCTURE (cold) ===== */
+typedef struct process {
+    sched_entity_t *sched;      /* Hot half; moves when the table is compacted */
+    kpid_t pid;                 /* Immutable copy of sched->pid */
     uid_t uid;
     gid_t gid;
     
-    char name[256];
-    process_state_t state;
+    uint64_t creation_time;
+    uint64_t exit_code;
+    
+    struct address_space *address_space;  /* Virtual->Physical mapping */
+    
+    // File descriptors (grows on demand, see <kernel/fd.h>)
+    struct fd_table *files;
+    struct uring *uring;        /* Batched submission ring, if set up */
     
+    // Child processes
+    kpid_t *children;
+    size_t num_children;
+    kpid_t parent_pid;
+    
+    vaddr_t entry_point;
     vaddr_t code_start;
     vaddr_t code_end;
     vaddr_t data_start;
@@ -36,25 +90,28 @@ typedef struct process {
     vaddr_t stack_start;
     vaddr_t stack_end;
     
-    uint64_t cpu_ticks;
-    uint64_t creation_time;
-    uint64_t exit_code;
-    
-    void *page_directory;  /* Virtual->Physical mapping */
-    
-    // File descriptors
-    void *open_files[256];
-    
-    // Child processes
-    kpid_t *children;
-    size_t num_children;
-    kpid_t parent_pid;
+    // Kernel execution context (kernel threads)
+    uint64_t context_rsp;       /* Saved by context_switch() */
+    uint64_t kernel_rsp;        /* Syscall entry stack while in ring 3 */
+    paddr_t kernel_stack;       /* Base frame of the stack, 0 if none */
+    uint64_t wake_at;           /* TSC deadline while sleeping */
+    uint64_t rt_period;         /* SCHED_FIFO replenish period, cycles */
     
+    char name[256];
 } process_t;
 
 /* ===== PROCESS MANAGEMENT ===== */
 kpid_t process_create(const char *name, vaddr_t entry_point, uid_t uid);
+kpid_t process_create_elf(const char *name, const void *image, size_t size, uid_t uid);
+kpid_t process_create_user(const char *name, struct address_space *as, vaddr_t entry,
+                           vaddr_t stack_start, vaddr_t stack_end, uid_t uid);
+kpid_t process_fork(kpid_t parent_pid);
+int process_start_user(kpid_t pid, uint64_t arg);  /* Ring 3 at entry_point/stack_end, arg in rdi */
 void process_exit(kpid_t pid, int exit_code);
+int process_reap(kpid_t pid, int *exit_code);
+int process_block(kpid_t pid);
+int process_block_if(kpid_t pid, bool (*should_wait)(void *arg), void *arg);  /* Tested under the table lock */
+int process_wake(kpid_t pid);
 process_t *process_get_current(void);
 process_t *process_get_by_pid(kpid_t pid);
 void process_list_all(void);
@@ -62,8 +119,26 @@ void process_list_all(void);
 /* ===== SCHEDULER ===== */
 void scheduler_init(void);
 void scheduler_tick(void);
-void scheduler_switch(void);
+void scheduler_switch(void);            /* Also the yield point for kernel threads */
 process_t *scheduler_next_process(void);
+sched_entity_t *scheduler_pick(sched_entity_t *table, uint32_t count, uint32_t start);
+void scheduler_sleep_until(uint64_t tsc);
+
+int sched_set_realtime(kpid_t pid, int32_t priority, uint64_t runtime_ns, uint64_t period_ns);
+int sched_set_normal(kpid_t pid);
+
+/* ===== KERNEL THREADS ===== */
+#define KTHREAD_STACK_PAGES 4
+
+typedef void (*kthread_fn_t)(void *arg);
+
+kpid_t kthread_create(const char *name, kthread_fn_t fn, void *arg);
+int kthread_attach(kpid_t pid, kthread_fn_t fn, void *arg);   /* Give an existing process a kernel context */
+void kthread_exit(void) __attribute__((noreturn));
+
+/* Save callee-saved state on the current stack, store rsp in *from, resume to */
+void context_switch(uint64_t *from, uint64_t to);
+int process_attach_context(kpid_t pid, uint64_t rsp, paddr_t stack);
 
 /* ===== IDLE PROCESS ===== */
 void idle_process_entry(void);
@@ -0,0 +1,52 @@
+/*
+ * Sampling Profiler
+ * Periodic kernel stack samples, folded and symbolised on demand
+ *
+ * While running, every PIT tick samples the CPU it lands on and sends
+ * an NMI to each other online CPU, whose handler samples it too; NMIs
+ * also catch code that runs with interrupts off. A sample is the
+ * interrupted RIP plus the callers found by following saved frame
+ * pointers (the kernel is built with -fno-omit-frame-pointer). Identical
+ * stacks are counted in place, in a table per CPU, so a long profile
+ * costs no more memory than a short one. prof_dump() writes one
+ * "outer;...;inner count" line per stack to COM1, ready for
+ * flamegraph.pl or speedscope.
+ */
+
+#ifndef PROF_H
+#define PROF_H
+
+#include <kernel/kernel.h>
+
+/* ===== CONFIGURATION ===== */
+#define PROF_CPUS           8       /* CPUs past this share a table (cpu_id % PROF_CPUS) */
+#define PROF_STACKS         256     /* Distinct stacks per table, power of two */
+#define PROF_MAX_DEPTH      16      /* Deeper stacks are cut at the outer end */
+#define PROF_STACK_SPAN     0x10000 /* Frames must lie this close above the interrupted rsp */
+
+/* ===== SAMPLES ===== */
+typedef struct {
+    uint64_t hash;                  /* 0 while the slot is free */
+    uint32_t count;
+    uint32_t depth;
+    uint64_t pcs[PROF_MAX_DEPTH];   /* Innermost first; pcs[0] is the interrupted RIP */
+} prof_stack_t;
+
+typedef struct {
+    uint32_t busy;                  /* An NMI landed inside a timer sample */
+    uint64_t samples;
+    uint64_t user;                  /* Interrupted ring 3; counted, not walked */
+    uint64_t dropped;               /* Table full, or nested */
+    prof_stack_t stacks[PROF_STACKS];
+} __attribute__((aligned(64))) prof_table_t;
+
+/* ===== PROFILER FUNCTIONS ===== */
+void prof_start(void);              /* Discards the previous profile */
+void prof_stop(void);
+bool prof_running(void);
+void prof_dump(void);               /* Folded stacks on COM1 */
+
+void prof_tick(void);               /* Timer IRQ: sample here, NMI the other CPUs */
+void prof_sample(void);             /* NMI handler */
+
+#endif /* PROF_H */
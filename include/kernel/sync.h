@@ -0,0 +1,112 @@
+/*
+ * Synchronization Primitives
+ * Reader-writer spinlocks and sequence locks for read-mostly state
+ */
+
+#ifndef SYNC_H
+#define SYNC_H
+
+#include <kernel/kernel.h>
+#include <kernel/cpu.h>
+
+/* ===== READER-WRITER SPINLOCK =====
+ *
+ * Any number of readers or a single writer. A waiting writer sets
+ * RWLOCK_WRITER first so new readers back off and it cannot starve.
+ * Read locks must not be taken recursively: a writer arriving between
+ * the two acquisitions would deadlock.
+ */
+#define RWLOCK_WRITER 0x80000000u
+
+typedef struct {
+    volatile uint32_t value;  /* RWLOCK_WRITER | reader count */
+} rwlock_t;
+
+static inline void rwlock_init(rwlock_t *lock) {
+    lock->value = 0;
+}
+
+static inline void read_lock(rwlock_t *lock) {
+    while (true) {
+        uint32_t v = __atomic_load_n(&lock->value, __ATOMIC_RELAXED);
+        if (!(v & RWLOCK_WRITER) &&
+            __atomic_compare_exchange_n(&lock->value, &v, v + 1, false,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            return;
+        }
+        cpu_relax();
+    }
+}
+
+static inline void read_unlock(rwlock_t *lock) {
+    __atomic_fetch_sub(&lock->value, 1, __ATOMIC_RELEASE);
+}
+
+static inline void write_lock(rwlock_t *lock) {
+    /* Claim the writer bit, then wait for readers to drain */
+    while (__atomic_fetch_or(&lock->value, RWLOCK_WRITER, __ATOMIC_ACQUIRE) & RWLOCK_WRITER) {
+        cpu_relax();
+    }
+    while (__atomic_load_n(&lock->value, __ATOMIC_ACQUIRE) != RWLOCK_WRITER) {
+        cpu_relax();
+    }
+}
+
+static inline void write_unlock(rwlock_t *lock) {
+    __atomic_store_n(&lock->value, 0, __ATOMIC_RELEASE);
+}
+
+/* ===== SEQUENCE LOCK =====
+ *
+ * Writers serialise on an ordinary spinlock and bump the sequence
+ * before and after the update (odd = write in progress). Readers never
+ * block a writer; they snapshot the data and retry if the sequence
+ * moved:
+ *
+ *     uint32_t seq;
+ *     do {
+ *         seq = read_seqbegin(&sl);
+ *         copy = shared;
+ *     } while (read_seqretry(&sl, seq));
+ *
+ * Reader sections must only copy data out; never dereference pointers
+ * whose lifetime the seqlock alone is supposed to guarantee.
+ */
+typedef struct {
+    volatile uint32_t sequence;
+    spinlock_t lock;
+} seqlock_t;
+
+#define seqlock_init(sl) \
+    do { \
+        (sl)->sequence = 0; \
+        spinlock_init(&(sl)->lock); \
+    } while (0)
+
+static inline uint32_t read_seqbegin(const seqlock_t *sl) {
+    uint32_t seq;
+    while ((seq = __atomic_load_n(&sl->sequence, __ATOMIC_ACQUIRE)) & 1) {
+        cpu_relax();
+    }
+    return seq;
+}
+
+static inline bool read_seqretry(const seqlock_t *sl, uint32_t start) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&sl->sequence, __ATOMIC_RELAXED) != start;
+}
+
+#define write_seqlock(sl) \
+    do { \
+        spinlock_acquire(&(sl)->lock); \
+        __atomic_store_n(&(sl)->sequence, (sl)->sequence + 1, __ATOMIC_RELAXED); \
+        __atomic_thread_fence(__ATOMIC_RELEASE); \
+    } while (0)
+
+#define write_sequnlock(sl) \
+    do { \
+        __atomic_store_n(&(sl)->sequence, (sl)->sequence + 1, __ATOMIC_RELEASE); \
+        spinlock_release(&(sl)->lock); \
+    } while (0)
+
+#endif /* SYNC_H */
@@ -0,0 +1,65 @@
+/*
+ * System Call Interface
+ * SYSCALL/SYSRET entry path and the system call table
+ *
+ * Calling convention (same registers as the x86-64 Linux ABI):
+ *     rax = number, args in rdi, rsi, rdx, r10, r8, r9
+ *     return value in rax; rcx and r11 are clobbered by the CPU
+ */
+
+#ifndef SYSCALL_H
+#define SYSCALL_H
+
+#include <kernel/kernel.h>
+
+/* ===== SYSTEM CALL NUMBERS ===== */
+#define SYS_NULL            0   /* Does nothing; entry/exit cost */
+#define SYS_GETPID          1
+#define SYS_EXIT            2
+#define SYS_CLOCK_NS        3
+#define SYS_YIELD           4
+#define SYS_IPC_CREATE      5   /* (data_size) -> handle */
+#define SYS_IPC_MAP         6   /* (handle, addr, end) */
+#define SYS_IPC_NOTIFY      7   /* (handle) */
+#define SYS_IPC_WAIT        8   /* (handle) */
+#define SYS_URING_SETUP     9   /* (entries, addr, flags) */
+#define SYS_URING_ENTER     10  /* (to_submit, min_complete, flags) -> submitted */
+#define SYS_MAP_ANON        11  /* (addr, len, prot) demand-zero memory */
+#define SYS_UNMAP           12  /* (addr, len) whole areas only */
+
+#define SYSCALL_MAX         64
+
+#define USER_RFLAGS         0x202   /* IF set: IRQs are taken in ring 3 */
+
+/* ===== ERRORS ===== */
+#define SYSCALL_EPERM       ((uint64_t)-1)
+#define SYSCALL_EBADF       ((uint64_t)-9)
+#define SYSCALL_ENOMEM      ((uint64_t)-12)
+#define SYSCALL_EFAULT      ((uint64_t)-14)
+#define SYSCALL_EBUSY       ((uint64_t)-16)
+#define SYSCALL_EINVAL      ((uint64_t)-22)
+#define SYSCALL_ENOSYS      ((uint64_t)-38)
+
+typedef uint64_t (*syscall_fn_t)(uint64_t a0, uint64_t a1, uint64_t a2,
+                                 uint64_t a3, uint64_t a4, uint64_t a5);
+
+/* ===== MODEL-SPECIFIC REGISTERS ===== */
+#define MSR_STAR            0xC0000081
+#define MSR_LSTAR           0xC0000082
+#define MSR_FMASK           0xC0000084
+#define EFER_SCE            (1ULL << 0)
+
+/* ===== SYSCALL FUNCTIONS ===== */
+void syscall_init(void);
+int syscall_register(uint32_t number, syscall_fn_t handler);
+
+/*
+ * Run user code at rip/rsp (ring 3, current address space, arg in rdi)
+ * until a handler calls syscall_return_to_kernel(); returns the value
+ * passed there. System calls made meanwhile run on the caller's stack,
+ * below the frame this saves. Nests per kernel thread.
+ */
+uint64_t syscall_run_user(vaddr_t rip, vaddr_t rsp, uint64_t arg);
+void syscall_return_to_kernel(uint64_t value) __attribute__((noreturn));
+
+#endif /* SYSCALL_H */
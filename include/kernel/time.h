@@ -0,0 +1,17 @@
+/*
+ * Kernel Time Base
+ * TSC calibrated against the PIT
+ */
+
+#ifndef TIME_H
+#define TIME_H
+
+#include <kernel/kernel.h>
+
+void time_init(void);
+uint64_t time_tsc_hz(void);
+uint64_t time_cycles_to_ns(uint64_t cycles);
+uint64_t time_ns(void);  /* Nanoseconds since time_init() */
+void time_get_scale(uint64_t *tsc_base, uint64_t *ns_mult);  /* ns = ((tsc - base) * mult) >> 32 */
+
+#endif /* TIME_H */
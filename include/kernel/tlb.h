@@ -0,0 +1,42 @@
+/*
+ * TLB Shootdowns
+ * Batched invalidation of one address space's translations on all CPUs
+ *
+ * Page-table changes that remove or restrict a mapping are gathered in
+ * a tlb_batch_t and flushed once. A flush invalidates locally, then
+ * sends one IPI per CPU that currently has the space loaded; CPUs that
+ * ran it earlier but have since switched away are not interrupted,
+ * they just flush the space's PCID the next time they load it (see
+ * vmm_switch_address_space()). Above TLB_BATCH_MAX pages the batch
+ * turns into a flush of the whole PCID.
+ */
+
+#ifndef TLB_H
+#define TLB_H
+
+#include <kernel/kernel.h>
+
+struct address_space;
+
+/* ===== BATCHES ===== */
+#define TLB_BATCH_MAX   32      /* invlpg beats a full flush up to about here */
+
+typedef struct {
+    struct address_space *as;
+    uint32_t count;
+    bool full;                  /* Overflowed, or asked for: flush the whole PCID */
+    vaddr_t pages[TLB_BATCH_MAX];
+} tlb_batch_t;
+
+/* ===== TLB FUNCTIONS ===== */
+void tlb_init(void);
+void tlb_batch_init(tlb_batch_t *batch, struct address_space *as);
+void tlb_batch_add(tlb_batch_t *batch, vaddr_t addr);
+void tlb_batch_add_all(tlb_batch_t *batch);
+void tlb_batch_flush(tlb_batch_t *batch);      /* Returns with every CPU done; batch is empty again */
+
+/* One-shot helpers */
+void tlb_flush_page(struct address_space *as, vaddr_t addr);
+void tlb_flush_all(struct address_space *as);
+
+#endif /* TLB_H */
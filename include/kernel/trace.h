@@ -0,0 +1,76 @@
+/*
+ * Static Tracepoints
+ * Compile-time events recorded into per-CPU buffers, exported as
+ * Chrome trace-event JSON
+ *
+ * Every event is an entry of trace_event_id_t with a name in
+ * trace_event_names (kernel/core/trace.c). A disabled tracepoint costs
+ * one load and a not-taken branch: trace_mask has a bit per event that
+ * is on only between trace_start() and trace_stop(). Records go to the
+ * calling CPU's buffer, overwriting the oldest when it is full.
+ * trace_dump() writes them to COM1 as one JSON object that Perfetto
+ * (ui.perfetto.dev) or chrome://tracing open directly.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <kernel/kernel.h>
+
+/* ===== EVENTS ===== */
+typedef enum {
+    TRACE_INPUT_EVENTS,             /* input_process_events() */
+    TRACE_TERMINAL_UPDATE,          /* terminal_app_update() */
+    TRACE_EXPLORER_UPDATE,          /* explorer_app_update() */
+    TRACE_WM_UPDATE,                /* wm_update(): a0 = windows */
+    TRACE_WM_RENDER,                /* wm_render(): a0 = windows */
+    TRACE_NUM_EVENTS,
+} trace_event_id_t;
+
+_Static_assert(TRACE_NUM_EVENTS <= 64, "trace_mask has one bit per event");
+
+/* Chrome trace-event phases */
+#define TRACE_PHASE_BEGIN   'B'
+#define TRACE_PHASE_END     'E'
+#define TRACE_PHASE_INSTANT 'i'
+
+/* ===== RECORDS ===== */
+#define TRACE_CPUS          8       /* CPUs past this share a buffer (cpu_id % TRACE_CPUS) */
+#define TRACE_ENTRIES       4096    /* Per buffer, power of two */
+
+typedef struct {
+    uint64_t tsc;
+    uint16_t cpu;
+    uint8_t phase;
+    uint8_t reserved;
+    uint32_t event;
+    uint64_t args[2];
+} trace_record_t;
+
+typedef struct {
+    uint64_t head;                  /* Records ever written; the newest is head - 1 */
+    trace_record_t records[TRACE_ENTRIES];
+} __attribute__((aligned(64))) trace_buffer_t;
+
+extern uint64_t trace_mask;
+
+/* ===== TRACE FUNCTIONS ===== */
+void trace_start(uint64_t events);  /* Bit per trace_event_id_t; ~0 for all */
+void trace_stop(void);
+void trace_clear(void);
+void trace_dump(void);              /* Chrome JSON on COM1 */
+void trace_record(uint32_t event, uint8_t phase, uint64_t a0, uint64_t a1);
+
+#define TRACE_ALL           (~0ULL)
+
+#define TRACE_EVENT(event, phase, a0, a1) do {                          \
+    if (__builtin_expect(trace_mask & (1ULL << (event)), 0)) {          \
+        trace_record((event), (phase), (uint64_t)(a0), (uint64_t)(a1)); \
+    }                                                                   \
+} while (0)
+
+#define TRACE_BEGIN(event, a0, a1)  TRACE_EVENT(event, TRACE_PHASE_BEGIN, a0, a1)
+#define TRACE_END(event)            TRACE_EVENT(event, TRACE_PHASE_END, 0, 0)
+#define TRACE_INSTANT(event, a0, a1) TRACE_EVENT(event, TRACE_PHASE_INSTANT, a0, a1)
+
+#endif /* TRACE_H */
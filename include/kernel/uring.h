@@ -0,0 +1,115 @@
+/*
+ * Batched Submission Rings
+ * Per-process submission/completion queues in shared memory
+ *
+ * A process maps one ring with SYS_URING_SETUP: a header page, then
+ * the submission queue entries (SQEs), then the completion queue
+ * entries (CQEs), all writable from ring 3. The process fills SQEs,
+ * publishes them by advancing sq_tail, and reaps results by advancing
+ * cq_head. The kernel consumes SQEs in order and posts one CQE each,
+ * either when the process calls SYS_URING_ENTER (any number of
+ * operations per kernel entry) or, with URING_SETUP_SQPOLL, from a
+ * kernel polling thread so that the process never enters the kernel
+ * while the poller is awake.
+ */
+
+#ifndef URING_H
+#define URING_H
+
+#include <kernel/kernel.h>
+#include <kernel/vmm.h>
+
+/* ===== CONFIGURATION ===== */
+#define URING_MAX_ENTRIES   256     /* SQ entries; the CQ has twice as many */
+#define URING_MAX_RINGS     32
+#define URING_POLL_IDLE     1000    /* Empty poller passes before it sleeps */
+
+/* ===== SUBMISSION ENTRY ===== */
+typedef enum {
+    URING_OP_NOP = 0,
+    URING_OP_READ,          /* fd, addr, len, off */
+    URING_OP_WRITE,         /* fd, addr, len, off */
+    URING_OP_IPC_NOTIFY,    /* addr = IPC handle */
+    URING_OP_WIN_MOVE,      /* fd = window id, off = x | (y << 32) */
+    URING_OP_WIN_RESIZE,    /* fd = window id, off = width | (height << 32) */
+    URING_OP_WIN_SHOW,      /* fd = window id */
+    URING_OP_WIN_HIDE,
+    URING_OP_WIN_RAISE,
+    URING_OP_WIN_FOCUS,
+    URING_OP_COUNT,
+} uring_op_t;
+
+#define URING_OFF_CURRENT   ((uint64_t)-1)  /* READ/WRITE at, and advance, the file position */
+
+typedef struct {
+    uint8_t opcode;             /* uring_op_t */
+    uint8_t flags;
+    uint16_t reserved;
+    int32_t fd;
+    uint64_t off;
+    uint64_t addr;
+    uint32_t len;
+    uint32_t reserved2;
+    uint64_t user_data;         /* Copied to the CQE untouched */
+    uint64_t pad[3];
+} uring_sqe_t;
+
+/* ===== COMPLETION ENTRY ===== */
+typedef struct {
+    uint64_t user_data;
+    int64_t res;                /* >= 0 on success, -errno otherwise */
+} uring_cqe_t;
+
+/* ===== SHARED HEADER ===== */
+#define URING_F_NEED_WAKEUP 0x1     /* SQPOLL: the poller sleeps, enter with URING_ENTER_SQ_WAKEUP */
+#define URING_F_CQ_FULL     0x2     /* Submission stopped until CQEs are reaped */
+
+typedef struct {
+    /* Consumer indices free-run; slot = index & (entries - 1) */
+    volatile uint32_t sq_head __attribute__((aligned(64)));    /* Kernel */
+    volatile uint32_t sq_tail __attribute__((aligned(64)));    /* Process */
+    volatile uint32_t cq_head __attribute__((aligned(64)));    /* Process */
+    volatile uint32_t cq_tail __attribute__((aligned(64)));    /* Kernel */
+
+    /* Set up by the kernel */
+    volatile uint32_t flags __attribute__((aligned(64)));      /* URING_F_* */
+    uint32_t sq_entries;
+    uint32_t cq_entries;
+    uint32_t sqes_offset;       /* From the start of the mapping */
+    uint32_t cqes_offset;
+} uring_shared_t;
+
+/* ===== SETUP / ENTER FLAGS ===== */
+#define URING_SETUP_SQPOLL      0x1
+#define URING_ENTER_GETEVENTS   0x1     /* Wait for min_complete CQEs */
+#define URING_ENTER_SQ_WAKEUP   0x2     /* Kick a sleeping poller */
+
+/* ===== KERNEL STATE ===== */
+struct process;
+struct fd_table;
+
+/* Indices and sizes the kernel trusts are kept here, never re-read from the shared page */
+typedef struct uring {
+    uring_shared_t *shared;     /* Kernel view of the mapping */
+    uring_sqe_t *sqes;
+    uring_cqe_t *cqes;
+    uint32_t sq_entries;
+    uint32_t cq_entries;
+    uint32_t sq_head;
+    uint32_t cq_tail;
+    paddr_t frames;
+    uint32_t num_frames;
+    uint32_t flags;             /* URING_SETUP_* */
+    kpid_t owner;
+    address_space_t *as;        /* Owner's space, for user buffers */
+    struct fd_table *files;
+    bool in_use;
+} uring_t;
+
+/* ===== RING FUNCTIONS ===== */
+void uring_init(void);
+uring_t *uring_create(struct process *proc, vaddr_t addr, uint32_t entries, uint32_t flags);
+void uring_destroy(uring_t *ring);
+uint32_t uring_submit(uring_t *ring, uint32_t max);    /* Returns SQEs consumed */
+
+#endif /* URING_H */
@@ -0,0 +1,76 @@
+/*
+ * vDSO Data Page
+ * Read-only page mapped into every process so hot queries (clock,
+ * current PID) need no kernel entry
+ *
+ * The PID is kept per CPU. Each CPU's user GS base points at its own
+ * slot, so one %gs-relative load reads the right one however the
+ * process migrates.
+ */
+
+#ifndef VDSO_H
+#define VDSO_H
+
+#include <kernel/kernel.h>
+#include <kernel/vmm.h>
+#include <kernel/percpu.h>
+#include <stddef.h>
+
+/* Last user page, just above the stack */
+#define VDSO_BASE       USER_STACK_TOP
+
+/* ===== SHARED LAYOUT ===== */
+typedef struct {
+    volatile uint32_t sequence;     /* Odd while the kernel is updating */
+    uint32_t version;
+    uint64_t tsc_base;              /* TSC at time 0 */
+    uint64_t ns_mult;               /* ns = ((tsc - tsc_base) * ns_mult) >> 32 */
+    uint64_t tsc_hz;
+    volatile uint64_t current_pid[MAX_CPUS];    /* Process running on each CPU */
+} vdso_data_t;
+
+#define VDSO_VERSION    2
+
+/* User GS base of a CPU: its current_pid slot */
+#define VDSO_CPU_SLOT(cpu) \
+    (VDSO_BASE + offsetof(vdso_data_t, current_pid) + (uint64_t)(cpu) * sizeof(uint64_t))
+
+_Static_assert(sizeof(vdso_data_t) <= PAGE_SIZE, "vDSO data must fit its page");
+
+/* ===== USER-SIDE READERS ===== */
+static inline const volatile vdso_data_t *vdso_data(void) {
+    return (const volatile vdso_data_t *)VDSO_BASE;
+}
+
+static inline uint64_t vdso_clock_ns(void) {
+    const volatile vdso_data_t *vd = vdso_data();
+    uint32_t seq;
+    uint64_t ns;
+
+    do {
+        seq = vd->sequence;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+        uint32_t lo, hi;
+        __asm__ volatile("rdtsc" : "=a"(lo), "=d"(hi));
+        uint64_t delta = (((uint64_t)hi << 32) | lo) - vd->tsc_base;
+        ns = (uint64_t)(((unsigned __int128)delta * vd->ns_mult) >> 32);
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1) || seq != vd->sequence);
+
+    return ns;
+}
+
+static inline kpid_t vdso_getpid(void) {
+    uint64_t pid;
+    __asm__ volatile("movq %%gs:0, %0" : "=r"(pid));
+    return pid;
+}
+
+/* ===== KERNEL SIDE ===== */
+int vdso_map(address_space_t *as);
+void vdso_set_current(kpid_t pid);
+void vdso_update_clock(void);
+
+#endif /* VDSO_H */
@@ -0,0 +1,124 @@
+/*
+ * Virtual Memory Manager
+ * Address spaces, 4-level page tables and demand-paged memory areas
+ */
+
+#ifndef VMM_H
+#define VMM_H
+
+#include <kernel/kernel.h>
+#include <memory.h>
+
+/* ===== PAGE TABLE ENTRY BITS ===== */
+#define PTE_PRESENT     (1ULL << 0)
+#define PTE_WRITABLE    (1ULL << 1)
+#define PTE_USER        (1ULL << 2)
+#define PTE_PWT         (1ULL << 3)
+#define PTE_PCD         (1ULL << 4)
+#define PTE_ACCESSED    (1ULL << 5)
+#define PTE_DIRTY       (1ULL << 6)
+#define PTE_HUGE        (1ULL << 7)
+#define PTE_PAT         (1ULL << 7)   /* Same bit as PTE_HUGE, in 4 KiB entries only */
+#define PTE_GLOBAL      (1ULL << 8)
+#define PTE_COW         (1ULL << 9)   /* Software: write-protected until first write */
+#define PTE_SHARED      (1ULL << 10)  /* Software: stays shared and writable across fork */
+#define PTE_PAT_HUGE    (1ULL << 12)  /* PTE_PAT's place in 2 MiB and 1 GiB entries */
+#define PTE_NX          (1ULL << 63)
+#define PTE_ADDR_MASK   0x000FFFFFFFFFF000ULL
+
+#define PT_ENTRIES      512
+
+/* ===== PAGE FAULT ERROR CODE ===== */
+#define PF_PRESENT      0x01  /* 0 = not-present page */
+#define PF_WRITE        0x02
+#define PF_USER         0x04
+#define PF_RESERVED     0x08
+#define PF_FETCH        0x10
+
+/* ===== ADDRESS SPACE LAYOUT ===== */
+#define USER_SPACE_END      0x0000800000000000ULL
+#define USER_STACK_TOP      0x00007FFFFFFFF000ULL
+#define USER_STACK_SIZE     (256 * 1024)
+
+/* ===== MEMORY AREAS ===== */
+#define VMA_READ        0x01
+#define VMA_WRITE       0x02
+#define VMA_EXEC        0x04
+#define VMA_USER        0x08
+
+typedef enum {
+    VMA_ANON,   /* Demand-zero */
+    VMA_IMAGE,  /* Filled from an in-memory image, zero past file_end (.bss) */
+    VMA_SHARED, /* Pre-mapped frames shared with other spaces (IPC); never demand-paged */
+} vma_type_t;
+
+typedef struct vm_area {
+    vaddr_t start;              /* Page aligned */
+    vaddr_t end;                /* Page aligned, exclusive */
+    uint32_t prot;              /* VMA_* */
+    vma_type_t type;
+
+    /* VMA_IMAGE: bytes [file_start, file_end) come from image */
+    const uint8_t *image;       /* Backing bytes for file_start; must stay resident */
+    vaddr_t file_start;
+    vaddr_t file_end;
+} vm_area_t;
+
+/* ===== ADDRESS SPACE ===== */
+#define VMM_MAX_AREAS   32
+
+typedef struct address_space {
+    paddr_t pml4;                       /* Physical address of the top-level table */
+    uint16_t pcid;                      /* TLB tag while CR4.PCIDE is on; 0 is the kernel's */
+    uint64_t cpu_mask;                  /* CPUs that may cache entries for it (see <kernel/tlb.h>) */
+    uint64_t tlb_stale_mask;            /* CPUs that must flush its PCID on the next switch */
+    vm_area_t areas[VMM_MAX_AREAS];     /* Sorted by start */
+    size_t num_areas;
+    uint64_t resident_pages;            /* Private frames mapped in the user half */
+    spinlock_t lock;
+    bool in_use;
+} address_space_t;
+
+/* ===== FAULT RESULTS ===== */
+typedef enum {
+    VMM_FAULT_RESOLVED = 0,
+    VMM_FAULT_INVALID = -1,     /* No area, or access violates its protection */
+    VMM_FAULT_OOM = -2,
+} vmm_fault_result_t;
+
+/* ===== PHYSICAL MEMORY ACCESS ===== */
+/* Offset at which all physical memory is mapped (0 while identity mapped) */
+extern uint64_t vmm_phys_offset;
+
+static inline void *phys_to_virt(paddr_t addr) {
+    return (void *)(uintptr_t)(addr + vmm_phys_offset);
+}
+
+/* ===== VMM FUNCTIONS ===== */
+void vmm_init(pmm_t *pmm, uint64_t phys_offset);
+bool vmm_ready(void);
+paddr_t vmm_alloc_frame(void);           /* Reference count starts at 1 */
+paddr_t vmm_alloc_frames(uint32_t count); /* Physically contiguous, each at 1 */
+void vmm_get_frame(paddr_t frame);
+void vmm_free_frame(paddr_t frame);       /* Drops a reference */
+paddr_t vmm_zero_frame(void);
+
+address_space_t *vmm_create_address_space(void);
+address_space_t *vmm_clone_address_space(address_space_t *parent);  /* Copy-on-write */
+void vmm_destroy_address_space(address_space_t *as);
+void vmm_switch_address_space(address_space_t *as);
+bool vmm_set_pcid(bool enabled);        /* Returns the previous setting */
+
+int vmm_add_area(address_space_t *as, const vm_area_t *area);
+vm_area_t *vmm_find_area(address_space_t *as, vaddr_t addr);
+
+uint64_t *vmm_walk(paddr_t pml4, vaddr_t addr, bool create);
+int vmm_map_page(address_space_t *as, vaddr_t addr, paddr_t frame, uint64_t flags);
+int vmm_map_shared(address_space_t *as, const vm_area_t *area, paddr_t frame);  /* Contiguous frames */
+int vmm_unmap_range(address_space_t *as, vaddr_t start, vaddr_t end);           /* Areas stay */
+int vmm_remove_areas(address_space_t *as, vaddr_t start, vaddr_t end);          /* Unmapped, then gone */
+
+/* Resolve a fault at addr with the given #PF error code; classified in cpu_stats_t */
+vmm_fault_result_t vmm_handle_fault(address_space_t *as, vaddr_t addr, uint64_t error);
+
+#endif /* VMM_H */
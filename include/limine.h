@@ -1,29 +1,50 @@
+#ifndef __LIMINE_H__
+#define __LIMINE_H__
+
+#include <types.h>
+
 /*
- * Limine Protocol Headers
- * Defines structures and requests for Limine bootloader
+ * Limine boot protocol: the requests this kernel makes
+ *
+ * Limine passes nothing in registers. It scans the loaded image for
+ * request structures, recognised by their id, and fills in each one's
+ * response pointer before jumping to the entry point. Requests live in
+ * .limine_requests, between the start and end markers, and are kept
+ * by linker.ld. A request the bootloader could not honour keeps a NULL
+ * response.
  */
 
-#ifndef LIMINE_H
-#define LIMINE_H
+#define LIMINE_REQUESTS_SECTION     __attribute__((used, section(".limine_requests"), aligned(8)))
+#define LIMINE_REQUESTS_START       __attribute__((used, section(".limine_requests_start"), aligned(8)))
+#define LIMINE_REQUESTS_END         __attribute__((used, section(".limine_requests_end"), aligned(8)))
+
+#define LIMINE_REQUESTS_START_MARKER \
+    { 0xf6b8f4b39de7d1aeULL, 0xfab91a6940fcb9cfULL, 0x785c6ed015d3e316ULL, 0x181e920a7852b9d9ULL }
+#define LIMINE_REQUESTS_END_MARKER \
+    { 0xadc0e0531bb10d03ULL, 0x9572709f31764c62ULL }
 
-#include <stdint.h>
+#define LIMINE_COMMON_MAGIC         0xc7b1dd30df4c8b88ULL, 0x0a82e883a194f07bULL
 
-#define LIMINE_MAGIC 0x416d4f4cade48a00ULL
+/* Framebuffer */
+#define LIMINE_FRAMEBUFFER_REQUEST  { LIMINE_COMMON_MAGIC, 0x9d5827dcd881dd75ULL, 0xa3148604f6fab11bULL }
+#define LIMINE_FRAMEBUFFER_RGB      1
 
-/* Framebuffer structure */
 struct limine_framebuffer {
-    uint64_t address;
+    void *address;              /* Virtual, in the HHDM */
     uint64_t width;
     uint64_t height;
     uint64_t pitch;
     uint16_t bpp;
-    uint8_t  memory_model;
-    uint8_t  red_mask_size;
-    uint8_t  red_mask_shift;
-    uint8_t  green_mask_size;
-    uint8_t  green_mask_shift;
-    uint8_t  blue_mask_size;
-    uint8_t  blue_mask_shift;
+    uint8_t memory_model;
+    uint8_t red_mask_size;
+    uint8_t red_mask_shift;
+    uint8_t green_mask_size;
+    uint8_t green_mask_shift;
+    uint8_t blue_mask_size;
+    uint8_t blue_mask_shift;
+    uint8_t unused[7];
+    uint64_t edid_size;
+    void *edid;
 };
 
 struct limine_framebuffer_response {
@@ -32,13 +53,40 @@ struct limine_framebuffer_response {
     struct limine_framebuffer **framebuffers;
 };
 
-/* Memory map entry */
+struct limine_framebuffer_request {
+    uint64_t id[4];
+    uint64_t revision;
+    struct limine_framebuffer_response *response;
+};
+
+/* Higher-half direct map: all of physical memory Limine maps, at offset */
+#define LIMINE_HHDM_REQUEST         { LIMINE_COMMON_MAGIC, 0x48dcf1cb8ad2b852ULL, 0x63984e959a98244bULL }
+
+struct limine_hhdm_response {
+    uint64_t revision;
+    uint64_t offset;
+};
+
+struct limine_hhdm_request {
+    uint64_t id[4];
+    uint64_t revision;
+    struct limine_hhdm_response *response;
+};
+
+/* Memory map */
+#define LIMINE_MEMMAP_USABLE                    0
+#define LIMINE_MEMMAP_RESERVED                  1
+#define LIMINE_MEMMAP_ACPI_RECLAIMABLE          2
+#define LIMINE_MEMMAP_ACPI_NVS                  3
+#define LIMINE_MEMMAP_BAD_MEMORY                4
+#define LIMINE_MEMMAP_BOOTLOADER_RECLAIMABLE    5
+#define LIMINE_MEMMAP_KERNEL_AND_MODULES        6
+#define LIMINE_MEMMAP_FRAMEBUFFER               7
+
 struct limine_memmap_entry {
     uint64_t base;
     uint64_t length;
-    uint32_t type;
-    uint32_t unused;
-    uint64_t acpi_rsdp;
+    uint64_t type;
 };
 
 struct limine_memmap_response {
@@ -47,28 +95,12 @@ struct limine_memmap_response {
     struct limine_memmap_entry **entries;
 };
 
-/* RSDP (ACPI) */
-struct limine_rsdp_response {
-    uint64_t revision;
-    uint64_t *address;
-};
+#define LIMINE_MEMMAP_REQUEST       { LIMINE_COMMON_MAGIC, 0x67cf3d9d378a806fULL, 0xe304acdfc50c3c62ULL }
 
-/* Memory map types */
-#define LIMINE_MEMMAP_USABLE              0
-#define LIMINE_MEMMAP_RESERVED            1
-#define LIMINE_MEMMAP_ACPI_RECLAIMABLE    2
-#define LIMINE_MEMMAP_ACPI_NVS            3
-#define LIMINE_MEMMAP_BAD_MEMORY          4
-#define LIMINE_MEMMAP_BOOTLOADER_RECLAIMABLE 5
-#define LIMINE_MEMMAP_KERNEL_AND_MODULES  6
-#define LIMINE_MEMMAP_FRAMEBUFFER         7
-
-/* Bootloader info passed to kernel */
-struct limine_bootloader_info {
-    uint64_t magic;
-    struct limine_framebuffer_response *framebuffer;
-    struct limine_memmap_response *memmap;
-    struct limine_rsdp_response *rsdp;
+struct limine_memmap_request {
+    uint64_t id[4];
+    uint64_t revision;
+    struct limine_memmap_response *response;
 };
 
-#endif /* LIMINE_H */
+#endif /* __LIMINE_H__ */
@@ -16,10 +16,14 @@ typedef struct {
 
 /* PMM Functions */
 void pmm_init(pmm_t *pmm, uint32_t total_frames);
+void pmm_init_used(pmm_t *pmm, uint8_t *bitmap, uint32_t total_frames);    /* Nothing free yet */
 uint32_t pmm_alloc_frame(pmm_t *pmm);
+uint32_t pmm_alloc_frames(pmm_t *pmm, uint32_t count);
 void pmm_free_frame(pmm_t *pmm, uint32_t frame);
 void pmm_mark_frame_used(pmm_t *pmm, uint32_t frame);
 void pmm_mark_frame_free(pmm_t *pmm, uint32_t frame);
+void pmm_mark_region_used(pmm_t *pmm, uint64_t base, uint64_t length);
+void pmm_mark_region_free(pmm_t *pmm, uint64_t base, uint64_t length);   /* Whole frames inside only */
 uint32_t pmm_get_free_frames(pmm_t *pmm);
 
 /* GDT - Global Descriptor Table */
@@ -29,7 +33,22 @@ void gdt_init(void);
 void idt_init(void);
 
 /* Paging - Virtual Memory */
-void paging_init(void);
+#define KERNEL_IMAGE_BASE       0xFFFFFFFF80000000ULL  /* Link address of physical 0 (linker.ld) */
+#define PAGE_SIZE_2M            0x200000ULL
+#define PAGE_SIZE_1G            0x40000000ULL
+
+int paging_init(pmm_t *pmm, uint64_t phys_top, uint64_t phys_offset);   /* phys_offset: Limine's HHDM */
 void paging_enable(void);
+bool paging_pcid_supported(void);     /* CR4.PCIDE is on */
+
+/* Memory types for kernel mappings, once paging_init_pat() has succeeded */
+typedef enum {
+    PAGING_CACHE_WB,                    /* Write-back: the default */
+    PAGING_CACHE_WC,                    /* Write-combining: framebuffers */
+    PAGING_CACHE_UC,                    /* Uncached: MMIO registers */
+} paging_cache_t;
+
+int paging_init_pat(void);            /* -1 without PAT support */
+int paging_set_cache(uint64_t virt, uint64_t size, paging_cache_t type);
 
 #endif /* __MEMORY_H__ */
@@ -3,12 +3,11 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>  /* Shared with <kernel/kernel.h>; a local bool typedef clashes */
 
-typedef int                 bool;
-#define true                1
-#define false               0
-
+#ifndef NULL
 #define NULL                ((void *)0)
+#endif
 
 /* Helper macros */
 #define ALIGN_UP(n, align)     (((n) + (align) - 1) & ~((align) - 1))
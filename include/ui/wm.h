@@ -40,8 +40,8 @@ typedef struct window {
     color_t *framebuffer;
     uint32_t framebuffer_stride;
     
-    /* Window state */
-    bool needs_redraw;
+    /* Window state (needs_redraw is set/cleared atomically) */
+    volatile bool needs_redraw;
     bool has_focus;
     
     /* Child windows */
@@ -50,6 +50,17 @@ typedef struct window {
     
 } window_t;
 
+/* ===== GEOMETRY SNAPSHOT ===== */
+/* Consistent copy of the fields guarded by the WM geometry seqlock */
+typedef struct {
+    uint32_t x;
+    uint32_t y;
+    uint32_t width;
+    uint32_t height;
+    uint32_t flags;
+    bool has_focus;
+} window_geometry_t;
+
 /* ===== DESKTOP ===== */
 typedef struct {
     window_t **windows;
@@ -80,6 +91,12 @@ void wm_resize_window(uint32_t window_id, uint32_t width, uint32_t height);
 void wm_minimize_window(uint32_t window_id);
 void wm_maximize_window(uint32_t window_id);
 void wm_raise_window(uint32_t window_id);
+kpid_t wm_window_owner(uint32_t window_id);    /* 0 if no such window */
+
+/* Lock-free queries (seqlock readers: retry, never block on updates) */
+void wm_get_window_geometry(window_t *window, window_geometry_t *out);
+window_t *wm_get_focused_window(void);
+uint32_t wm_window_at(uint32_t x, uint32_t y);  /* Window id, 0 if none */
 
 /* Event handling */
 void wm_handle_mouse_event(uint32_t x, uint32_t y, uint8_t buttons);
@@ -27,14 +27,42 @@ typedef enum {
 #define VGA_COLOR_LIGHT_YELLOW VGA_COLOR_LIGHT_BROWN
 #endif
 
+/* Text mode VRAM at 0xB8000 is a 32 KiB window; the screen is 80x25 of it */
+#define VGA_WINDOW_CELLS    0x4000
+#define VGA_SHADOW_CELLS    (80 * 50)   /* Largest text screen kept in RAM */
+
+/* CRT controller (colour I/O addresses) and graphics controller */
+#define VGA_CRTC_INDEX      0x3D4
+#define VGA_CRTC_DATA       0x3D5
+#define VGA_CRTC_START_HI   0x0C
+#define VGA_CRTC_START_LO   0x0D
+#define VGA_GC_INDEX        0x3CE
+#define VGA_GC_DATA         0x3CF
+#define VGA_GC_MISC         0x06
+#define VGA_GC_MISC_GRAPHICS 0x01
+
+/*
+ * Output goes to a RAM shadow of the screen and reaches VRAM in one
+ * batch per call, so VRAM is never read. A scroll moves the CRTC start
+ * address one row further into the VRAM window; only when the window
+ * runs out is the screen rewritten, from the shadow, at its start.
+ */
 typedef struct {
-    uint16_t *buffer;
+    uint16_t *buffer;               /* Start of the VRAM window */
     uint32_t width;
     uint32_t height;
     uint32_t row;
     uint32_t col;
     vga_color_t fg_color;
     vga_color_t bg_color;
+
+    uint32_t window_cells;          /* VRAM usable for scrolling; one screen without a text-mode CRTC */
+    uint32_t origin;                /* Window cell where the screen starts */
+    uint32_t shown_origin;          /* What the CRTC was last told */
+    uint32_t top;                   /* Shadow row holding screen row 0 */
+    uint32_t dirty_start;           /* Screen cells not yet in VRAM */
+    uint32_t dirty_end;
+    uint16_t shadow[VGA_SHADOW_CELLS];  /* Rows in ring order from top */
 } vga_terminal_t;
 
 /* Terminal functions */
@@ -45,5 +73,6 @@ void vga_print(vga_terminal_t *term, const char *str);
 void vga_print_hex(vga_terminal_t *term, uint64_t value);
 void vga_println(vga_terminal_t *term, const char *str);
 void vga_set_color(vga_terminal_t *term, vga_color_t fg, vga_color_t bg);
+void vga_flush(vga_terminal_t *term);   /* Copy pending shadow cells to VRAM */
 
 #endif /* __VGA_H__ */
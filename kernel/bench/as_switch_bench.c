@@ -0,0 +1,98 @@
+/*
+ * Address-Space Switch Benchmark
+ * CR3 switch plus TLB refill cost, with and without PCIDs
+ *
+ * Two spaces each map a small working set. Every round switches to one
+ * space, reads one word per page, and switches to the other. Without
+ * PCIDs each switch flushes the TLB and every read misses; with them
+ * both working sets stay cached. Reported as cycles per switch,
+ * including the reads.
+ */
+
+#include <kernel/bench.h>
+#include <kernel/vmm.h>
+#include <kernel/cpu.h>
+#include <memory.h>
+
+#define AS_BENCH_BASE       0x0000000010000000ULL
+#define AS_BENCH_PAGES      32
+#define AS_BENCH_ROUNDS     20000
+
+static address_space_t *as_bench_space(void) {
+    address_space_t *as = vmm_create_address_space();
+    if (!as) return NULL;
+
+    vm_area_t area = {
+        .start = AS_BENCH_BASE,
+        .end = AS_BENCH_BASE + AS_BENCH_PAGES * PAGE_SIZE,
+        .prot = VMA_READ | VMA_WRITE | VMA_USER,
+        .type = VMA_ANON,
+    };
+    if (vmm_add_area(as, &area) != 0) {
+        vmm_destroy_address_space(as);
+        return NULL;
+    }
+
+    /* Populate the working set up front so warm-up takes no faults */
+    for (vaddr_t page = area.start; page < area.end; page += PAGE_SIZE) {
+        if (vmm_handle_fault(as, page, PF_USER | PF_WRITE) != VMM_FAULT_RESOLVED) {
+            vmm_destroy_address_space(as);
+            return NULL;
+        }
+    }
+    return as;
+}
+
+static inline void as_bench_touch(void) {
+    for (uint32_t i = 0; i < AS_BENCH_PAGES; i++) {
+        (void)*(volatile uint64_t *)(uintptr_t)(AS_BENCH_BASE + (uint64_t)i * PAGE_SIZE);
+    }
+}
+
+static uint64_t as_bench_run(address_space_t *a, address_space_t *b) {
+    /* Warm both working sets */
+    vmm_switch_address_space(a);
+    as_bench_touch();
+    vmm_switch_address_space(b);
+    as_bench_touch();
+
+    uint64_t start = rdtsc();
+    for (uint32_t i = 0; i < AS_BENCH_ROUNDS; i++) {
+        vmm_switch_address_space(a);
+        as_bench_touch();
+        vmm_switch_address_space(b);
+        as_bench_touch();
+    }
+    return (rdtsc() - start) / (2 * AS_BENCH_ROUNDS);
+}
+
+void bench_as_switch(void) {
+    if (!vmm_ready()) {
+        KWARN("bench as_switch: VMM not initialized, skipping");
+        return;
+    }
+
+    address_space_t *a = as_bench_space();
+    address_space_t *b = as_bench_space();
+    if (!a || !b) {
+        KWARN("bench as_switch: cannot build address spaces");
+        if (a) vmm_destroy_address_space(a);
+        if (b) vmm_destroy_address_space(b);
+        return;
+    }
+
+    bool pcid = vmm_set_pcid(false);
+    bench_report("as_switch", "flush", as_bench_run(a, b), "cycles/switch");
+
+    if (paging_pcid_supported()) {
+        vmm_set_pcid(true);
+        bench_report("as_switch", "pcid", as_bench_run(a, b), "cycles/switch");
+    } else {
+        KWARN("bench as_switch: no PCID support, skipping the PCID run");
+    }
+    vmm_set_pcid(pcid);
+
+    vmm_switch_address_space(NULL);
+    vmm_destroy_address_space(a);
+    vmm_destroy_address_space(b);
+}
@@ -0,0 +1,66 @@
+/*
+ * Framebuffer Fill Benchmark
+ * graphics_clear() + graphics_present() throughput with the framebuffer
+ * mapped UC, WC and WB
+ *
+ * The clear lands in the back buffer; presenting it copies the whole
+ * screen out, so each run still measures full-screen framebuffer
+ * stores. The same runs happen under each memory type in turn. WB only
+ * shows the cost of the stores: the data may still sit in the cache
+ * afterwards, so the screen lags behind. Reported as MB/s; the
+ * framebuffer is left write-combining, as graphics_init() maps it.
+ */
+
+#include <kernel/bench.h>
+#include <kernel/time.h>
+#include <kernel/cpu.h>
+#include <drivers/display.h>
+#include <memory.h>
+
+#define FB_BENCH_CLEARS         16
+
+static uint64_t fb_bench_run(uint64_t size) {
+    graphics_clear(COLOR_BLACK);        /* Warm the TLB and the new mapping */
+    graphics_present();
+
+    uint64_t start = rdtsc();
+    for (uint32_t i = 0; i < FB_BENCH_CLEARS; i++) {
+        graphics_clear((i & 1) ? COLOR_WIN7_BLUE : COLOR_WIN7_GRAY);
+        graphics_present();
+    }
+    uint64_t ns = time_cycles_to_ns(rdtsc() - start);
+
+    /* Bytes per ns * 1000 = MB/s */
+    return ns ? size * FB_BENCH_CLEARS * 1000 / ns : 0;
+}
+
+void bench_fb_fill(void) {
+    if (!bootinfo.framebuffer) {
+        KWARN("bench fb_fill: no framebuffer, skipping");
+        return;
+    }
+    graphics_init();
+
+    static const struct {
+        paging_cache_t type;
+        const char *tag;
+    } runs[] = {
+        { PAGING_CACHE_UC, "uc" },
+        { PAGING_CACHE_WC, "wc" },
+        { PAGING_CACHE_WB, "wb" },
+    };
+
+    uint64_t size = (uint64_t)bootinfo.framebuffer_width * bootinfo.framebuffer_height *
+                    sizeof(color_t);
+    uint64_t mapped = (uint64_t)bootinfo.framebuffer_pitch * bootinfo.framebuffer_height;
+
+    for (size_t i = 0; i < sizeof(runs) / sizeof(runs[0]); i++) {
+        if (paging_set_cache(bootinfo.framebuffer, mapped, runs[i].type) != 0) {
+            KWARN("bench fb_fill: cannot change the memory type");
+            return;
+        }
+        bench_report("fb_fill", runs[i].tag, fb_bench_run(size), "MB/s");
+    }
+
+    paging_set_cache(bootinfo.framebuffer, mapped, PAGING_CACHE_WC);
+}
@@ -0,0 +1,71 @@
+/*
+ * Rectangle Fill Benchmark
+ * Per-pixel drawing against clipped span fills, in Mpix/s
+ *
+ * "pixel" fills each rectangle the way graphics_fill_rect() used to:
+ * one graphics_draw_pixel() call, with its checks, per pixel. "span"
+ * is graphics_fill_rect() itself, clipped once and filled a scanline at
+ * a time with 8-byte stores. Both draw into the back buffer (or straight
+ * to the framebuffer when the screen is too large for one), over full
+ * screens and over 64x64 tiles; nothing is presented.
+ */
+
+#include <kernel/bench.h>
+#include <kernel/time.h>
+#include <kernel/cpu.h>
+#include <drivers/display.h>
+
+#define FILL_BENCH_SCREENS      8
+#define FILL_BENCH_TILE         64
+
+typedef void (*fill_bench_fn_t)(uint32_t x, uint32_t y, uint32_t width, uint32_t height,
+                                color_t color);
+
+static void fill_bench_pixels(uint32_t x, uint32_t y, uint32_t width, uint32_t height,
+                              color_t color) {
+    for (uint32_t yy = y; yy < y + height; yy++) {
+        for (uint32_t xx = x; xx < x + width; xx++) {
+            graphics_draw_pixel(xx, yy, color);
+        }
+    }
+}
+
+/* Mpix/s filling the screen FILL_BENCH_SCREENS times in tile x tile pieces */
+static uint64_t fill_bench_run(fill_bench_fn_t fill, uint32_t tile) {
+    uint32_t width = bootinfo.framebuffer_width;
+    uint32_t height = bootinfo.framebuffer_height;
+    uint64_t pixels = 0;
+
+    uint64_t start = rdtsc();
+    for (uint32_t i = 0; i < FILL_BENCH_SCREENS; i++) {
+        color_t color = (i & 1) ? COLOR_WIN7_BLUE : COLOR_WIN7_GRAY;
+        for (uint32_t y = 0; y < height; y += tile) {
+            for (uint32_t x = 0; x < width; x += tile) {
+                uint32_t w = width - x < tile ? width - x : tile;
+                uint32_t h = height - y < tile ? height - y : tile;
+                fill(x, y, w, h, color);
+                pixels += (uint64_t)w * h;
+            }
+        }
+    }
+    uint64_t ns = time_cycles_to_ns(rdtsc() - start);
+
+    /* Pixels per ns * 1000 = Mpix/s */
+    return ns ? pixels * 1000 / ns : 0;
+}
+
+void bench_fill_rect(void) {
+    if (!bootinfo.framebuffer) {
+        KWARN("bench fill_rect: no framebuffer, skipping");
+        return;
+    }
+    graphics_init();
+
+    uint32_t screen = bootinfo.framebuffer_width > bootinfo.framebuffer_height ?
+                      bootinfo.framebuffer_width : bootinfo.framebuffer_height;
+
+    bench_report("fill_rect", "pixel_screen", fill_bench_run(fill_bench_pixels, screen), "Mpix/s");
+    bench_report("fill_rect", "span_screen", fill_bench_run(graphics_fill_rect, screen), "Mpix/s");
+    bench_report("fill_rect", "pixel_tile", fill_bench_run(fill_bench_pixels, FILL_BENCH_TILE), "Mpix/s");
+    bench_report("fill_rect", "span_tile", fill_bench_run(graphics_fill_rect, FILL_BENCH_TILE), "Mpix/s");
+}
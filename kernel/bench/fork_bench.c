@@ -0,0 +1,120 @@
+/*
+ * Fork Benchmark
+ * fork+exit+reap round trips against parents of increasing resident size
+ *
+ * With copy-on-write page tables the fork cost should stay flat as
+ * the parent grows; the per-page price is paid later, on first write.
+ */
+
+#include <kernel/bench.h>
+#include <kernel/process.h>
+#include <kernel/vmm.h>
+#include <kernel/time.h>
+#include <kernel/cpu.h>
+
+#define FORK_BENCH_BASE         0x0000000040000000ULL
+#define FORK_BENCH_ITERATIONS   256
+
+/* Parent resident sizes, in pages */
+static const struct {
+    uint32_t pages;
+    const char *tag;
+} fork_bench_sizes[] = {
+    { 16,   "16p" },
+    { 256,  "256p" },
+    { 4096, "4096p" },
+};
+
+/* Parent with an anonymous area of `pages` pages, all touched */
+static kpid_t fork_bench_parent(uint32_t pages) {
+    kpid_t pid = process_create("bench-fork", 0, 0);
+    if (pid == (kpid_t)-1) return pid;
+
+    process_t *proc = process_get_by_pid(pid);
+    address_space_t *as = vmm_create_address_space();
+    if (!as) {
+        process_exit(pid, -1);
+        process_reap(pid, NULL);
+        return (kpid_t)-1;
+    }
+    proc->address_space = as;
+
+    vm_area_t area = {
+        .start = FORK_BENCH_BASE,
+        .end = FORK_BENCH_BASE + (vaddr_t)pages * PAGE_SIZE,
+        .prot = VMA_READ | VMA_WRITE | VMA_USER,
+        .type = VMA_ANON,
+    };
+    vmm_add_area(as, &area);
+
+    for (uint32_t i = 0; i < pages; i++) {
+        vmm_handle_fault(as, area.start + (vaddr_t)i * PAGE_SIZE, PF_WRITE | PF_USER);
+    }
+
+    return pid;
+}
+
+static void fork_bench_size(uint32_t pages, const char *tag) {
+    kpid_t parent = fork_bench_parent(pages);
+    if (parent == (kpid_t)-1) {
+        KWARN("bench fork: cannot build a %u page parent", pages);
+        return;
+    }
+
+    uint64_t fork_cycles = 0;
+    uint64_t total_cycles = 0;
+    uint64_t cow_cycles = 0;
+    uint32_t done = 0;
+
+    kernel_log_mute(true);
+    for (uint32_t i = 0; i < FORK_BENCH_ITERATIONS; i++) {
+        uint64_t start = rdtsc();
+        kpid_t child = process_fork(parent);
+        uint64_t forked = rdtsc();
+        if (child == (kpid_t)-1) break;
+
+        /* First write to one page in the child: the deferred copy */
+        process_t *proc = process_get_by_pid(child);
+        vaddr_t page = FORK_BENCH_BASE + (vaddr_t)(i % pages) * PAGE_SIZE;
+        uint64_t cow_start = rdtsc();
+        vmm_handle_fault(proc->address_space, page, PF_PRESENT | PF_WRITE | PF_USER);
+        uint64_t cow_end = rdtsc();
+
+        process_exit(child, 0);
+        process_reap(child, NULL);
+        uint64_t end = rdtsc();
+
+        fork_cycles += forked - start;
+        cow_cycles += cow_end - cow_start;
+        total_cycles += (end - start) - (cow_end - cow_start);
+        done++;
+    }
+    kernel_log_mute(false);
+
+    process_exit(parent, 0);
+    process_reap(parent, NULL);
+
+    if (done == 0) {
+        KWARN("bench fork: process_fork failed");
+        return;
+    }
+
+    uint64_t per_round = total_cycles / done;
+    uint64_t per_sec = per_round ? time_tsc_hz() / per_round : 0;
+
+    KINFO("bench fork: parent %u pages, %u rounds", pages, done);
+    bench_report("fork", tag, fork_cycles / done, "cycles");
+    bench_report("fork_exit", tag, per_sec, "ops/s");
+    bench_report("cow_fault", tag, cow_cycles / done, "cycles");
+}
+
+void bench_fork(void) {
+    if (!vmm_ready()) {
+        KWARN("bench fork: VMM not initialized, skipping");
+        return;
+    }
+
+    for (size_t i = 0; i < sizeof(fork_bench_sizes) / sizeof(fork_bench_sizes[0]); i++) {
+        fork_bench_size(fork_bench_sizes[i].pages, fork_bench_sizes[i].tag);
+    }
+}
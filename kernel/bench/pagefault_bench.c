@@ -0,0 +1,150 @@
+/*
+ * Page Fault Benchmark
+ * Cost of first touch on demand-zero memory, read against write
+ *
+ * A ring-3 process maps an anonymous heap with SYS_MAP_ANON and touches
+ * one byte per page. Reads map the shared zero page, writes get a fresh
+ * zeroed frame. A run that maps nothing is subtracted, so process
+ * start-up, teardown and the fault on the loop's own code drop out.
+ * Reported as cycles per fault. A last run writes the heap and then
+ * hands it back with SYS_UNMAP; less the write run, that is the cost of
+ * freeing one page, with its share of the batched TLB shootdown.
+ */
+
+#include <kernel/bench.h>
+#include <kernel/process.h>
+#include <kernel/syscall.h>
+#include <kernel/vmm.h>
+#include <kernel/cpu.h>
+
+#define PF_BENCH_STR_(x)        #x
+#define PF_BENCH_STR(x)         PF_BENCH_STR_(x)
+
+#define PF_BENCH_CODE           0x0000000000400000ULL
+#define PF_BENCH_STACK          0x0000000000800000ULL   /* Top of a one-page stack */
+#define PF_BENCH_HEAP           0x0000000010000000ULL
+#define PF_BENCH_PAGES          1024
+#define PF_BENCH_WRITE          (1ULL << 63)            /* Argument flags, page count below */
+#define PF_BENCH_UNMAP          (1ULL << 62)
+
+/* ===== USER LOOP ===== */
+extern const uint8_t pf_bench_user[], pf_bench_user_end[];
+
+__asm__(
+    ".pushsection .rodata\n"
+    ".globl pf_bench_user, pf_bench_user_end\n"
+    "pf_bench_user:\n"
+    "    movq %rdi, %r14\n"
+    "    shrq $63, %r14\n"
+    "    movq %rdi, %r15\n"
+    "    shrq $62, %r15\n"
+    "    andq $1, %r15\n"
+    "    movq %rdi, %r13\n"
+    "    btrq $63, %r13\n"
+    "    btrq $62, %r13\n"
+    "    xorl %eax, %eax\n"
+    "    testq %r13, %r13\n"
+    "    jz 4f\n"
+    "    movabsq $" PF_BENCH_STR(PF_BENCH_HEAP) ", %r12\n"
+    "    movq %r12, %rdi\n"
+    "    movq %r13, %rsi\n"
+    "    shlq $12, %rsi\n"
+    "    movl $" PF_BENCH_STR(VMA_READ | VMA_WRITE) ", %edx\n"
+    "    movl $" PF_BENCH_STR(SYS_MAP_ANON) ", %eax\n"
+    "    syscall\n"
+    "    testq %rax, %rax\n"
+    "    jnz 4f\n"
+    "    movq %r13, %rbx\n"
+    "1:  testq %r14, %r14\n"
+    "    jz 2f\n"
+    "    movb $1, (%r12)\n"
+    "    jmp 3f\n"
+    "2:  movb (%r12), %al\n"
+    "3:  addq $4096, %r12\n"
+    "    decq %r13\n"
+    "    jnz 1b\n"
+    "    xorl %eax, %eax\n"
+    "    testq %r15, %r15\n"
+    "    jz 4f\n"
+    "    movabsq $" PF_BENCH_STR(PF_BENCH_HEAP) ", %rdi\n"
+    "    movq %rbx, %rsi\n"
+    "    shlq $12, %rsi\n"
+    "    movl $" PF_BENCH_STR(SYS_UNMAP) ", %eax\n"
+    "    syscall\n"
+    "4:  movq %rax, %rdi\n"
+    "    movl $" PF_BENCH_STR(SYS_EXIT) ", %eax\n"
+    "    syscall\n"
+    "pf_bench_user_end:\n"
+    ".popsection\n"
+);
+
+/* Cycles for one run, or 0 if it could not be set up or failed */
+static uint64_t pf_bench_run(uint64_t arg) {
+    address_space_t *as = vmm_create_address_space();
+    if (!as) return 0;
+
+    vm_area_t code = {
+        .start = PF_BENCH_CODE,
+        .end = PF_BENCH_CODE + PAGE_SIZE,
+        .prot = VMA_READ | VMA_EXEC | VMA_USER,
+        .type = VMA_IMAGE,
+        .image = pf_bench_user,
+        .file_start = PF_BENCH_CODE,
+        .file_end = PF_BENCH_CODE + (vaddr_t)(pf_bench_user_end - pf_bench_user),
+    };
+    vm_area_t stack = {
+        .start = PF_BENCH_STACK - PAGE_SIZE,
+        .end = PF_BENCH_STACK,
+        .prot = VMA_READ | VMA_WRITE | VMA_USER,
+        .type = VMA_ANON,
+    };
+    if (vmm_add_area(as, &code) != 0 || vmm_add_area(as, &stack) != 0) {
+        vmm_destroy_address_space(as);
+        return 0;
+    }
+
+    kernel_log_mute(true);
+    kpid_t pid = process_create_user("pf-bench", as, PF_BENCH_CODE,
+                                     stack.start, stack.end, 0);
+    if (pid == (kpid_t)-1) {
+        kernel_log_mute(false);
+        vmm_destroy_address_space(as);
+        return 0;
+    }
+
+    int code_out = -1;
+    uint64_t start = rdtsc();
+    if (process_start_user(pid, arg) != 0) {
+        process_exit(pid, -1);
+    }
+    while (process_reap(pid, &code_out) != 0) {
+        scheduler_switch();
+    }
+    uint64_t cycles = rdtsc() - start;
+    kernel_log_mute(false);
+
+    return code_out == 0 ? cycles : 0;
+}
+
+void bench_pagefault(void) {
+    if (!vmm_ready()) {
+        KWARN("bench pagefault: VMM not initialized, skipping");
+        return;
+    }
+
+    uint64_t base = pf_bench_run(0);
+    uint64_t read = pf_bench_run(PF_BENCH_PAGES);
+    uint64_t write = pf_bench_run(PF_BENCH_PAGES | PF_BENCH_WRITE);
+    uint64_t unmap = pf_bench_run(PF_BENCH_PAGES | PF_BENCH_WRITE | PF_BENCH_UNMAP);
+    if (!base || !read || !write || !unmap) {
+        KWARN("bench pagefault: run failed");
+        return;
+    }
+
+    bench_report("pagefault", "read_zero", (read > base ? read - base : 0) / PF_BENCH_PAGES,
+                 "cycles/fault");
+    bench_report("pagefault", "write_zero", (write > base ? write - base : 0) / PF_BENCH_PAGES,
+                 "cycles/fault");
+    bench_report("pagefault", "unmap", (unmap > write ? unmap - write : 0) / PF_BENCH_PAGES,
+                 "cycles/page");
+}
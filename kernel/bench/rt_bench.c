@@ -0,0 +1,188 @@
+/*
+ * Real-Time Scheduling Latency Benchmark
+ * Worst-case wakeup latency of a periodic thread under CPU-bound load
+ *
+ * A probe thread sleeps until an absolute deadline every millisecond
+ * and records how late it actually ran, while RT_BENCH_HOGS kernel
+ * threads burn CPU in RT_BENCH_SLICE_US chunks between yields. The run
+ * is done once with the probe in SCHED_FIFO and once in SCHED_NORMAL;
+ * the difference is what the compositor and input threads gain by
+ * opting in.
+ *
+ * rt_throttle checks the other half of the contract: a SCHED_FIFO
+ * thread that never sleeps must still leave the CPU to a SCHED_NORMAL
+ * one once its budget is spent. It reports the normal thread's share
+ * of the slices: the spinner's budget, then round robin with the
+ * throttled spinner, gives (1 - budget / period) / 2.
+ */
+
+#include <kernel/bench.h>
+#include <kernel/process.h>
+#include <kernel/time.h>
+#include <kernel/vmm.h>
+#include <kernel/cpu.h>
+
+#define RT_BENCH_HOGS       4
+#define RT_BENCH_SAMPLES    200
+#define RT_BENCH_SLICE_US   100
+#define RT_BENCH_PERIOD_US  1000
+#define RT_BENCH_BUDGET_US  200
+#define RT_BENCH_PRIORITY   10
+#define RT_BENCH_THROTTLE_MS 50
+
+typedef struct {
+    uint64_t period;        /* Cycles */
+    uint64_t max;
+    uint64_t sum;
+    volatile bool done;
+} rt_probe_t;
+
+static volatile bool rt_bench_stop;
+static uint64_t rt_bench_slice;     /* Cycles */
+
+static void rt_bench_hog(void *arg) {
+    (void)arg;
+    while (!rt_bench_stop) {
+        uint64_t until = rdtsc() + rt_bench_slice;
+        while (rdtsc() < until) cpu_relax();
+        scheduler_switch();
+    }
+}
+
+static void rt_bench_probe(void *arg) {
+    rt_probe_t *probe = (rt_probe_t *)arg;
+
+    for (uint32_t i = 0; i < RT_BENCH_SAMPLES; i++) {
+        uint64_t deadline = rdtsc() + probe->period;
+        scheduler_sleep_until(deadline);
+
+        uint64_t late = rdtsc() - deadline;
+        probe->sum += late;
+        if (late > probe->max) probe->max = late;
+    }
+    probe->done = true;
+
+    /* The hogs never leave the CPU to the boot context: stop them from here */
+    rt_bench_stop = true;
+}
+
+/* Drive the threads from the boot context until pid can be reaped */
+static void rt_bench_reap(kpid_t pid) {
+    while (process_reap(pid, NULL) != 0) {
+        scheduler_switch();
+    }
+}
+
+static void rt_bench_run(const char *suite, bool realtime) {
+    rt_probe_t probe = {
+        .period = RT_BENCH_PERIOD_US * time_tsc_hz() / 1000000,
+    };
+    kpid_t hogs[RT_BENCH_HOGS];
+    uint32_t num_hogs = 0;
+
+    rt_bench_stop = false;
+    rt_bench_slice = RT_BENCH_SLICE_US * time_tsc_hz() / 1000000;
+
+    kernel_log_mute(true);
+    for (; num_hogs < RT_BENCH_HOGS; num_hogs++) {
+        hogs[num_hogs] = kthread_create("rt-hog", rt_bench_hog, NULL);
+        if (hogs[num_hogs] == (kpid_t)-1) break;
+    }
+    kpid_t pid = kthread_create("rt-probe", rt_bench_probe, &probe);
+    kernel_log_mute(false);
+
+    if (pid == (kpid_t)-1 || num_hogs < RT_BENCH_HOGS) {
+        KWARN("bench rt_latency: could not create threads");
+        rt_bench_stop = true;
+        probe.done = true;
+    } else if (realtime) {
+        sched_set_realtime(pid, RT_BENCH_PRIORITY, RT_BENCH_BUDGET_US * 1000ULL,
+                           RT_BENCH_PERIOD_US * 1000ULL);
+    }
+
+    while (!probe.done) {
+        scheduler_switch();
+    }
+    rt_bench_stop = true;
+
+    kernel_log_mute(true);
+    if (pid != (kpid_t)-1) rt_bench_reap(pid);
+    for (uint32_t i = 0; i < num_hogs; i++) {
+        rt_bench_reap(hogs[i]);
+    }
+    kernel_log_mute(false);
+
+    if (num_hogs < RT_BENCH_HOGS || pid == (kpid_t)-1) return;
+
+    bench_report(suite, "max", time_cycles_to_ns(probe.max), "ns");
+    bench_report(suite, "avg", time_cycles_to_ns(probe.sum / RT_BENCH_SAMPLES), "ns");
+}
+
+/* ===== THROTTLING ===== */
+static volatile uint64_t rt_throttle_slices[2];    /* SCHED_FIFO, SCHED_NORMAL */
+
+static void rt_bench_spinner(void *arg) {
+    uint64_t until = rdtsc() + *(uint64_t *)arg;
+
+    while (rdtsc() < until && !rt_bench_stop) {
+        uint64_t slice = rdtsc() + rt_bench_slice;
+        while (rdtsc() < slice) cpu_relax();
+        rt_throttle_slices[0]++;
+        scheduler_switch();
+    }
+    rt_bench_stop = true;
+}
+
+static void rt_bench_normal(void *arg) {
+    (void)arg;
+    while (!rt_bench_stop) {
+        uint64_t slice = rdtsc() + rt_bench_slice;
+        while (rdtsc() < slice) cpu_relax();
+        rt_throttle_slices[1]++;
+        scheduler_switch();
+    }
+}
+
+static void rt_bench_throttle(void) {
+    uint64_t duration = RT_BENCH_THROTTLE_MS * time_tsc_hz() / 1000;
+
+    rt_bench_stop = false;
+    rt_bench_slice = RT_BENCH_SLICE_US * time_tsc_hz() / 1000000;
+    rt_throttle_slices[0] = rt_throttle_slices[1] = 0;
+
+    kernel_log_mute(true);
+    kpid_t normal = kthread_create("rt-normal", rt_bench_normal, NULL);
+    kpid_t spinner = kthread_create("rt-spinner", rt_bench_spinner, &duration);
+    kernel_log_mute(false);
+
+    if (normal == (kpid_t)-1 || spinner == (kpid_t)-1 ||
+        sched_set_realtime(spinner, RT_BENCH_PRIORITY, RT_BENCH_BUDGET_US * 1000ULL,
+                           RT_BENCH_PERIOD_US * 1000ULL) != 0) {
+        KWARN("bench rt_throttle: could not create threads");
+        rt_bench_stop = true;
+    }
+
+    kernel_log_mute(true);
+    if (spinner != (kpid_t)-1) rt_bench_reap(spinner);
+    if (normal != (kpid_t)-1) rt_bench_reap(normal);
+    kernel_log_mute(false);
+
+    uint64_t total = rt_throttle_slices[0] + rt_throttle_slices[1];
+    if (total == 0) return;
+
+    if (rt_throttle_slices[1] == 0) {
+        KWARN("bench rt_throttle: a throttled SCHED_FIFO thread starved SCHED_NORMAL");
+    }
+    bench_report("rt_throttle", "normal_share", rt_throttle_slices[1] * 100 / total, "%");
+}
+
+void bench_rt_latency(void) {
+    if (!vmm_ready()) {
+        KWARN("bench rt_latency: VMM not initialized, skipping");
+        return;
+    }
+
+    rt_bench_run("rt_latency_fifo", true);
+    rt_bench_run("rt_latency_normal", false);
+    rt_bench_throttle();
+}
@@ -0,0 +1,347 @@
+/*
+ * Scheduler Benchmark
+ * Context-switch, wakeup and messaging costs of the kernel-thread scheduler
+ *
+ * pingpong   two threads alternate through process_wake()/process_block():
+ *            cycles per switch
+ * wakeup     time from process_wake() to the woken thread running
+ * hackbench  groups of senders and receivers exchanging small messages
+ *            through bounded mailboxes, blocking when full/empty
+ * scaling    cycles per yield with 2 - 128 runnable threads, which shows
+ *            the O(n) pick in scheduler_switch()
+ *
+ * Everything runs as kernel threads driven from the boot context, and
+ * the scheduler is cooperative, so the mailboxes need no atomics.
+ */
+
+#include <kernel/bench.h>
+#include <kernel/process.h>
+#include <kernel/time.h>
+#include <kernel/vmm.h>
+#include <kernel/cpu.h>
+
+#define SCHED_BENCH_PINGPONG_ROUNDS     10000
+#define SCHED_BENCH_WAKEUPS             2000
+#define SCHED_BENCH_YIELDS              200
+#define SCHED_BENCH_MAX_THREADS         128
+
+/* ===== THREAD MANAGEMENT ===== */
+static kpid_t sched_bench_pids[SCHED_BENCH_MAX_THREADS];
+static uint32_t sched_bench_count;
+
+static bool sched_bench_spawn(const char *name, kthread_fn_t fn, void *arg) {
+    if (sched_bench_count >= SCHED_BENCH_MAX_THREADS) return false;
+
+    kernel_log_mute(true);
+    kpid_t pid = kthread_create(name, fn, arg);
+    kernel_log_mute(false);
+    if (pid == (kpid_t)-1) return false;
+
+    sched_bench_pids[sched_bench_count++] = pid;
+    return true;
+}
+
+/* Run the threads from the boot context until every one is reaped */
+static void sched_bench_finish(void) {
+    kernel_log_mute(true);
+    for (uint32_t i = 0; i < sched_bench_count; i++) {
+        while (process_reap(sched_bench_pids[i], NULL) != 0) {
+            scheduler_switch();
+        }
+    }
+    kernel_log_mute(false);
+    sched_bench_count = 0;
+}
+
+static kpid_t sched_bench_self(void) {
+    return process_get_current()->pid;
+}
+
+/* ===== PING-PONG ===== */
+typedef struct {
+    kpid_t peer;
+    uint64_t start;
+    uint64_t end;
+} pingpong_t;
+
+static void pingpong_thread(void *arg) {
+    pingpong_t *pp = (pingpong_t *)arg;
+    kpid_t self = sched_bench_self();
+
+    pp->start = rdtsc();
+    for (uint32_t i = 0; i < SCHED_BENCH_PINGPONG_ROUNDS; i++) {
+        process_wake(pp->peer);
+        process_block(self);
+        scheduler_switch();
+    }
+    pp->end = rdtsc();
+
+    /* The peer is parked waiting for its last turn */
+    process_wake(pp->peer);
+}
+
+static void sched_bench_pingpong(void) {
+    pingpong_t a = {0}, b = {0};
+
+    if (!sched_bench_spawn("pp-a", pingpong_thread, &a) ||
+        !sched_bench_spawn("pp-b", pingpong_thread, &b)) {
+        KWARN("bench sched: could not create threads");
+        sched_bench_finish();
+        return;
+    }
+    a.peer = sched_bench_pids[1];
+    b.peer = sched_bench_pids[0];
+    sched_bench_finish();
+
+    uint64_t first = a.start < b.start ? a.start : b.start;
+    uint64_t last = a.end > b.end ? a.end : b.end;
+    uint64_t per_switch = (last - first) / (2ULL * SCHED_BENCH_PINGPONG_ROUNDS);
+
+    bench_report("sched_pingpong", "switch", per_switch, "cycles");
+    bench_report("sched_pingpong", "switch_ns", time_cycles_to_ns(per_switch), "ns");
+}
+
+/* ===== WAKEUP LATENCY ===== */
+typedef struct {
+    kpid_t sleeper;
+    volatile bool waiting;
+    volatile bool done;
+    uint64_t woken_at;
+    uint64_t max;
+    uint64_t sum;
+} wakeup_t;
+
+static void wakeup_sleeper(void *arg) {
+    wakeup_t *w = (wakeup_t *)arg;
+    kpid_t self = sched_bench_self();
+
+    for (uint32_t i = 0; i < SCHED_BENCH_WAKEUPS; i++) {
+        process_block(self);
+        w->waiting = true;
+        scheduler_switch();
+
+        uint64_t latency = rdtsc() - w->woken_at;
+        w->sum += latency;
+        if (latency > w->max) w->max = latency;
+    }
+    w->done = true;
+}
+
+static void wakeup_waker(void *arg) {
+    wakeup_t *w = (wakeup_t *)arg;
+
+    while (!w->done) {
+        if (w->waiting) {
+            w->waiting = false;
+            w->woken_at = rdtsc();
+            process_wake(w->sleeper);
+        }
+        scheduler_switch();
+    }
+}
+
+static void sched_bench_wakeup(void) {
+    wakeup_t w = {0};
+
+    if (!sched_bench_spawn("wake-sleeper", wakeup_sleeper, &w) ||
+        !sched_bench_spawn("wake-waker", wakeup_waker, &w)) {
+        KWARN("bench sched: could not create threads");
+        w.done = true;
+        sched_bench_finish();
+        return;
+    }
+    w.sleeper = sched_bench_pids[0];
+    sched_bench_finish();
+
+    bench_report("sched_wakeup", "avg", time_cycles_to_ns(w.sum / SCHED_BENCH_WAKEUPS), "ns");
+    bench_report("sched_wakeup", "max", time_cycles_to_ns(w.max), "ns");
+}
+
+/* ===== HACKBENCH ===== */
+#define HACKBENCH_FANOUT    4       /* Senders and receivers per group */
+#define HACKBENCH_MESSAGES  100     /* Per sender, to each receiver */
+#define HACKBENCH_SLOTS     16
+#define HACKBENCH_MSG_SIZE  100
+
+typedef struct {
+    uint8_t data[HACKBENCH_SLOTS][HACKBENCH_MSG_SIZE];
+    uint32_t head;                  /* Next slot to read */
+    uint32_t tail;                  /* Next slot to write */
+    kpid_t owner;
+    bool owner_waiting;
+    uint32_t senders_waiting;
+    kpid_t senders[HACKBENCH_FANOUT];
+} mailbox_t;
+
+typedef struct {
+    mailbox_t boxes[HACKBENCH_FANOUT];  /* One per receiver */
+} hackbench_group_t;
+
+typedef struct {
+    hackbench_group_t *group;
+    uint32_t index;
+} hackbench_arg_t;
+
+static void mailbox_wake_senders(mailbox_t *box) {
+    for (uint32_t i = 0; i < box->senders_waiting; i++) {
+        process_wake(box->senders[i]);
+    }
+    box->senders_waiting = 0;
+}
+
+static void hackbench_sender(void *arg) {
+    hackbench_group_t *group = ((hackbench_arg_t *)arg)->group;
+    kpid_t self = sched_bench_self();
+    uint8_t msg[HACKBENCH_MSG_SIZE];
+
+    for (uint32_t i = 0; i < HACKBENCH_MSG_SIZE; i++) msg[i] = (uint8_t)i;
+
+    for (uint32_t m = 0; m < HACKBENCH_MESSAGES; m++) {
+        for (uint32_t r = 0; r < HACKBENCH_FANOUT; r++) {
+            mailbox_t *box = &group->boxes[r];
+
+            while (box->tail - box->head == HACKBENCH_SLOTS) {
+                box->senders[box->senders_waiting++] = self;
+                process_block(self);
+                scheduler_switch();
+            }
+
+            uint8_t *slot = box->data[box->tail % HACKBENCH_SLOTS];
+            for (uint32_t i = 0; i < HACKBENCH_MSG_SIZE; i++) slot[i] = msg[i];
+            box->tail++;
+
+            if (box->owner_waiting) {
+                box->owner_waiting = false;
+                process_wake(box->owner);
+            }
+        }
+    }
+}
+
+static void hackbench_receiver(void *arg) {
+    hackbench_arg_t *a = (hackbench_arg_t *)arg;
+    mailbox_t *box = &a->group->boxes[a->index];
+    volatile uint32_t checksum = 0;
+
+    for (uint32_t n = 0; n < HACKBENCH_FANOUT * HACKBENCH_MESSAGES; n++) {
+        while (box->head == box->tail) {
+            box->owner_waiting = true;
+            process_block(box->owner);
+            scheduler_switch();
+        }
+
+        checksum += box->data[box->head % HACKBENCH_SLOTS][HACKBENCH_MSG_SIZE - 1];
+        box->head++;
+        mailbox_wake_senders(box);
+    }
+}
+
+static void sched_bench_hackbench(uint32_t groups, const char *tag) {
+    hackbench_group_t *group_mem[SCHED_BENCH_MAX_THREADS / (2 * HACKBENCH_FANOUT)];
+    hackbench_arg_t args[SCHED_BENCH_MAX_THREADS];
+    paddr_t frames[SCHED_BENCH_MAX_THREADS / (2 * HACKBENCH_FANOUT)];
+    uint32_t pages = (sizeof(hackbench_group_t) + PAGE_SIZE - 1) / PAGE_SIZE;
+    uint32_t built = 0;
+    bool ok = true;
+
+    for (; built < groups; built++) {
+        frames[built] = vmm_alloc_frames(pages);
+        if (!frames[built]) {
+            ok = false;
+            break;
+        }
+        group_mem[built] = (hackbench_group_t *)phys_to_virt(frames[built]);
+        for (uint32_t r = 0; r < HACKBENCH_FANOUT; r++) {
+            mailbox_t *box = &group_mem[built]->boxes[r];
+            box->head = box->tail = 0;
+            box->owner_waiting = false;
+            box->senders_waiting = 0;
+        }
+    }
+
+    for (uint32_t g = 0; ok && g < groups; g++) {
+        for (uint32_t r = 0; ok && r < HACKBENCH_FANOUT; r++) {
+            hackbench_arg_t *a = &args[sched_bench_count];
+            a->group = group_mem[g];
+            a->index = r;
+            ok = sched_bench_spawn("hb-recv", hackbench_receiver, a);
+            if (ok) group_mem[g]->boxes[r].owner = sched_bench_pids[sched_bench_count - 1];
+        }
+        for (uint32_t s = 0; ok && s < HACKBENCH_FANOUT; s++) {
+            hackbench_arg_t *a = &args[sched_bench_count];
+            a->group = group_mem[g];
+            a->index = s;
+            ok = sched_bench_spawn("hb-send", hackbench_sender, a);
+        }
+    }
+
+    if (!ok) {
+        /* Partially built groups would deadlock: let nothing run */
+        KWARN("bench sched: could not set up hackbench");
+        for (uint32_t i = 0; i < sched_bench_count; i++) {
+            process_exit(sched_bench_pids[i], 0);
+        }
+    }
+
+    uint64_t start = rdtsc();
+    sched_bench_finish();
+    uint64_t cycles = rdtsc() - start;
+
+    for (uint32_t g = 0; g < built; g++) {
+        for (uint32_t i = 0; i < pages; i++) {
+            vmm_free_frame(frames[g] + (paddr_t)i * PAGE_SIZE);
+        }
+    }
+    if (!ok) return;
+
+    uint64_t messages = (uint64_t)groups * HACKBENCH_FANOUT * HACKBENCH_FANOUT * HACKBENCH_MESSAGES;
+    uint64_t ns = time_cycles_to_ns(cycles);
+
+    bench_report("sched_hackbench_us", tag, ns / 1000, "us");
+    bench_report("sched_hackbench_msgs", tag, ns ? messages * 1000000000ULL / ns : 0, "msg/s");
+}
+
+/* ===== SCALING ===== */
+static void scaling_thread(void *arg) {
+    (void)arg;
+    for (uint32_t i = 0; i < SCHED_BENCH_YIELDS; i++) {
+        scheduler_switch();
+    }
+}
+
+static void sched_bench_scaling(uint32_t threads, const char *tag) {
+    for (uint32_t i = 0; i < threads; i++) {
+        if (!sched_bench_spawn("scale", scaling_thread, NULL)) {
+            KWARN("bench sched: could not create threads");
+            break;
+        }
+    }
+    uint32_t spawned = sched_bench_count;
+
+    uint64_t start = rdtsc();
+    sched_bench_finish();
+    uint64_t cycles = rdtsc() - start;
+
+    if (spawned < threads) return;
+    bench_report("sched_scaling", tag, cycles / ((uint64_t)threads * SCHED_BENCH_YIELDS), "cycles");
+}
+
+/* ===== SUITE ===== */
+void bench_sched(void) {
+    if (!vmm_ready()) {
+        KWARN("bench sched: VMM not initialized, skipping");
+        return;
+    }
+
+    sched_bench_pingpong();
+    sched_bench_wakeup();
+
+    sched_bench_hackbench(1, "g1");
+    sched_bench_hackbench(4, "g4");
+    sched_bench_hackbench(8, "g8");
+
+    sched_bench_scaling(2, "2");
+    sched_bench_scaling(8, "8");
+    sched_bench_scaling(32, "32");
+    sched_bench_scaling(128, "128");
+}
@@ -0,0 +1,145 @@
+/*
+ * Scheduler Scan Benchmark
+ * Cost of one full run-queue scan for 1,000 - 10,000 processes
+ *
+ * "split" runs scheduler_pick() over a dense table of sched_entity_t,
+ * exactly as scheduler_switch() does. "legacy" runs the same selection
+ * over pointers to descriptors laid out like the old monolithic
+ * process_t (name, regions and an inline fd array around the state
+ * field), one per page as the heap would have spread them.
+ */
+
+#include <kernel/bench.h>
+#include <kernel/process.h>
+#include <kernel/vmm.h>
+#include <kernel/cpu.h>
+#include <string.h>
+
+#define SCHED_SCAN_ROUNDS 16
+
+/* Pre-split process_t layout */
+typedef struct {
+    kpid_t pid;
+    uid_t uid;
+    gid_t gid;
+    char name[256];
+    process_state_t state;
+    int32_t priority;
+    vaddr_t regions[9];
+    uint64_t cpu_ticks;
+    uint64_t creation_time;
+    uint64_t exit_code;
+    void *address_space;
+    void *open_files[256];
+    kpid_t *children;
+    size_t num_children;
+    kpid_t parent_pid;
+} legacy_process_t;
+
+static const struct {
+    uint32_t count;
+    const char *tag;
+} sched_scan_sizes[] = {
+    { 1000,  "1k" },
+    { 2000,  "2k" },
+    { 5000,  "5k" },
+    { 10000, "10k" },
+};
+
+#define SCHED_SCAN_MAX 10000
+
+static legacy_process_t *legacy_pick(legacy_process_t **table, uint32_t count, uint32_t start) {
+    legacy_process_t *best = NULL;
+
+    for (uint32_t n = 0; n < count; n++) {
+        legacy_process_t *p = table[(start + n) % count];
+        if (p->state != PROCESS_STATE_READY && p->state != PROCESS_STATE_CREATED) continue;
+        if (!best || p->priority > best->priority) best = p;
+    }
+    return best;
+}
+
+static inline process_state_t sched_scan_state(uint32_t i) {
+    /* Mostly blocked, a few runnable: every entry must still be examined */
+    return (i % 16 == 0) ? PROCESS_STATE_READY : PROCESS_STATE_WAITING;
+}
+
+static uint32_t sched_scan_pages(size_t bytes) {
+    return (uint32_t)((bytes + PAGE_SIZE - 1) / PAGE_SIZE);
+}
+
+static void sched_scan_free(paddr_t frames, uint32_t pages) {
+    if (!frames) return;
+    for (uint32_t i = 0; i < pages; i++) {
+        vmm_free_frame(frames + (paddr_t)i * PAGE_SIZE);
+    }
+}
+
+/* Keeps the picks observable so the scans are not optimized away */
+static volatile uintptr_t sched_scan_sink;
+
+void bench_sched_scan(void) {
+    if (!vmm_ready()) {
+        KWARN("bench sched_scan: VMM not initialized, skipping");
+        return;
+    }
+
+    uint32_t split_pages = sched_scan_pages(SCHED_SCAN_MAX * sizeof(sched_entity_t));
+    uint32_t table_pages = sched_scan_pages(SCHED_SCAN_MAX * sizeof(legacy_process_t *));
+    paddr_t split_frames = vmm_alloc_frames(split_pages);
+    paddr_t table_frames = vmm_alloc_frames(table_pages);
+    if (!split_frames || !table_frames) {
+        KWARN("bench sched_scan: out of contiguous memory");
+        sched_scan_free(split_frames, split_pages);
+        sched_scan_free(table_frames, table_pages);
+        return;
+    }
+
+    sched_entity_t *split = (sched_entity_t *)phys_to_virt(split_frames);
+    legacy_process_t **legacy = (legacy_process_t **)phys_to_virt(table_frames);
+    uint32_t built = 0;
+
+    for (; built < SCHED_SCAN_MAX; built++) {
+        paddr_t frame = vmm_alloc_frame();
+        if (!frame) break;
+        legacy_process_t *p = (legacy_process_t *)phys_to_virt(frame);
+        memset(p, 0, sizeof(*p));
+        p->pid = built + 1;
+        p->state = sched_scan_state(built);
+        p->priority = PROCESS_PRIORITY_DEFAULT;
+        legacy[built] = p;
+
+        memset(&split[built], 0, sizeof(sched_entity_t));
+        split[built].pid = built + 1;
+        split[built].state = sched_scan_state(built);
+        split[built].priority = PROCESS_PRIORITY_DEFAULT;
+        split[built].flags = SCHED_F_CONTEXT;
+    }
+
+    for (size_t i = 0; i < sizeof(sched_scan_sizes) / sizeof(sched_scan_sizes[0]); i++) {
+        uint32_t count = sched_scan_sizes[i].count;
+        if (count > built) break;
+
+        uint64_t start = rdtsc();
+        for (uint32_t r = 0; r < SCHED_SCAN_ROUNDS; r++) {
+            sched_scan_sink = (uintptr_t)legacy_pick(legacy, count, r);
+        }
+        uint64_t legacy_cycles = (rdtsc() - start) / SCHED_SCAN_ROUNDS;
+
+        start = rdtsc();
+        for (uint32_t r = 0; r < SCHED_SCAN_ROUNDS; r++) {
+            sched_scan_sink = (uintptr_t)scheduler_pick(split, count, r);
+        }
+        uint64_t split_cycles = (rdtsc() - start) / SCHED_SCAN_ROUNDS;
+
+        bench_report("sched_scan_legacy", sched_scan_sizes[i].tag, legacy_cycles, "cycles");
+        bench_report("sched_scan_split", sched_scan_sizes[i].tag, split_cycles, "cycles");
+        bench_report("sched_scan_split_per_proc", sched_scan_sizes[i].tag, split_cycles / count, "cycles");
+    }
+
+    for (uint32_t i = 0; i < built; i++) {
+        vmm_free_frame((paddr_t)((uintptr_t)legacy[i] - vmm_phys_offset));
+    }
+    sched_scan_free(split_frames, split_pages);
+    sched_scan_free(table_frames, table_pages);
+}
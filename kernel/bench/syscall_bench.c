@@ -0,0 +1,117 @@
+/*
+ * System Call Benchmark
+ * Null-syscall round trips from ring 3, against a vDSO read
+ *
+ * Small position-independent user loops are copied into a scratch
+ * address space and entered with syscall_run_user(); each loop ends
+ * with SYS_EXIT, which returns control to the benchmark.
+ */
+
+#include <kernel/bench.h>
+#include <kernel/syscall.h>
+#include <kernel/vdso.h>
+#include <kernel/vmm.h>
+#include <kernel/time.h>
+#include <kernel/cpu.h>
+
+#define SYSCALL_BENCH_STR_(x)   #x
+#define SYSCALL_BENCH_STR(x)    SYSCALL_BENCH_STR_(x)
+
+#define SYSCALL_BENCH_CODE      0x0000000000400000ULL
+#define SYSCALL_BENCH_STACK     0x0000000000800000ULL   /* Top of a one-page stack */
+#define SYSCALL_BENCH_ITERATIONS 100000
+
+/* ===== USER LOOPS (iteration count in rdi) ===== */
+extern const uint8_t syscall_bench_null[], syscall_bench_null_end[];
+extern const uint8_t syscall_bench_getpid[], syscall_bench_getpid_end[];
+extern const uint8_t syscall_bench_vdso[], syscall_bench_vdso_end[];
+
+__asm__(
+    ".pushsection .rodata\n"
+    ".globl syscall_bench_null, syscall_bench_null_end\n"
+    "syscall_bench_null:\n"
+    "1:  movl $" SYSCALL_BENCH_STR(SYS_NULL) ", %eax\n"
+    "    syscall\n"
+    "    decq %rdi\n"
+    "    jnz 1b\n"
+    "    movl $" SYSCALL_BENCH_STR(SYS_EXIT) ", %eax\n"
+    "    syscall\n"
+    "syscall_bench_null_end:\n"
+
+    ".globl syscall_bench_getpid, syscall_bench_getpid_end\n"
+    "syscall_bench_getpid:\n"
+    "1:  movl $" SYSCALL_BENCH_STR(SYS_GETPID) ", %eax\n"
+    "    syscall\n"
+    "    decq %rdi\n"
+    "    jnz 1b\n"
+    "    movl $" SYSCALL_BENCH_STR(SYS_EXIT) ", %eax\n"
+    "    syscall\n"
+    "syscall_bench_getpid_end:\n"
+
+    ".globl syscall_bench_vdso, syscall_bench_vdso_end\n"
+    "syscall_bench_vdso:\n"
+    "1:  movq %gs:0, %rax\n"            /* vdso_getpid(): this CPU's current_pid slot */
+    "    decq %rdi\n"
+    "    jnz 1b\n"
+    "    xorl %edi, %edi\n"
+    "    movl $" SYSCALL_BENCH_STR(SYS_EXIT) ", %eax\n"
+    "    syscall\n"
+    "syscall_bench_vdso_end:\n"
+    ".popsection\n"
+);
+
+/* Map one loop and a stack, fault them in ahead of the timing, run it */
+static uint64_t syscall_bench_loop(const uint8_t *start, const uint8_t *end) {
+    address_space_t *as = vmm_create_address_space();
+    if (!as) return 0;
+
+    vm_area_t code = {
+        .start = SYSCALL_BENCH_CODE,
+        .end = SYSCALL_BENCH_CODE + PAGE_SIZE,
+        .prot = VMA_READ | VMA_EXEC | VMA_USER,
+        .type = VMA_IMAGE,
+        .image = start,
+        .file_start = SYSCALL_BENCH_CODE,
+        .file_end = SYSCALL_BENCH_CODE + (vaddr_t)(end - start),
+    };
+    vm_area_t stack = {
+        .start = SYSCALL_BENCH_STACK - PAGE_SIZE,
+        .end = SYSCALL_BENCH_STACK,
+        .prot = VMA_READ | VMA_WRITE | VMA_USER,
+        .type = VMA_ANON,
+    };
+
+    uint64_t cycles = 0;
+    if (vmm_add_area(as, &code) == 0 && vmm_add_area(as, &stack) == 0 &&
+        vdso_map(as) == 0 &&
+        vmm_handle_fault(as, code.start, PF_USER | PF_FETCH) == VMM_FAULT_RESOLVED &&
+        vmm_handle_fault(as, stack.start, PF_USER | PF_WRITE) == VMM_FAULT_RESOLVED) {
+        uint64_t saved_cr3 = read_cr3();
+        vmm_switch_address_space(as);
+
+        uint64_t start_tsc = rdtsc();
+        syscall_run_user(SYSCALL_BENCH_CODE, SYSCALL_BENCH_STACK, SYSCALL_BENCH_ITERATIONS);
+        cycles = rdtsc() - start_tsc;
+
+        write_cr3(saved_cr3);
+    }
+
+    vmm_destroy_address_space(as);
+    return cycles / SYSCALL_BENCH_ITERATIONS;
+}
+
+void bench_syscall(void) {
+    if (!vmm_ready()) {
+        KWARN("bench syscall: VMM not initialized, skipping");
+        return;
+    }
+
+    uint64_t null_cycles = syscall_bench_loop(syscall_bench_null, syscall_bench_null_end);
+    uint64_t getpid_cycles = syscall_bench_loop(syscall_bench_getpid, syscall_bench_getpid_end);
+    uint64_t vdso_cycles = syscall_bench_loop(syscall_bench_vdso, syscall_bench_vdso_end);
+
+    bench_report("syscall", "null", null_cycles, "cycles");
+    bench_report("syscall", "null_ns", time_cycles_to_ns(null_cycles), "ns");
+    bench_report("syscall", "getpid", getpid_cycles, "cycles");
+    bench_report("syscall", "vdso_getpid", vdso_cycles, "cycles");
+}
@@ -0,0 +1,167 @@
+/*
+ * Submission Ring Benchmark
+ * Per-operation cost of one kernel entry per op against batched entries
+ *
+ * A ring-3 process sets up a ring and submits NOP SQEs in rounds of
+ * 1, 8 or 32, entering the kernel once per round and reaping the CQ
+ * in one store. Reported as cycles per operation, process start-up
+ * and teardown included.
+ */
+
+#include <kernel/bench.h>
+#include <kernel/process.h>
+#include <kernel/syscall.h>
+#include <kernel/uring.h>
+#include <kernel/vmm.h>
+#include <kernel/cpu.h>
+
+#define URING_BENCH_STR_(x)     #x
+#define URING_BENCH_STR(x)      URING_BENCH_STR_(x)
+
+#define URING_BENCH_CODE        0x0000000000400000ULL
+#define URING_BENCH_PARAMS      0x0000000000401000ULL
+#define URING_BENCH_RING        0x0000000000600000ULL
+#define URING_BENCH_STACK       0x0000000000800000ULL   /* Top of a one-page stack */
+#define URING_BENCH_OPS         32768
+#define URING_BENCH_ENTRIES     256
+
+/* Read by the user loop; rdi points at it */
+typedef struct {
+    uint64_t ring;
+    uint64_t batch;
+    uint64_t rounds;
+} __attribute__((aligned(PAGE_SIZE))) uring_bench_params_t;
+
+_Static_assert(__builtin_offsetof(uring_shared_t, sq_tail) == 64, "loop writes sq_tail at 64");
+_Static_assert(__builtin_offsetof(uring_shared_t, cq_head) == 128, "loop writes cq_head at 128");
+_Static_assert(__builtin_offsetof(uring_shared_t, cq_tail) == 192, "loop reads cq_tail at 192");
+
+/* ===== USER LOOP ===== */
+extern const uint8_t uring_bench_user[], uring_bench_user_end[];
+
+/* Zeroed SQEs are NOPs, so a round only has to move sq_tail */
+__asm__(
+    ".pushsection .rodata\n"
+    ".globl uring_bench_user, uring_bench_user_end\n"
+    "uring_bench_user:\n"
+    "    movq 0(%rdi), %r12\n"
+    "    movq 8(%rdi), %r13\n"
+    "    movq 16(%rdi), %r14\n"
+    "    movl $" URING_BENCH_STR(URING_BENCH_ENTRIES) ", %edi\n"
+    "    movq %r12, %rsi\n"
+    "    xorl %edx, %edx\n"
+    "    movl $" URING_BENCH_STR(SYS_URING_SETUP) ", %eax\n"
+    "    syscall\n"
+    "    testq %rax, %rax\n"
+    "    jnz 2f\n"
+    "1:  addl %r13d, 64(%r12)\n"
+    "    movq %r13, %rdi\n"
+    "    xorl %esi, %esi\n"
+    "    xorl %edx, %edx\n"
+    "    movl $" URING_BENCH_STR(SYS_URING_ENTER) ", %eax\n"
+    "    syscall\n"
+    "    movl 192(%r12), %eax\n"
+    "    movl %eax, 128(%r12)\n"
+    "    decq %r14\n"
+    "    jnz 1b\n"
+    "    xorl %eax, %eax\n"
+    "2:  movq %rax, %rdi\n"
+    "    movl $" URING_BENCH_STR(SYS_EXIT) ", %eax\n"
+    "    syscall\n"
+    "uring_bench_user_end:\n"
+    ".popsection\n"
+);
+
+static uring_bench_params_t uring_bench_params;
+
+/* Cycles per operation, or 0 if the run could not be set up or failed */
+static uint64_t uring_bench_run(uint32_t batch) {
+    uring_bench_params.ring = URING_BENCH_RING;
+    uring_bench_params.batch = batch;
+    uring_bench_params.rounds = URING_BENCH_OPS / batch;
+
+    address_space_t *as = vmm_create_address_space();
+    if (!as) return 0;
+
+    vm_area_t code = {
+        .start = URING_BENCH_CODE,
+        .end = URING_BENCH_CODE + PAGE_SIZE,
+        .prot = VMA_READ | VMA_EXEC | VMA_USER,
+        .type = VMA_IMAGE,
+        .image = uring_bench_user,
+        .file_start = URING_BENCH_CODE,
+        .file_end = URING_BENCH_CODE + (vaddr_t)(uring_bench_user_end - uring_bench_user),
+    };
+    vm_area_t params = {
+        .start = URING_BENCH_PARAMS,
+        .end = URING_BENCH_PARAMS + PAGE_SIZE,
+        .prot = VMA_READ | VMA_USER,
+        .type = VMA_IMAGE,
+        .image = (const uint8_t *)&uring_bench_params,
+        .file_start = URING_BENCH_PARAMS,
+        .file_end = URING_BENCH_PARAMS + sizeof(uring_bench_params),
+    };
+    vm_area_t stack = {
+        .start = URING_BENCH_STACK - PAGE_SIZE,
+        .end = URING_BENCH_STACK,
+        .prot = VMA_READ | VMA_WRITE | VMA_USER,
+        .type = VMA_ANON,
+    };
+
+    /* Fault everything the loop touches in up front, outside the timing */
+    if (vmm_add_area(as, &code) != 0 || vmm_add_area(as, &params) != 0 ||
+        vmm_add_area(as, &stack) != 0 ||
+        vmm_handle_fault(as, code.start, PF_USER | PF_FETCH) != VMM_FAULT_RESOLVED ||
+        vmm_handle_fault(as, params.start, PF_USER) != VMM_FAULT_RESOLVED ||
+        vmm_handle_fault(as, stack.start, PF_USER | PF_WRITE) != VMM_FAULT_RESOLVED) {
+        vmm_destroy_address_space(as);
+        return 0;
+    }
+
+    kernel_log_mute(true);
+    kpid_t pid = process_create_user("uring-bench", as, URING_BENCH_CODE,
+                                     stack.start, stack.end, 0);
+    if (pid == (kpid_t)-1) {
+        kernel_log_mute(false);
+        vmm_destroy_address_space(as);
+        return 0;
+    }
+
+    int code_out = -1;
+    uint64_t start = rdtsc();
+    if (process_start_user(pid, URING_BENCH_PARAMS) != 0) {
+        process_exit(pid, -1);
+    }
+    while (process_reap(pid, &code_out) != 0) {
+        scheduler_switch();
+    }
+    uint64_t cycles = rdtsc() - start;
+    kernel_log_mute(false);
+
+    return code_out == 0 ? cycles / URING_BENCH_OPS : 0;
+}
+
+void bench_uring(void) {
+    if (!vmm_ready()) {
+        KWARN("bench uring: VMM not initialized, skipping");
+        return;
+    }
+
+    static const struct {
+        uint32_t batch;
+        const char *tag;
+    } runs[] = {
+        { 1,  "batch1" },
+        { 8,  "batch8" },
+        { 32, "batch32" },
+    };
+
+    for (size_t i = 0; i < sizeof(runs) / sizeof(runs[0]); i++) {
+        uint64_t per_op = uring_bench_run(runs[i].batch);
+        if (!per_op) {
+            KWARN("bench uring: run failed");
+            continue;
+        }
+        bench_report("uring", runs[i].tag, per_op, "cycles/op");
+    }
+}
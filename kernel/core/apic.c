@@ -0,0 +1,54 @@
+/*
+ * Local APIC Implementation
+ * Register access through the direct map, fixed-delivery IPIs and NMIs
+ */
+
+#include <kernel/apic.h>
+#include <kernel/idt.h>
+#include <kernel/percpu.h>
+#include <kernel/vmm.h>
+#include <kernel/cpu.h>
+
+/* ===== STATE ===== */
+static paddr_t lapic_base = 0;
+
+/* Through phys_to_virt() on every access: MMIO is only reachable through the direct map */
+static inline volatile uint32_t *lapic_reg(uint32_t offset) {
+    return (volatile uint32_t *)((uint8_t *)phys_to_virt(lapic_base) + offset);
+}
+
+/* ===== INITIALIZATION ===== */
+void lapic_init(void) {
+    uint64_t msr = rdmsr(MSR_APIC_BASE);
+    wrmsr(MSR_APIC_BASE, msr | APIC_BASE_ENABLE);
+    lapic_base = msr & PTE_ADDR_MASK;
+
+    /* Software-enable; spurious interrupts land on the last vector */
+    *lapic_reg(LAPIC_SVR) = LAPIC_SVR_ENABLE | VEC_APIC_SPURIOUS;
+    this_cpu_write(apic_id, *lapic_reg(LAPIC_ID) >> 24);
+}
+
+bool lapic_ready(void) {
+    return lapic_base != 0;
+}
+
+/* ===== INTERRUPTS ===== */
+static void lapic_send_icr(uint32_t apic_id, uint32_t low) {
+    *lapic_reg(LAPIC_ICR_HIGH) = apic_id << 24;
+    *lapic_reg(LAPIC_ICR_LOW) = low;                /* Physical, edge: the write sends it */
+    while (*lapic_reg(LAPIC_ICR_LOW) & LAPIC_ICR_PENDING) {
+        cpu_relax();
+    }
+}
+
+void lapic_send_ipi(uint32_t apic_id, uint8_t vector) {
+    lapic_send_icr(apic_id, vector);                /* Fixed delivery */
+}
+
+void lapic_send_nmi(uint32_t apic_id) {
+    lapic_send_icr(apic_id, LAPIC_ICR_NMI);
+}
+
+void lapic_eoi(void) {
+    *lapic_reg(LAPIC_EOI) = 0;
+}
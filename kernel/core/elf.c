@@ -0,0 +1,113 @@
+/*
+ * ELF64 Program Loader Implementation
+ * Validates an executable and registers its segments as lazy memory areas
+ */
+
+#include <kernel/elf.h>
+#include <kernel/vmm.h>
+#include <kernel/kernel.h>
+#include <stddef.h>
+
+static elf_result_t elf_check_header(const elf64_ehdr_t *eh, size_t size) {
+    if (size < sizeof(elf64_ehdr_t)) return ELF_ERR_FORMAT;
+
+    if (eh->e_magic != ELF_MAGIC ||
+        eh->e_class != ELFCLASS64 ||
+        eh->e_data != ELFDATA2LSB ||
+        eh->e_type != ET_EXEC ||
+        eh->e_machine != EM_X86_64 ||
+        eh->e_phentsize != sizeof(elf64_phdr_t)) {
+        return ELF_ERR_FORMAT;
+    }
+
+    if (eh->e_phoff > size ||
+        (uint64_t)eh->e_phnum * sizeof(elf64_phdr_t) > size - eh->e_phoff) {
+        return ELF_ERR_FORMAT;
+    }
+
+    return ELF_OK;
+}
+
+static elf_result_t elf_check_segment(const elf64_phdr_t *ph, size_t size) {
+    if (ph->p_filesz > ph->p_memsz) return ELF_ERR_SEGMENT;
+    if (ph->p_offset > size || ph->p_filesz > size - ph->p_offset) return ELF_ERR_SEGMENT;
+    if (ph->p_memsz == 0) return ELF_OK;
+
+    /* Whole segment must live in the lower (user) half */
+    if (ph->p_vaddr >= USER_SPACE_END ||
+        ph->p_memsz > USER_SPACE_END - ph->p_vaddr) {
+        return ELF_ERR_SEGMENT;
+    }
+
+    return ELF_OK;
+}
+
+elf_result_t elf_load(address_space_t *as, const void *image, size_t size, elf_image_t *out) {
+    const uint8_t *base = (const uint8_t *)image;
+    const elf64_ehdr_t *eh = (const elf64_ehdr_t *)image;
+
+    elf_result_t result = elf_check_header(eh, size);
+    if (result != ELF_OK) return result;
+
+    out->entry = eh->e_entry;
+    out->code_start = out->data_start = USER_SPACE_END;
+    out->code_end = out->data_end = 0;
+    bool entry_mapped = false;
+
+    const elf64_phdr_t *phdrs = (const elf64_phdr_t *)(base + eh->e_phoff);
+
+    for (uint16_t i = 0; i < eh->e_phnum; i++) {
+        const elf64_phdr_t *ph = &phdrs[i];
+        if (ph->p_type != PT_LOAD) continue;
+
+        result = elf_check_segment(ph, size);
+        if (result != ELF_OK) return result;
+        if (ph->p_memsz == 0) continue;
+
+        vm_area_t area = {
+            .start = ALIGN_DOWN(ph->p_vaddr, PAGE_SIZE),
+            .end = ALIGN_UP(ph->p_vaddr + ph->p_memsz, PAGE_SIZE),
+            .prot = VMA_USER,
+            .type = VMA_IMAGE,
+            .image = base + ph->p_offset,
+            .file_start = ph->p_vaddr,
+            .file_end = ph->p_vaddr + ph->p_filesz,
+        };
+        if (ph->p_flags & PF_R) area.prot |= VMA_READ;
+        if (ph->p_flags & PF_W) area.prot |= VMA_WRITE;
+        if (ph->p_flags & PF_X) area.prot |= VMA_EXEC;
+
+        if (vmm_add_area(as, &area) != 0) return ELF_ERR_MAP;
+
+        if (ph->p_flags & PF_X) {
+            if (eh->e_entry >= ph->p_vaddr && eh->e_entry - ph->p_vaddr < ph->p_memsz) {
+                entry_mapped = true;
+            }
+            if (area.start < out->code_start) out->code_start = area.start;
+            if (area.end > out->code_end) out->code_end = area.end;
+        } else {
+            if (area.start < out->data_start) out->data_start = area.start;
+            if (area.end > out->data_end) out->data_end = area.end;
+        }
+    }
+
+    if (out->code_end == 0) return ELF_ERR_FORMAT;  /* Nothing executable */
+    if (!entry_mapped) return ELF_ERR_FORMAT;       /* Entry outside every executable segment */
+    if (out->data_end == 0) {
+        out->data_start = out->data_end = out->code_end;
+    }
+
+    /* Demand-zero stack below the top of user space */
+    vm_area_t stack = {
+        .start = USER_STACK_TOP - USER_STACK_SIZE,
+        .end = USER_STACK_TOP,
+        .prot = VMA_READ | VMA_WRITE | VMA_USER,
+        .type = VMA_ANON,
+    };
+    if (vmm_add_area(as, &stack) != 0) return ELF_ERR_MAP;
+
+    out->stack_start = stack.start;
+    out->stack_end = stack.end;
+
+    return ELF_OK;
+}
@@ -0,0 +1,172 @@
+/*
+ * File Descriptor Table Implementation
+ * Bitmap allocation of the lowest free fd and copy-on-grow slot arrays
+ */
+
+#include <kernel/fd.h>
+#include <kernel/kernel.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FD_BITS_PER_WORD 64
+
+static inline uint32_t fd_bitmap_words(uint32_t capacity) {
+    return (capacity + FD_BITS_PER_WORD - 1) / FD_BITS_PER_WORD;
+}
+
+/* ===== ARRAYS ===== */
+static fd_array_t *fd_array_alloc(uint32_t capacity) {
+    size_t files_size = capacity * sizeof(file_t *);
+    size_t bitmap_size = fd_bitmap_words(capacity) * sizeof(uint64_t);
+
+    fd_array_t *array = (fd_array_t *)malloc(sizeof(fd_array_t) + files_size + bitmap_size);
+    if (!array) return NULL;
+
+    array->capacity = capacity;
+    array->retired = NULL;
+    array->bitmap = (uint64_t *)((uint8_t *)array->files + files_size);
+    memset(array->files, 0, files_size + bitmap_size);
+    return array;
+}
+
+/* Caller holds table->lock */
+static bool fd_table_grow(fd_table_t *table, uint32_t min_capacity) {
+    fd_array_t *old = table->array;
+    uint32_t capacity = old->capacity;
+
+    while (capacity < min_capacity) capacity *= 2;
+    if (capacity > FD_MAX_FILES) return false;
+
+    fd_array_t *array = fd_array_alloc(capacity);
+    if (!array) return false;
+
+    memcpy(array->files, old->files, old->capacity * sizeof(file_t *));
+    memcpy(array->bitmap, old->bitmap, fd_bitmap_words(old->capacity) * sizeof(uint64_t));
+    array->retired = old;
+
+    /* Readers see either the old array or the complete new one */
+    __atomic_store_n(&table->array, array, __ATOMIC_RELEASE);
+    return true;
+}
+
+/* ===== TABLE LIFETIME ===== */
+fd_table_t *fd_table_create(void) {
+    fd_table_t *table = (fd_table_t *)malloc(sizeof(fd_table_t));
+    if (!table) return NULL;
+
+    table->array = fd_array_alloc(FD_INITIAL_CAPACITY);
+    if (!table->array) {
+        free(table);
+        return NULL;
+    }
+    table->count = 0;
+    table->first_free_word = 0;
+    spinlock_init(&table->lock);
+    return table;
+}
+
+void fd_table_destroy(fd_table_t *table) {
+    if (!table) return;
+
+    fd_array_t *array = table->array;
+    while (array) {
+        fd_array_t *retired = array->retired;
+        free(array);
+        array = retired;
+    }
+    free(table);
+}
+
+void fd_table_clear(fd_table_t *table) {
+    spinlock_acquire(&table->lock);
+
+    fd_array_t *array = table->array;
+    for (uint32_t i = 0; i < array->capacity; i++) {
+        __atomic_store_n(&array->files[i], NULL, __ATOMIC_RELEASE);
+    }
+    memset(array->bitmap, 0, fd_bitmap_words(array->capacity) * sizeof(uint64_t));
+    table->count = 0;
+    table->first_free_word = 0;
+
+    spinlock_release(&table->lock);
+}
+
+int fd_table_copy(fd_table_t *dst, fd_table_t *src) {
+    spinlock_acquire(&src->lock);
+    spinlock_acquire(&dst->lock);
+
+    fd_array_t *from = src->array;
+    int result = 0;
+
+    if (dst->array->capacity < from->capacity && !fd_table_grow(dst, from->capacity)) {
+        result = -1;
+    } else {
+        fd_array_t *to = dst->array;
+        for (uint32_t i = 0; i < from->capacity; i++) {
+            __atomic_store_n(&to->files[i], from->files[i], __ATOMIC_RELEASE);
+        }
+        memcpy(to->bitmap, from->bitmap, fd_bitmap_words(from->capacity) * sizeof(uint64_t));
+        dst->count = src->count;
+        dst->first_free_word = src->first_free_word;
+    }
+
+    spinlock_release(&dst->lock);
+    spinlock_release(&src->lock);
+    return result;
+}
+
+/* ===== ALLOCATION ===== */
+int fd_alloc(fd_table_t *table, file_t *file) {
+    spinlock_acquire(&table->lock);
+
+    fd_array_t *array = table->array;
+    uint32_t words = fd_bitmap_words(array->capacity);
+    uint32_t word = table->first_free_word;
+
+    /* One test per 64 descriptors; the hint skips fully used words */
+    while (word < words && array->bitmap[word] == ~0ULL) word++;
+
+    uint32_t fd = word < words
+                  ? word * FD_BITS_PER_WORD + (uint32_t)__builtin_ctzll(~array->bitmap[word])
+                  : array->capacity;
+
+    /* Capacity may end mid-word: bits past it are never set */
+    if (fd >= array->capacity) {
+        fd = array->capacity;
+        if (!fd_table_grow(table, array->capacity + 1)) {
+            spinlock_release(&table->lock);
+            return -1;
+        }
+        array = table->array;
+    }
+
+    array->bitmap[fd / FD_BITS_PER_WORD] |= 1ULL << (fd % FD_BITS_PER_WORD);
+    __atomic_store_n(&array->files[fd], file, __ATOMIC_RELEASE);
+    table->count++;
+    table->first_free_word = fd / FD_BITS_PER_WORD;
+
+    spinlock_release(&table->lock);
+    return (int)fd;
+}
+
+file_t *fd_close(fd_table_t *table, int fd) {
+    spinlock_acquire(&table->lock);
+
+    fd_array_t *array = table->array;
+    if ((uint32_t)fd >= array->capacity ||
+        !(array->bitmap[fd / FD_BITS_PER_WORD] & (1ULL << (fd % FD_BITS_PER_WORD)))) {
+        spinlock_release(&table->lock);
+        return NULL;
+    }
+
+    file_t *file = array->files[fd];
+    __atomic_store_n(&array->files[fd], NULL, __ATOMIC_RELEASE);
+    array->bitmap[fd / FD_BITS_PER_WORD] &= ~(1ULL << (fd % FD_BITS_PER_WORD));
+    table->count--;
+    if ((uint32_t)fd / FD_BITS_PER_WORD < table->first_free_word) {
+        table->first_free_word = fd / FD_BITS_PER_WORD;
+    }
+
+    spinlock_release(&table->lock);
+    return file;
+}
@@ -0,0 +1,243 @@
+/*
+ * Interrupt Handling
+ * 8259 PIC routing, the PIT tick and CPU exception reporting
+ *
+ * The IDT and entry stubs live next to the GDT (src/kernel/memory/
+ * gdt_idt.c); this file decides what the vectors do. Legacy IRQs are
+ * remapped to IRQ_BASE and stay masked until a driver registers for
+ * them. The timer tick preempts a process that has used up its
+ * real-time budget. An exception taken in ring 3 ends the process and
+ * unwinds to the syscall_run_user() frame that entered it; one taken in
+ * the kernel is fatal. Page faults in the user half are first offered to
+ * the VMM, which pages anonymous and image memory in on demand.
+ */
+
+#include <kernel/idt.h>
+#include <kernel/kernel.h>
+#include <kernel/cpu.h>
+#include <kernel/process.h>
+#include <kernel/syscall.h>
+#include <kernel/time.h>
+#include <kernel/percpu.h>
+#include <kernel/vmm.h>
+#include <kernel/prof.h>
+#include <memory.h>
+
+/* ===== 8259 PIC ===== */
+#define PIC1_COMMAND        0x20
+#define PIC1_DATA           0x21
+#define PIC2_COMMAND        0xA0
+#define PIC2_DATA           0xA1
+#define PIC_EOI             0x20
+#define PIC_READ_ISR        0x0B
+#define PIC_ICW1_INIT       0x11    /* Edge triggered, cascade, ICW4 follows */
+#define PIC_ICW4_8086       0x01
+
+/* ===== PIT ===== */
+#define PIT_HZ              1193182
+#define PIT_CHANNEL0        0x40
+#define PIT_COMMAND         0x43
+#define PIT_CH0_RATE        0x34    /* Channel 0, lo/hi byte, mode 2 */
+
+/* ===== STATE ===== */
+static irq_handler_t irq_handlers[IRQ_COUNT];
+static uint16_t irq_mask_bits = 0xFFFF;
+
+static const char *const exception_names[IDT_EXCEPTIONS] = {
+    "divide error", "debug", "NMI", "breakpoint", "overflow",
+    "bound range", "invalid opcode", "device not available",
+    "double fault", "coprocessor overrun", "invalid TSS",
+    "segment not present", "stack fault", "general protection",
+    "page fault", "reserved", "x87 FP error", "alignment check",
+    "machine check", "SIMD FP error", "virtualization", "control protection",
+    "reserved", "reserved", "reserved", "reserved", "reserved", "reserved",
+    "hypervisor injection", "VMM communication", "security", "reserved",
+};
+
+static inline void io_wait(void) {
+    outb(0x80, 0);
+}
+
+static void pic_write_mask(void) {
+    outb(PIC1_DATA, irq_mask_bits & 0xFF);
+    outb(PIC2_DATA, irq_mask_bits >> 8);
+}
+
+static void pic_remap(void) {
+    outb(PIC1_COMMAND, PIC_ICW1_INIT); io_wait();
+    outb(PIC2_COMMAND, PIC_ICW1_INIT); io_wait();
+    outb(PIC1_DATA, IRQ_BASE);         io_wait();
+    outb(PIC2_DATA, IRQ_BASE + 8);     io_wait();
+    outb(PIC1_DATA, 1 << IRQ_CASCADE); io_wait();
+    outb(PIC2_DATA, 2);                io_wait();   /* Slave identity */
+    outb(PIC1_DATA, PIC_ICW4_8086);    io_wait();
+    outb(PIC2_DATA, PIC_ICW4_8086);    io_wait();
+
+    /* Everything masked except the cascade to the slave */
+    irq_mask_bits = 0xFFFF & ~(1 << IRQ_CASCADE);
+    pic_write_mask();
+}
+
+/* IRQ 7 and 15 also fire spuriously; the ISR bit tells a real one apart */
+static bool pic_spurious(uint32_t irq) {
+    if (irq == 7) {
+        outb(PIC1_COMMAND, PIC_READ_ISR);
+        return !(inb(PIC1_COMMAND) & 0x80);
+    }
+    if (irq == 15) {
+        outb(PIC2_COMMAND, PIC_READ_ISR);
+        if (!(inb(PIC2_COMMAND) & 0x80)) {
+            outb(PIC1_COMMAND, PIC_EOI);    /* The master did see the cascade */
+            return true;
+        }
+    }
+    return false;
+}
+
+/* ===== IRQ DISPATCH ===== */
+static void irq_dispatch(interrupt_frame_t *frame) {
+    uint32_t irq = (uint32_t)frame->vector - IRQ_BASE;
+    if (pic_spurious(irq)) return;
+
+    irq_handler_t handler = irq_handlers[irq];
+    if (handler) {
+        handler(irq);
+    }
+
+    if (irq >= 8) {
+        outb(PIC2_COMMAND, PIC_EOI);
+    }
+    outb(PIC1_COMMAND, PIC_EOI);
+
+    /*
+     * Spinlocks leave interrupts on, so kernel code may be preempted only
+     * where it holds none: on the way back to ring 3. Kernel threads
+     * yield on their own and are throttled at that switch.
+     */
+    if (this_cpu_read(need_resched) && interrupt_from_user(frame)) {
+        interrupts_enable();
+        scheduler_switch();
+        interrupts_disable();
+    }
+}
+
+int irq_register(uint32_t irq, irq_handler_t handler) {
+    if (irq >= IRQ_COUNT || irq == IRQ_CASCADE || !handler) return -1;
+    irq_handlers[irq] = handler;
+    irq_unmask(irq);
+    return 0;
+}
+
+void irq_mask(uint32_t irq) {
+    if (irq >= IRQ_COUNT) return;
+    irq_mask_bits |= (uint16_t)(1 << irq);
+    pic_write_mask();
+}
+
+void irq_unmask(uint32_t irq) {
+    if (irq >= IRQ_COUNT) return;
+    irq_mask_bits &= (uint16_t)~(1 << irq);
+    pic_write_mask();
+}
+
+/* ===== TIMER ===== */
+static void irq_timer(uint32_t irq) {
+    (void)irq;
+    prof_tick();
+    scheduler_tick();
+}
+
+static void pit_start(uint32_t hz) {
+    uint32_t divisor = PIT_HZ / hz;
+    outb(PIT_COMMAND, PIT_CH0_RATE);
+    outb(PIT_CHANNEL0, divisor & 0xFF);
+    outb(PIT_CHANNEL0, (divisor >> 8) & 0xFF);
+}
+
+/* ===== EXCEPTIONS ===== */
+static void interrupt_exception(interrupt_frame_t *frame) {
+    uint32_t vector = (uint32_t)frame->vector;
+
+    kernel_log("FAULT", "%s (vector %u) error %lx at rip %lx, rsp %lx, cr2 %lx",
+               exception_names[vector], vector, frame->error,
+               frame->rip, frame->rsp, read_cr2());
+
+    if (interrupt_from_user(frame)) {
+        /* Ring 3 is only entered through syscall_run_user(): unwind to it */
+        process_t *proc = process_get_current();
+        if (proc) {
+            process_exit(proc->pid, (int)SYSCALL_EFAULT);
+        }
+        syscall_return_to_kernel((uint64_t)-1);
+    }
+
+    KPANIC("Unhandled CPU exception in kernel mode");
+}
+
+/*
+ * Resolve against whatever space CR3 holds, whoever touched it: the
+ * kernel reaches user memory too (uring rings, IPC buffers). CR2 is read
+ * before interrupts come back on, since a nested fault would replace it.
+ * Resolving may wait for a TLB shootdown, so run with the interrupted
+ * context's IF rather than the gate's cleared one.
+ */
+static void interrupt_page_fault(interrupt_frame_t *frame) {
+    vaddr_t addr = read_cr2();
+    address_space_t *as = this_cpu_read(active_as);
+    this_cpu_inc(stats.page_faults);
+
+    if (frame->rflags & RFLAGS_IF) {
+        interrupts_enable();
+    }
+    if (as && addr < USER_SPACE_END &&
+        vmm_handle_fault(as, addr, frame->error) == VMM_FAULT_RESOLVED) {
+        return;
+    }
+    interrupts_disable();
+    interrupt_exception(frame);
+}
+
+/* The profiler's tick sends the only NMIs; anything else is just counted (idt_dispatch) */
+static void interrupt_nmi(interrupt_frame_t *frame) {
+    (void)frame;
+    prof_sample();
+}
+
+/* ===== INITIALIZATION ===== */
+void irq_init(void) {
+    idt_init();
+
+    for (uint32_t v = 0; v < IDT_EXCEPTIONS; v++) {
+        idt_register_handler(v, interrupt_exception);
+    }
+    idt_register_handler(VEC_NMI, interrupt_nmi);
+    idt_register_handler(VEC_PAGE_FAULT, interrupt_page_fault);
+
+    pic_remap();
+    for (uint32_t irq = 0; irq < IRQ_COUNT; irq++) {
+        idt_register_handler(IRQ_BASE + irq, irq_dispatch);
+    }
+
+    pit_start(IRQ_TIMER_HZ);
+    irq_register(IRQ_TIMER, irq_timer);
+
+    KINFO("IDT loaded: PIC at vector %u, timer %u Hz", IRQ_BASE, IRQ_TIMER_HZ);
+}
+
+/* ===== STATISTICS ===== */
+void irq_dump_stats(void) {
+    KINFO("=== Interrupt Statistics ===");
+    for (uint32_t v = 0; v < IDT_VECTORS; v++) {
+        const idt_vector_stats_t *s = idt_get_stats(v);
+        if (!s->count) continue;
+
+        uint64_t avg_ns = time_cycles_to_ns(s->cycles / s->count);
+        if (v < IDT_EXCEPTIONS) {
+            KINFO("  vec %u (%s): %lu, avg %lu ns", v, exception_names[v], s->count, avg_ns);
+        } else if (v < IRQ_BASE + IRQ_COUNT) {
+            KINFO("  vec %u (IRQ %u): %lu, avg %lu ns", v, v - IRQ_BASE, s->count, avg_ns);
+        } else {
+            KINFO("  vec %u: %lu, avg %lu ns", v, s->count, avg_ns);
+        }
+    }
+}
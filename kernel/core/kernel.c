@@ -4,150 +4,276 @@
  */
 
 #include <kernel/kernel.h>
+#include <kernel/gdt.h>
+#include <kernel/idt.h>
+#include <kernel/tlb.h>
+#include <kernel/percpu.h>
+#include <kernel/syscall.h>
+#include <kernel/ipc.h>
+#include <kernel/uring.h>
+#include <kernel/klog.h>
+#include <kernel/time.h>
+#include <kernel/vmm.h>
+#include <drivers/serial.h>
+#include <drivers/fbcon.h>
 #include <stddef.h>
 #include <stdarg.h>
 #include <vga.h>
+#include <memory.h>
 
 /* ===== KERNEL STATE ===== */
 kernel_state_t kernel_state = KERNEL_STATE_BOOTING;
 struct boot_info bootinfo = {0};
 
+#define KERNEL_PANIC_REPLAY 8       /* Log records shown under the panic banner */
+
+static pmm_t kernel_pmm;
 static vga_terminal_t kernel_log_terminal;
-static spinlock_t kernel_log_lock;
+static bool kernel_console_fb = false;
+static bool kernel_log_muted = false;
+
+static void kernel_log_console_sink(const klog_record_t *rec);
+static void kernel_log_serial_sink(const klog_record_t *rec);
+
+/* ===== CONSOLE ===== */
+static void kernel_console_color(vga_color_t fg, vga_color_t bg) {
+    if (kernel_console_fb) {
+        fbcon_set_color(fg, bg);
+    } else {
+        vga_set_color(&kernel_log_terminal, fg, bg);
+    }
+}
+
+static void kernel_console_clear(void) {
+    if (kernel_console_fb) {
+        fbcon_clear();
+    } else {
+        vga_clear_screen(&kernel_log_terminal);
+    }
+}
+
+static void kernel_console_print(const char *str) {
+    if (kernel_console_fb) {
+        fbcon_write(str);
+    } else {
+        vga_print(&kernel_log_terminal, str);
+    }
+}
+
+static void kernel_console_println(const char *str) {
+    if (kernel_console_fb) {
+        fbcon_write(str);
+        fbcon_putchar('\n');
+    } else {
+        vga_println(&kernel_log_terminal, str);
+    }
+}
+
+/* ===== MEMORY ===== */
+/*
+ * The PMM spans RAM up to the end of the highest usable region, with
+ * its bitmap in the first pages of the first region that has room.
+ * Then the kernel's own page tables replace Limine's, with the direct
+ * map where the HHDM was, and the VMM starts on them.
+ */
+static int kernel_memory_init(void) {
+    uint64_t top = 0;
+    for (uint32_t i = 0; i < bootinfo.num_usable; i++) {
+        top = MAX(top, bootinfo.usable[i].base + bootinfo.usable[i].length);
+    }
+    uint32_t frames = (uint32_t)MIN(top / PAGE_SIZE, (uint64_t)PMM_MAX_FRAMES);
+    uint64_t bitmap_size = ALIGN_UP(((uint64_t)frames + 7) / 8, PAGE_SIZE);
+
+    const boot_region_t *home = NULL;
+    for (uint32_t i = 0; i < bootinfo.num_usable && !home; i++) {
+        if (bootinfo.usable[i].length >= bitmap_size) {
+            home = &bootinfo.usable[i];
+        }
+    }
+    if (!frames || !home) return -1;
+
+    pmm_init_used(&kernel_pmm, (uint8_t *)phys_to_virt(home->base), frames);
+    for (uint32_t i = 0; i < bootinfo.num_usable; i++) {
+        pmm_mark_region_free(&kernel_pmm, bootinfo.usable[i].base, bootinfo.usable[i].length);
+    }
+    pmm_mark_region_used(&kernel_pmm, home->base, bitmap_size);
+
+    KINFO("PMM: %u of %u frames free (%lu MiB usable)", pmm_get_free_frames(&kernel_pmm),
+          frames, bootinfo.usable_memory >> 20);
+
+    if (paging_init(&kernel_pmm, bootinfo.phys_top, bootinfo.phys_offset) == 0) {
+        paging_enable();
+    } else {
+        KWARN("Out of frames for page tables: staying on the bootloader's");
+    }
+
+    vmm_init(&kernel_pmm, bootinfo.phys_offset);
+    return 0;
+}
 
 /* ===== INITIALIZATION ===== */
-void kernel_init(void *limine_bootloader_info) {
-    spinlock_init(&kernel_log_lock);
+void kernel_init(void) {
+    /* Limine's HHDM: MMIO and page tables are reached through phys_to_virt() */
+    vmm_phys_offset = bootinfo.phys_offset;
+    klog_init();
     
-    /* Initialize VGA logging */
-    uint16_t *vga_buffer = (uint16_t *)0xB8000;
-    vga_initilize(&kernel_log_terminal, vga_buffer, 80, 25);
-    vga_clear_screen(&kernel_log_terminal);
+    /* Serial first: headless runs (make bench) only see COM1 */
+    serial_init();
+    
+    /* In a graphics mode the VGA text buffer is not on screen: use the framebuffer */
+    kernel_console_fb = fbcon_init() == 0;
+    if (!kernel_console_fb) {
+        uint16_t *vga_buffer = (uint16_t *)phys_to_virt(0xB8000);
+        vga_initilize(&kernel_log_terminal, vga_buffer, 80, 25);
+        vga_clear_screen(&kernel_log_terminal);
+    }
+    if (serial_ready()) {
+        klog_add_sink(kernel_log_serial_sink);
+    }
+#ifdef CONFIG_BENCH_BOOT
+    /* Headless: nobody looks at the screen when the UART is there */
+    if (!serial_ready())
+#endif
+    klog_add_sink(kernel_log_console_sink);
     
     /* Print boot banner */
-    vga_set_color(&kernel_log_terminal, VGA_COLOR_LIGHT_CYAN, VGA_COLOR_BLACK);
-    vga_println(&kernel_log_terminal, "╔════════════════════════════════════════╗");
-    vga_println(&kernel_log_terminal, "║     PuppetOS Kernel v0.4.0              ║");
-    vga_println(&kernel_log_terminal, "║     64-bit Operating System             ║");
-    vga_println(&kernel_log_terminal, "║     Modern x86-64 Architecture          ║");
-    vga_println(&kernel_log_terminal, "╚════════════════════════════════════════╝");
-    vga_set_color(&kernel_log_terminal, VGA_COLOR_WHITE, VGA_COLOR_BLACK);
-    vga_println(&kernel_log_terminal, "");
+    kernel_console_color(VGA_COLOR_LIGHT_CYAN, VGA_COLOR_BLACK);
+    kernel_console_println("╔════════════════════════════════════════╗");
+    kernel_console_println("║     PuppetOS Kernel v0.4.0              ║");
+    kernel_console_println("║     64-bit Operating System             ║");
+    kernel_console_println("║     Modern x86-64 Architecture          ║");
+    kernel_console_println("╚════════════════════════════════════════╝");
+    kernel_console_color(VGA_COLOR_WHITE, VGA_COLOR_BLACK);
+    kernel_console_println("");
     
     KINFO("Kernel initialization starting...");
-    KINFO("Bootloader: %s", limine_bootloader_info ? "Limine" : "Unknown");
+    KINFO("Bootloader: Limine (HHDM at %lx)", bootinfo.phys_offset);
     KINFO("CPU: x86-64 (AMD64)");
     KINFO("Boot time: %s %s", PUPPETOS_BUILD_DATE, PUPPETOS_BUILD_TIME);
     
+    /* Own GDT/TSS first: SYSCALL/SYSRET depend on its selector layout, and Limine's goes with its tables */
+    gdt_init();
+    if (kernel_memory_init() != 0) {
+        KWARN("No usable memory map: running without the PMM and VMM");
+    }
+    if (paging_init_pat() != 0) {
+        KWARN("No PAT: framebuffer stays at the firmware's memory type");
+    }
+    percpu_init(0);
+    syscall_init();
+    irq_init();
+    serial_enable_interrupts();
+    tlb_init();
+    ipc_init();
+    uring_init();
+    
+    /* Handlers only touch per-CPU counters so far: safe from here on */
+    interrupts_enable();
+    
     kernel_state = KERNEL_STATE_RUNNING;
     
     KINFO("Kernel ready!");
 }
 
 /* ===== LOGGING ===== */
+/*
+ * kernel_log() only formats into the log ring (<kernel/klog.h>); these
+ * sinks print each drained record on the screen and on COM1, one whole
+ * line per call.
+ */
+static void kernel_log_console_sink(const klog_record_t *rec) {
+    bool warn = rec->level[0] == 'W';
+
+    kernel_console_color(warn ? VGA_COLOR_LIGHT_YELLOW : VGA_COLOR_LIGHT_GREEN, VGA_COLOR_BLACK);
+    kernel_console_print("[");
+    kernel_console_print(rec->level);
+    kernel_console_print("] ");
+    kernel_console_color(VGA_COLOR_WHITE, VGA_COLOR_BLACK);
+    kernel_console_println(rec->text);
+}
+
+static void kernel_log_serial_sink(const klog_record_t *rec) {
+    char line[KLOG_TEXT_MAX + 16];
+    klog_format(line, sizeof(line), "[%s] %s\n", rec->level, rec->text);
+    serial_write(line);
+}
+
+void kernel_log_mute(bool muted) {
+    __atomic_store_n(&kernel_log_muted, muted, __ATOMIC_RELAXED);
+}
+
 void kernel_log(const char *level, const char *format, ...) {
-    spinlock_acquire(&kernel_log_lock);
-    
+    if (__atomic_load_n(&kernel_log_muted, __ATOMIC_RELAXED)) return;
+
     va_list args;
     va_start(args, format);
-    
-    vga_set_color(&kernel_log_terminal, VGA_COLOR_LIGHT_GREEN, VGA_COLOR_BLACK);
-    vga_print(&kernel_log_terminal, "[");
-    vga_print(&kernel_log_terminal, level);
-    vga_print(&kernel_log_terminal, "] ");
-    vga_set_color(&kernel_log_terminal, VGA_COLOR_WHITE, VGA_COLOR_BLACK);
-    
-    // Simple format string handling
-    const char *p = format;
-    while (*p) {
-        if (*p == '%' && *(p + 1)) {
-            switch (*(p + 1)) {
-                case 'd': {
-                    int val = va_arg(args, int);
-                    char buf[32];
-                    int len = 0;
-                    if (val < 0) {
-                        buf[len++] = '-';
-                        val = -val;
-                    }
-                    do {
-                        buf[len++] = '0' + (val % 10);
-                        val /= 10;
-                    } while (val > 0);
-                    for (int i = len - 1; i >= (buf[0] == '-' ? 1 : 0); i--) {
-                        vga_print(&kernel_log_terminal, (char[]){buf[i], 0});
-                    }
-                    if (buf[0] == '-') vga_print(&kernel_log_terminal, "-");
-                    p += 2;
-                    break;
-                }
-                case 's': {
-                    const char *str = va_arg(args, const char *);
-                    vga_print(&kernel_log_terminal, (char *)str);
-                    p += 2;
-                    break;
-                }
-                case 'x': {
-                    uint32_t val = va_arg(args, uint32_t);
-                    vga_print(&kernel_log_terminal, "0x");
-                    for (int i = 7; i >= 0; i--) {
-                        uint8_t nibble = (val >> (i * 4)) & 0xF;
-                        vga_print(&kernel_log_terminal, (char[]){
-                            "0123456789ABCDEF"[nibble], 0
-                        });
-                    }
-                    p += 2;
-                    break;
-                }
-                default:
-                    vga_print(&kernel_log_terminal, "%");
-                    p++;
-                    break;
-            }
-        } else {
-            vga_print(&kernel_log_terminal, (char[]){*p, 0});
-            p++;
-        }
-    }
-    
-    vga_println(&kernel_log_terminal, "");
-    
+    klog_write(level, format, args);
     va_end(args);
-    spinlock_release(&kernel_log_lock);
+}
+
+/*
+ * Once the WM owns the framebuffer the console sink would draw (and
+ * scroll) underneath it. Whatever is already logged goes out first;
+ * after that only serial sees the log, and only a panic draws.
+ */
+void kernel_console_detach(void) {
+    if (!kernel_console_fb) return;
+    klog_flush();
+    klog_remove_sink(kernel_log_console_sink);
 }
 
 void kernel_warn(const char *format, ...) {
-    spinlock_acquire(&kernel_log_lock);
-    
-    vga_set_color(&kernel_log_terminal, VGA_COLOR_LIGHT_YELLOW, VGA_COLOR_BLACK);
-    vga_print(&kernel_log_terminal, "[WARN] ");
-    vga_set_color(&kernel_log_terminal, VGA_COLOR_WHITE, VGA_COLOR_BLACK);
-    
-    // Format and print (simplified)
-    vga_println(&kernel_log_terminal, (char *)format);
-    
-    spinlock_release(&kernel_log_lock);
+    va_list args;
+    va_start(args, format);
+    klog_write("WARN", format, args);
+    va_end(args);
+}
+
+/* Replayed under the panic banner, with when each line was logged */
+static void kernel_panic_log_line(const klog_record_t *rec) {
+    uint64_t base, mult;
+    time_get_scale(&base, &mult);
+    uint64_t us = (mult && rec->tsc > base) ? time_cycles_to_ns(rec->tsc - base) / 1000 : 0;
+
+    char line[KLOG_TEXT_MAX + 48];
+    klog_format(line, sizeof(line), "[%lu us cpu%u] [%s] %s", us, (uint32_t)rec->cpu,
+                rec->level, rec->text);
+    kernel_console_println(line);
+    serial_write(line);
+    serial_write("\n");
 }
 
 void kernel_panic(const char *format, ...) {
     asm volatile("cli");  /* Disable interrupts */
     
-    spinlock_acquire(&kernel_log_lock);
-    vga_set_color(&kernel_log_terminal, VGA_COLOR_WHITE, VGA_COLOR_RED);
-    vga_clear_screen(&kernel_log_terminal);
-    vga_println(&kernel_log_terminal, "");
-    vga_println(&kernel_log_terminal, "╔════════════════════════════════════════╗");
-    vga_println(&kernel_log_terminal, "║           KERNEL PANIC                  ║");
-    vga_println(&kernel_log_terminal, "╚════════════════════════════════════════╝");
-    vga_println(&kernel_log_terminal, "");
+    /* serial_lock may be held by whoever we interrupted: poll from here on */
+    serial_panic();
+    
+    /* Whatever was still queued goes out before the screen is taken over */
+    klog_panic();
+    
+    kernel_console_color(VGA_COLOR_WHITE, VGA_COLOR_RED);
+    kernel_console_clear();
+    kernel_console_println("");
+    kernel_console_println("╔════════════════════════════════════════╗");
+    kernel_console_println("║           KERNEL PANIC                  ║");
+    kernel_console_println("╚════════════════════════════════════════╝");
+    kernel_console_println("");
     
     // Print panic message (simplified)
-    vga_println(&kernel_log_terminal, (char *)format);
-    vga_println(&kernel_log_terminal, "");
-    vga_println(&kernel_log_terminal, "System halted.");
+    kernel_console_println((char *)format);
+    serial_write(format);
+    serial_write("\n");
+    kernel_console_println("");
+    
+    kernel_console_println("Last log records:");
+    serial_write("Last log records:\n");
+    klog_replay(KERNEL_PANIC_REPLAY, kernel_panic_log_line);
+    kernel_console_println("");
+    kernel_console_println("System halted.");
     
     kernel_state = KERNEL_STATE_PANIC;
-    spinlock_release(&kernel_log_lock);
+    serial_flush();             /* Until the last byte has left the UART */
     
     while (1) {
         asm volatile("hlt");
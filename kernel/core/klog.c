@@ -0,0 +1,358 @@
+/*
+ * Kernel Log Ring Implementation
+ * Slot reservation, record formatting and the merging drainer
+ *
+ * A producer reserves a position with one atomic add on its ring's
+ * head, clears the slot's seq, fills the slot and publishes it by
+ * storing seq = position + 1. Interrupt handlers on the same CPU and
+ * CPUs sharing a ring simply reserve the next position. The drainer
+ * copies a slot and re-checks seq, so a slot lapped while it was being
+ * read is counted as dropped rather than printed half-overwritten.
+ */
+
+#include <kernel/klog.h>
+#include <kernel/kernel.h>
+#include <kernel/percpu.h>
+#include <kernel/process.h>
+#include <kernel/time.h>
+#include <kernel/cpu.h>
+#include <string.h>
+
+#define KLOG_SLOT_MASK      (KLOG_RING_SLOTS - 1)
+#define KLOG_MAX_SINKS      4
+
+_Static_assert((KLOG_RING_SLOTS & KLOG_SLOT_MASK) == 0, "KLOG_RING_SLOTS must be a power of two");
+
+/* ===== STATE ===== */
+klog_ring_t klog_rings[KLOG_RINGS];
+
+static klog_sink_t klog_sinks[KLOG_MAX_SINKS];
+static uint32_t klog_num_sinks = 0;
+static bool klog_draining = false;  /* Only one drainer at a time; never waited on */
+static bool klog_daemon = false;
+
+/* Drainer-only scratch, kept off the (possibly interrupt) stack */
+static klog_record_t klog_next[KLOG_RINGS];
+static bool klog_have[KLOG_RINGS];
+static const klog_record_t *klog_replay_list[KLOG_RINGS * KLOG_RING_SLOTS];
+
+/* GS is only valid once percpu_init() has run */
+static inline uint32_t klog_cpu(void) {
+    return percpu_count() ? this_cpu_read(cpu_id) : 0;
+}
+
+/* ===== FORMATTING ===== */
+typedef struct {
+    char *buf;
+    size_t size;
+    size_t len;
+} klog_out_t;
+
+static inline void klog_putc(klog_out_t *out, char c) {
+    if (out->len + 1 < out->size) {
+        out->buf[out->len++] = c;
+    }
+}
+
+static void klog_puts(klog_out_t *out, const char *str) {
+    if (!str) str = "(null)";
+    while (*str) {
+        klog_putc(out, *str++);
+    }
+}
+
+static void klog_put_u64(klog_out_t *out, uint64_t val) {
+    char digits[20];
+    int len = 0;
+    do {
+        digits[len++] = (char)('0' + val % 10);
+        val /= 10;
+    } while (val > 0);
+    while (len > 0) {
+        klog_putc(out, digits[--len]);
+    }
+}
+
+static void klog_put_hex(klog_out_t *out, uint64_t val, int nibbles) {
+    klog_puts(out, "0x");
+    for (int i = nibbles - 1; i >= 0; i--) {
+        klog_putc(out, "0123456789ABCDEF"[(val >> (i * 4)) & 0xF]);
+    }
+}
+
+/* Same conversions kernel_log() has always taken: %d %u %x %s %ld %lu %lx */
+size_t klog_vformat(char *buf, size_t size, const char *format, va_list args) {
+    klog_out_t out = { buf, size, 0 };
+    const char *p = format;
+
+    while (*p) {
+        if (*p != '%' || !p[1]) {
+            klog_putc(&out, *p++);
+            continue;
+        }
+
+        switch (p[1]) {
+            case 'd': {
+                int val = va_arg(args, int);
+                if (val < 0) {
+                    klog_putc(&out, '-');
+                    klog_put_u64(&out, (uint64_t)0 - (uint64_t)(int64_t)val);
+                } else {
+                    klog_put_u64(&out, (uint64_t)val);
+                }
+                p += 2;
+                break;
+            }
+            case 's':
+                klog_puts(&out, va_arg(args, const char *));
+                p += 2;
+                break;
+            case 'u':
+                klog_put_u64(&out, va_arg(args, uint32_t));
+                p += 2;
+                break;
+            case 'x':
+                klog_put_hex(&out, va_arg(args, uint32_t), 8);
+                p += 2;
+                break;
+            case 'l':
+                if (p[2] == 'd') {
+                    int64_t val = va_arg(args, int64_t);
+                    if (val < 0) {
+                        klog_putc(&out, '-');
+                        klog_put_u64(&out, (uint64_t)0 - (uint64_t)val);
+                    } else {
+                        klog_put_u64(&out, (uint64_t)val);
+                    }
+                } else if (p[2] == 'u') {
+                    klog_put_u64(&out, va_arg(args, uint64_t));
+                } else if (p[2] == 'x') {
+                    klog_put_hex(&out, va_arg(args, uint64_t), 16);
+                } else {
+                    klog_putc(&out, '%');
+                    p++;
+                    break;
+                }
+                p += 3;
+                break;
+            default:
+                klog_putc(&out, '%');
+                p++;
+                break;
+        }
+    }
+
+    if (size) buf[out.len] = '\0';
+    return out.len;
+}
+
+size_t klog_format(char *buf, size_t size, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    size_t len = klog_vformat(buf, size, format, args);
+    va_end(args);
+    return len;
+}
+
+/* ===== PRODUCERS ===== */
+void klog_write(const char *level, const char *format, va_list args) {
+    uint32_t cpu = klog_cpu();
+    klog_ring_t *ring = &klog_rings[cpu % KLOG_RINGS];
+
+    uint64_t pos = __atomic_fetch_add(&ring->head, 1, __ATOMIC_RELAXED);
+    klog_record_t *rec = &ring->slots[pos & KLOG_SLOT_MASK];
+
+    __atomic_store_n(&rec->seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    rec->tsc = rdtsc();
+    rec->level = level;
+    rec->cpu = (uint16_t)cpu;
+    rec->len = (uint16_t)klog_vformat(rec->text, KLOG_TEXT_MAX, format, args);
+
+    __atomic_store_n(&rec->seq, pos + 1, __ATOMIC_RELEASE);
+
+    /* Without klogd, or when the ring is about to lap, drain here */
+    uint64_t backlog = pos - __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    if (!__atomic_load_n(&klog_daemon, __ATOMIC_RELAXED) ||
+        backlog >= KLOG_RING_SLOTS * 3 / 4) {
+        klog_flush();
+    }
+}
+
+/* ===== DRAINING ===== */
+/* Copy the oldest committed record at ring->tail; false if there is none yet */
+static bool klog_peek(klog_ring_t *ring, klog_record_t *out) {
+    for (;;) {
+        uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        uint64_t tail = ring->tail;
+        if (tail == head) return false;
+
+        if (head - tail > KLOG_RING_SLOTS) {
+            ring->dropped += head - tail - KLOG_RING_SLOTS;
+            ring->tail = tail = head - KLOG_RING_SLOTS;
+        }
+
+        klog_record_t *rec = &ring->slots[tail & KLOG_SLOT_MASK];
+        uint64_t seq = __atomic_load_n(&rec->seq, __ATOMIC_ACQUIRE);
+        if (seq != tail + 1) {
+            if (seq > tail + 1) {
+                /* Lapped: a newer record already sits in this slot */
+                ring->dropped++;
+                ring->tail = tail + 1;
+                continue;
+            }
+            return false;               /* Reserved but still being written */
+        }
+
+        memcpy(out, rec, sizeof(*out));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&rec->seq, __ATOMIC_RELAXED) == seq) {
+            return true;
+        }
+    }
+}
+
+static void klog_emit(const klog_record_t *rec) {
+    for (uint32_t i = 0; i < klog_num_sinks; i++) {
+        klog_sinks[i](rec);
+    }
+}
+
+/* Oldest first across all rings; returns the number of records emitted */
+static uint32_t klog_drain(void) {
+    uint32_t emitted = 0;
+
+    for (uint32_t r = 0; r < KLOG_RINGS; r++) {
+        klog_have[r] = klog_peek(&klog_rings[r], &klog_next[r]);
+    }
+
+    for (;;) {
+        int oldest = -1;
+        for (uint32_t r = 0; r < KLOG_RINGS; r++) {
+            if (klog_have[r] && (oldest < 0 || klog_next[r].tsc < klog_next[oldest].tsc)) {
+                oldest = (int)r;
+            }
+        }
+        if (oldest < 0) break;
+
+        klog_emit(&klog_next[oldest]);
+        klog_rings[oldest].tail++;
+        emitted++;
+        klog_have[oldest] = klog_peek(&klog_rings[oldest], &klog_next[oldest]);
+    }
+    return emitted;
+}
+
+static bool klog_pending(void) {
+    for (uint32_t r = 0; r < KLOG_RINGS; r++) {
+        if (__atomic_load_n(&klog_rings[r].head, __ATOMIC_ACQUIRE) != klog_rings[r].tail) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * A CPU that finds a drain in progress leaves its record to that
+ * drainer, which looks again after letting go. A record stuck half
+ * written (its producer interrupted) stops the loop rather than
+ * spinning on it.
+ */
+void klog_flush(void) {
+    uint32_t emitted;
+    do {
+        if (__atomic_exchange_n(&klog_draining, true, __ATOMIC_ACQUIRE)) return;
+        emitted = klog_drain();
+        __atomic_store_n(&klog_draining, false, __ATOMIC_RELEASE);
+    } while (emitted && klog_pending());
+}
+
+static void klog_thread(void *arg) {
+    (void)arg;
+    uint64_t period = time_tsc_hz() / 1000 * KLOG_DRAIN_MS;
+
+    for (;;) {
+        klog_flush();
+        scheduler_sleep_until(rdtsc() + period);
+    }
+}
+
+/* ===== AFTER A PANIC ===== */
+void klog_panic(void) {
+    __atomic_store_n(&klog_draining, true, __ATOMIC_RELAXED);
+    __atomic_store_n(&klog_daemon, false, __ATOMIC_RELAXED);
+    klog_drain();
+}
+
+void klog_replay(uint32_t count, klog_sink_t sink) {
+    uint32_t n = 0;
+
+    for (uint32_t r = 0; r < KLOG_RINGS; r++) {
+        for (uint32_t i = 0; i < KLOG_RING_SLOTS; i++) {
+            const klog_record_t *rec = &klog_rings[r].slots[i];
+            if (rec->seq) klog_replay_list[n++] = rec;
+        }
+    }
+
+    /* Insertion sort by time: short lists, and only ever run on the way down */
+    for (uint32_t i = 1; i < n; i++) {
+        const klog_record_t *rec = klog_replay_list[i];
+        uint32_t j = i;
+        while (j > 0 && klog_replay_list[j - 1]->tsc > rec->tsc) {
+            klog_replay_list[j] = klog_replay_list[j - 1];
+            j--;
+        }
+        klog_replay_list[j] = rec;
+    }
+
+    for (uint32_t i = n > count ? n - count : 0; i < n; i++) {
+        sink(klog_replay_list[i]);
+    }
+}
+
+/* ===== INITIALIZATION ===== */
+void klog_init(void) {
+    memset(klog_rings, 0, sizeof(klog_rings));
+    klog_num_sinks = 0;
+}
+
+int klog_add_sink(klog_sink_t sink) {
+    if (!sink || klog_num_sinks >= KLOG_MAX_SINKS) return -1;
+    klog_sinks[klog_num_sinks++] = sink;
+    return 0;
+}
+
+/* Waits out any drainer, so the sink is never called once this returns */
+int klog_remove_sink(klog_sink_t sink) {
+    while (__atomic_exchange_n(&klog_draining, true, __ATOMIC_ACQUIRE)) {
+        cpu_relax();
+    }
+
+    int ret = -1;
+    for (uint32_t i = 0; i < klog_num_sinks; i++) {
+        if (klog_sinks[i] != sink) continue;
+        for (uint32_t j = i + 1; j < klog_num_sinks; j++) {
+            klog_sinks[j - 1] = klog_sinks[j];
+        }
+        klog_num_sinks--;
+        ret = 0;
+        break;
+    }
+
+    __atomic_store_n(&klog_draining, false, __ATOMIC_RELEASE);
+    return ret;
+}
+
+int klog_start(void) {
+    if (klog_daemon) return 0;
+    if (time_tsc_hz() == 0) {
+        time_init();
+    }
+
+    kpid_t pid = kthread_create("klogd", klog_thread, NULL);
+    if (pid == (kpid_t)-1) return -1;
+
+    __atomic_store_n(&klog_daemon, true, __ATOMIC_RELEASE);
+    return 0;
+}
@@ -0,0 +1,33 @@
+/*
+ * Kernel Symbol Table Lookup
+ * Binary search over the table the build links in
+ */
+
+#include <kernel/ksyms.h>
+
+extern const uint8_t __text_end[];
+
+/* Overridden by the generated table (Makefile: KSYMS_AWK) */
+__attribute__((weak)) const ksym_t ksyms[1];
+__attribute__((weak)) const uint64_t ksyms_count;
+
+const char *ksym_lookup(uint64_t addr, uint64_t *offset) {
+    uint64_t count = ksyms_count;
+    if (count == 0 || addr < ksyms[0].addr || addr >= (uint64_t)(uintptr_t)__text_end) {
+        return NULL;
+    }
+
+    /* Last symbol at or below addr */
+    uint64_t lo = 0, hi = count - 1;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo + 1) / 2;
+        if (ksyms[mid].addr <= addr) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+
+    if (offset) *offset = addr - ksyms[lo].addr;
+    return ksyms[lo].name;
+}
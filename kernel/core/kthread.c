@@ -0,0 +1,95 @@
+/*
+ * Kernel Threads
+ * Stack switching and thread creation for the cooperative scheduler
+ */
+
+#include <kernel/process.h>
+#include <kernel/kernel.h>
+#include <kernel/vmm.h>
+
+void kthread_start(void);
+
+/*
+ * ===== CONTEXT SWITCH =====
+ *
+ * The caller-saved registers are already dead across a call, so only
+ * the callee-saved ones are pushed onto the outgoing stack before its
+ * rsp is stored in *from (rdi). Loading to (rsi) and popping the same
+ * six registers resumes the other context inside its own
+ * context_switch() call, or in kthread_start for a new thread.
+ */
+__asm__(
+    ".text\n"
+    ".global context_switch\n"
+    "context_switch:\n"
+    "    push %rbp\n"
+    "    push %rbx\n"
+    "    push %r12\n"
+    "    push %r13\n"
+    "    push %r14\n"
+    "    push %r15\n"
+    "    mov %rsp, (%rdi)\n"
+    "    mov %rsi, %rsp\n"
+    "    pop %r15\n"
+    "    pop %r14\n"
+    "    pop %r13\n"
+    "    pop %r12\n"
+    "    pop %rbx\n"
+    "    pop %rbp\n"
+    "    ret\n"
+
+    /* First run of a thread: r12 = arg, r13 = fn (see kthread_create) */
+    ".global kthread_start\n"
+    "kthread_start:\n"
+    "    mov %r12, %rdi\n"
+    "    call *%r13\n"
+    "    call kthread_exit\n"
+);
+
+/* ===== THREAD LIFECYCLE ===== */
+int kthread_attach(kpid_t pid, kthread_fn_t fn, void *arg) {
+    paddr_t stack = vmm_alloc_frames(KTHREAD_STACK_PAGES);
+    if (!stack) return -1;
+
+    uint64_t *sp = (uint64_t *)((uint8_t *)phys_to_virt(stack) + KTHREAD_STACK_PAGES * PAGE_SIZE);
+
+    /* Frame context_switch() pops; leaves rsp 16-byte aligned at the call in kthread_start */
+    *--sp = 0;
+    *--sp = (uint64_t)(uintptr_t)kthread_start;
+    *--sp = 0;                          /* rbp */
+    *--sp = 0;                          /* rbx */
+    *--sp = (uint64_t)(uintptr_t)arg;   /* r12 */
+    *--sp = (uint64_t)(uintptr_t)fn;    /* r13 */
+    *--sp = 0;                          /* r14 */
+    *--sp = 0;                          /* r15 */
+
+    if (process_attach_context(pid, (uint64_t)(uintptr_t)sp, stack) != 0) {
+        for (uint32_t i = 0; i < KTHREAD_STACK_PAGES; i++) {
+            vmm_free_frame(stack + (paddr_t)i * PAGE_SIZE);
+        }
+        return -1;
+    }
+    return 0;
+}
+
+kpid_t kthread_create(const char *name, kthread_fn_t fn, void *arg) {
+    kpid_t pid = process_create(name, (vaddr_t)(uintptr_t)fn, 0);
+    if (pid == (kpid_t)-1) return pid;
+
+    if (kthread_attach(pid, fn, arg) != 0) {
+        process_exit(pid, -1);
+        process_reap(pid, NULL);
+        return (kpid_t)-1;
+    }
+    return pid;
+}
+
+void kthread_exit(void) {
+    process_t *self = process_get_current();
+
+    /* The stack stays valid until someone reaps us from another context */
+    process_exit(self->pid, 0);
+    scheduler_switch();
+
+    KPANIC("Exited kernel thread %d was rescheduled", self->pid);
+}
@@ -0,0 +1,59 @@
+/*
+ * Per-CPU Data Implementation
+ * Static per-CPU blocks and GS base setup
+ */
+
+#include <kernel/percpu.h>
+#include <kernel/kernel.h>
+#include <kernel/cpu.h>
+#include <kernel/vdso.h>
+
+_Static_assert(offsetof(cpu_local_t, self) == PERCPU_SELF, "PERCPU_SELF");
+_Static_assert(offsetof(cpu_local_t, kernel_rsp) == PERCPU_KERNEL_RSP, "PERCPU_KERNEL_RSP");
+_Static_assert(offsetof(cpu_local_t, user_rsp) == PERCPU_USER_RSP, "PERCPU_USER_RSP");
+_Static_assert(offsetof(cpu_local_t, stats.syscalls) == PERCPU_STATS_SYSCALLS, "PERCPU_STATS_SYSCALLS");
+
+/* ===== STATE ===== */
+static cpu_local_t cpu_locals[MAX_CPUS];
+static uint32_t cpu_count = 0;
+
+/* ===== INITIALIZATION ===== */
+void percpu_init(uint32_t cpu_id) {
+    if (cpu_id >= MAX_CPUS) {
+        KPANIC("CPU %u beyond MAX_CPUS", cpu_id);
+    }
+
+    cpu_local_t *cpu = &cpu_locals[cpu_id];
+    cpu->self = cpu;
+    cpu->cpu_id = cpu_id;
+
+    /* Kernel runs with GS = this block; user GS, this CPU's vDSO PID slot, waits in KERNEL_GS_BASE */
+    wrmsr(MSR_GS_BASE, (uint64_t)(uintptr_t)cpu);
+    wrmsr(MSR_KERNEL_GS_BASE, VDSO_CPU_SLOT(cpu_id));
+
+    if (cpu_id >= cpu_count) {
+        cpu_count = cpu_id + 1;
+    }
+}
+
+cpu_local_t *percpu_get(uint32_t cpu_id) {
+    return cpu_id < cpu_count ? &cpu_locals[cpu_id] : NULL;
+}
+
+uint32_t percpu_count(void) {
+    return cpu_count;
+}
+
+/* ===== STATISTICS ===== */
+void percpu_dump_stats(void) {
+    KINFO("=== Per-CPU Statistics ===");
+    for (uint32_t i = 0; i < cpu_count; i++) {
+        cpu_stats_t *s = &cpu_locals[i].stats;
+        KINFO("  CPU%u: syscalls %lu, switches %lu, ticks %lu, faults %lu",
+              i, s->syscalls, s->context_switches, s->ticks, s->page_faults);
+        KINFO("        TLB: IPIs sent %lu, pages invalidated %lu, full flushes %lu",
+              s->tlb_ipis, s->tlb_pages, s->tlb_full_flushes);
+        KINFO("        Faults: minor %lu, major %lu, COW %lu, invalid %lu",
+              s->fault_minor, s->fault_major, s->fault_cow, s->fault_invalid);
+    }
+}
@@ -5,46 +5,101 @@
 
 #include <kernel/process.h>
 #include <kernel/kernel.h>
+#include <kernel/vmm.h>
+#include <kernel/elf.h>
+#include <kernel/vdso.h>
+#include <kernel/fd.h>
+#include <kernel/syscall.h>
+#include <kernel/uring.h>
+#include <kernel/percpu.h>
+#include <kernel/gdt.h>
+#include <kernel/cpu.h>
+#include <kernel/time.h>
 #include <stddef.h>
 #include <string.h>
 #include <stdlib.h>
 
 /* ===== PROCESS TABLE ===== */
 #define MAX_PROCESSES 256
+#define INIT_PID      1     /* "idle", created first by scheduler_init(); adopts orphans */
 
-static process_t *process_table[MAX_PROCESSES];
-static uint32_t num_processes = 0;
+/* Dense array of hot halves; scans never leave it */
+static sched_entity_t sched_table[MAX_PROCESSES];
+static run_queue_t run_queue = { .entities = sched_table };
+
+/* Kernel threads in scheduler_sleep_until() */
+static process_t *sleepers[MAX_PROCESSES];
+static uint32_t num_sleepers = 0;
 static kpid_t next_pid = 1;
 static spinlock_t process_table_lock;
 
-static process_t *current_process = NULL;
+/* Reaped descriptors are recycled: the early heap never frees */
+static process_t *process_cache[MAX_PROCESSES];
+static uint32_t process_cache_count = 0;
 
 /* ===== PROCESS CREATION ===== */
-kpid_t process_create(const char *name, vaddr_t entry_point, uid_t uid) {
-    spinlock_acquire(&process_table_lock);
+/* Caller holds process_table_lock */
+static process_t *process_alloc_locked(const char *name, vaddr_t entry_point, uid_t uid) {
+    if (run_queue.count >= MAX_PROCESSES) {
+        return NULL;  /* Error: Process table full */
+    }
     
-    if (num_processes >= MAX_PROCESSES) {
-        spinlock_release(&process_table_lock);
-        return -1;  /* Error: Process table full */
+    process_t *proc;
+    if (process_cache_count > 0) {
+        proc = process_cache[--process_cache_count];
+    } else {
+        proc = (process_t *)malloc(sizeof(process_t));
+        if (!proc) return NULL;
+        proc->files = NULL;
     }
     
-    process_t *proc = (process_t *)malloc(sizeof(process_t));
-    if (!proc) {
-        spinlock_release(&process_table_lock);
-        return -1;
+    /* Recycled descriptors keep their (cleared) fd table */
+    if (!proc->files) {
+        proc->files = fd_table_create();
+        if (!proc->files) {
+            process_cache[process_cache_count++] = proc;
+            return NULL;
+        }
     }
     
+    /* Hot half goes at the end of the table */
+    sched_entity_t *se = &sched_table[run_queue.count++];
+    se->pid = next_pid++;
+    se->state = PROCESS_STATE_CREATED;
+    se->priority = PROCESS_PRIORITY_DEFAULT;
+    se->cpu_ticks = 0;
+    se->process = proc;
+    se->policy = SCHED_NORMAL;
+    se->flags = 0;
+    se->runtime_budget = 0;
+    se->runtime_used = 0;
+    se->period_end = 0;
+    
     /* Initialize process */
-    proc->pid = next_pid++;
+    proc->sched = se;
+    proc->pid = se->pid;
     proc->uid = uid;
     proc->gid = 0;
     
     strncpy(proc->name, name, 255);
     proc->name[255] = '\0';
     
-    proc->state = PROCESS_STATE_CREATED;
+    proc->entry_point = entry_point;
     proc->code_start = entry_point;
-    proc->cpu_ticks = 0;
+    proc->code_end = 0;
+    proc->data_start = 0;
+    proc->data_end = 0;
+    proc->heap_start = 0;
+    proc->heap_end = 0;
+    proc->stack_start = 0;
+    proc->stack_end = 0;
+    proc->address_space = NULL;
+    proc->context_rsp = 0;
+    proc->kernel_rsp = 0;
+    proc->uring = NULL;
+    proc->kernel_stack = 0;
+    proc->wake_at = 0;
+    proc->rt_period = 0;
     proc->creation_time = 0;  /* TODO: Get current time */
     proc->exit_code = 0;
     
@@ -52,8 +107,17 @@ kpid_t process_create(const char *name, vaddr_t entry_point, uid_t uid) {
     proc->num_children = 0;
     proc->parent_pid = 0;
     
-    /* Add to process table */
-    process_table[num_processes++] = proc;
+    return proc;
+}
+
+kpid_t process_create(const char *name, vaddr_t entry_point, uid_t uid) {
+    spinlock_acquire(&process_table_lock);
+    
+    process_t *proc = process_alloc_locked(name, entry_point, uid);
+    if (!proc) {
+        spinlock_release(&process_table_lock);
+        return -1;
+    }
     
     KINFO("Process created: %s (PID %d)", name, proc->pid);
     
@@ -61,93 +125,584 @@ kpid_t process_create(const char *name, vaddr_t entry_point, uid_t uid) {
     return proc->pid;
 }
 
+/* Caller holds process_table_lock */
+static process_t *process_find_locked(kpid_t pid) {
+    for (uint32_t i = 0; i < run_queue.count; i++) {
+        if (sched_table[i].pid == pid) {
+            return sched_table[i].process;
+        }
+    }
+    return NULL;
+}
+
+/* ===== PROGRAM LOADING ===== */
+/* A process that owns as; it runs once process_start_user() gives it a kernel context */
+kpid_t process_create_user(const char *name, address_space_t *as, vaddr_t entry,
+                           vaddr_t stack_start, vaddr_t stack_end, uid_t uid) {
+    kpid_t pid = process_create(name, entry, uid);
+    if (pid == (kpid_t)-1) return pid;
+    
+    spinlock_acquire(&process_table_lock);
+    process_t *proc = process_find_locked(pid);
+    proc->address_space = as;
+    proc->stack_start = stack_start;
+    proc->stack_end = stack_end;
+    spinlock_release(&process_table_lock);
+    
+    return pid;
+}
+
+kpid_t process_create_elf(const char *name, const void *image, size_t size, uid_t uid) {
+    address_space_t *as = vmm_create_address_space();
+    if (!as) return -1;
+    
+    /* Only maps areas; pages are faulted in from the image on first touch */
+    elf_image_t info;
+    elf_result_t result = elf_load(as, image, size, &info);
+    if (result != ELF_OK) {
+        KWARN("ELF load failed");
+        vmm_destroy_address_space(as);
+        return -1;
+    }
+    
+    if (vdso_map(as) != 0) {
+        KWARN("vDSO not mapped for %s", name);
+    }
+    
+    kpid_t pid = process_create_user(name, as, info.entry, info.stack_start, info.stack_end, uid);
+    process_t *proc = process_get_by_pid(pid);
+    if (pid == (kpid_t)-1 || !proc) {
+        vmm_destroy_address_space(as);
+        return -1;
+    }
+    
+    proc->code_start = info.code_start;
+    proc->code_end = info.code_end;
+    proc->data_start = info.data_start;
+    proc->data_end = info.data_end;
+    proc->heap_start = info.code_end > info.data_end ? info.code_end : info.data_end;
+    proc->heap_end = proc->heap_start;
+    
+    KINFO("Loaded %s: entry %lx, code %lx-%lx, data %lx-%lx",
+          name, info.entry, info.code_start, info.code_end,
+          info.data_start, info.data_end);
+    
+    return pid;
+}
+
+/* ===== FORK ===== */
+static void scheduler_remove_sleeper(process_t *proc) {
+    for (uint32_t i = 0; i < num_sleepers; i++) {
+        if (sleepers[i] == proc) {
+            sleepers[i] = sleepers[--num_sleepers];
+            return;
+        }
+    }
+}
+
+/* Drop a process's hot half, moving the last entry into the hole */
+static void process_unlink_locked(process_t *proc) {
+    scheduler_remove_sleeper(proc);
+
+    sched_entity_t *last = &sched_table[--run_queue.count];
+    if (proc->sched != last) {
+        *proc->sched = *last;
+        proc->sched->process->sched = proc->sched;
+    }
+    proc->sched = NULL;
+}
+
+static bool process_add_child(process_t *parent, kpid_t child) {
+    /* Capacity doubles at each power of two, starting at 4 */
+    size_t n = parent->num_children;
+    if (n == 0 || (n >= 4 && (n & (n - 1)) == 0)) {
+        size_t capacity = n == 0 ? 4 : n * 2;
+        kpid_t *children = (kpid_t *)malloc(capacity * sizeof(kpid_t));
+        if (!children) return false;
+        for (size_t i = 0; i < n; i++) {
+            children[i] = parent->children[i];
+        }
+        free(parent->children);
+        parent->children = children;
+    }
+    
+    parent->children[parent->num_children++] = child;
+    return true;
+}
+
+static void process_remove_child(process_t *parent, kpid_t child) {
+    for (size_t i = 0; i < parent->num_children; i++) {
+        if (parent->children[i] == child) {
+            parent->children[i] = parent->children[--parent->num_children];
+            return;
+        }
+    }
+}
+
+kpid_t process_fork(kpid_t parent_pid) {
+    spinlock_acquire(&process_table_lock);
+    
+    process_t *parent = process_find_locked(parent_pid);
+    if (!parent || !parent->address_space ||
+        parent->sched->state == PROCESS_STATE_TERMINATED) {
+        spinlock_release(&process_table_lock);
+        return -1;
+    }
+    
+    /* Copy-on-write: shares the parent's page tables, copies nothing */
+    address_space_t *as = vmm_clone_address_space(parent->address_space);
+    if (!as) {
+        spinlock_release(&process_table_lock);
+        return -1;
+    }
+    
+    process_t *child = process_alloc_locked(parent->name, parent->entry_point, parent->uid);
+    if (child && (!process_add_child(parent, child->pid) ||
+                  fd_table_copy(child->files, parent->files) != 0)) {
+        process_remove_child(parent, child->pid);
+        process_unlink_locked(child);
+        process_cache[process_cache_count++] = child;
+        child = NULL;
+    }
+    if (!child) {
+        spinlock_release(&process_table_lock);
+        vmm_destroy_address_space(as);
+        return -1;
+    }
+    
+    child->gid = parent->gid;
+    child->address_space = as;
+    child->code_start = parent->code_start;
+    child->code_end = parent->code_end;
+    child->data_start = parent->data_start;
+    child->data_end = parent->data_end;
+    child->heap_start = parent->heap_start;
+    child->heap_end = parent->heap_end;
+    child->stack_start = parent->stack_start;
+    child->stack_end = parent->stack_end;
+    child->parent_pid = parent->pid;
+    child->sched->priority = parent->sched->priority;
+    child->sched->state = PROCESS_STATE_READY;
+    
+    kpid_t pid = child->pid;
+    spinlock_release(&process_table_lock);
+    return pid;
+}
+
 /* ===== PROCESS EXIT ===== */
 void process_exit(kpid_t pid, int exit_code) {
+    address_space_t *as = NULL;
+    struct uring *ring = NULL;
+    
     spinlock_acquire(&process_table_lock);
     
-    for (uint32_t i = 0; i < num_processes; i++) {
-        if (process_table[i]->pid == pid) {
-            process_table[i]->state = PROCESS_STATE_TERMINATED;
-            process_table[i]->exit_code = exit_code;
-            
-            KINFO("Process exited: %s (PID %d, code %d)", 
-                  process_table[i]->name, pid, exit_code);
-            
-            /* TODO: Clean up resources */
-            break;
+    process_t *proc = process_find_locked(pid);
+    if (proc && proc->sched->state != PROCESS_STATE_TERMINATED) {
+        proc->sched->state = PROCESS_STATE_TERMINATED;
+        proc->exit_code = exit_code;
+        
+        /* Memory goes now; the descriptor stays until the parent reaps it */
+        as = proc->address_space;
+        proc->address_space = NULL;
+        ring = proc->uring;
+        proc->uring = NULL;
+        
+        KINFO("Process exited: %s (PID %d, code %d)", 
+              proc->name, pid, exit_code);
+    }
+    
+    spinlock_release(&process_table_lock);
+    
+    uring_destroy(ring);
+    vmm_destroy_address_space(as);
+}
+
+int process_reap(kpid_t pid, int *exit_code) {
+    spinlock_acquire(&process_table_lock);
+    
+    process_t *proc = process_find_locked(pid);
+    if (!proc || proc->sched->state != PROCESS_STATE_TERMINATED) {
+        spinlock_release(&process_table_lock);
+        return -1;
+    }
+    
+    if (exit_code) *exit_code = (int)proc->exit_code;
+    
+    process_t *parent = process_find_locked(proc->parent_pid);
+    if (parent) process_remove_child(parent, pid);
+    
+    /* Orphans are adopted by INIT_PID, or left parentless if it cannot take them */
+    process_t *init = pid != INIT_PID ? process_find_locked(INIT_PID) : NULL;
+    for (size_t i = 0; i < proc->num_children; i++) {
+        process_t *child = process_find_locked(proc->children[i]);
+        if (!child) continue;
+        child->parent_pid = init && process_add_child(init, child->pid) ? INIT_PID : 0;
+    }
+    
+    process_unlink_locked(proc);
+    if (proc == this_cpu_read(current)) this_cpu_write(current, NULL);
+    
+    if (proc->kernel_stack) {
+        for (uint32_t i = 0; i < KTHREAD_STACK_PAGES; i++) {
+            vmm_free_frame(proc->kernel_stack + (paddr_t)i * PAGE_SIZE);
         }
+        proc->kernel_stack = 0;
     }
     
+    fd_table_clear(proc->files);
+    free(proc->children);
+    proc->children = NULL;
+    proc->num_children = 0;
+    process_cache[process_cache_count++] = proc;
+    
     spinlock_release(&process_table_lock);
+    return 0;
 }
 
 /* ===== PROCESS LOOKUP ===== */
 process_t *process_get_current(void) {
-    return current_process;
+    return this_cpu_read(current);
 }
 
+/* The descriptor stays valid only until the process is reaped */
 process_t *process_get_by_pid(kpid_t pid) {
-    if (pid == 0) return current_process;
+    if (pid == 0) return this_cpu_read(current);
     
-    for (uint32_t i = 0; i < num_processes; i++) {
-        if (process_table[i]->pid == pid) {
-            return process_table[i];
-        }
+    spinlock_acquire(&process_table_lock);
+    process_t *proc = process_find_locked(pid);
+    spinlock_release(&process_table_lock);
+    return proc;
+}
+
+/* ===== BLOCKING ===== */
+/* Park a running/ready process until process_wake() */
+int process_block(kpid_t pid) {
+    return process_block_if(pid, NULL, NULL);
+}
+
+/*
+ * Park pid only if should_wait(arg) still holds. The test runs under
+ * process_table_lock, which process_wake() takes too, so a waker that
+ * changes the condition and then wakes either is seen by the test or
+ * finds the process already WAITING: the wakeup cannot fall in between.
+ * Returns 1 if the condition was already gone.
+ */
+int process_block_if(kpid_t pid, bool (*should_wait)(void *arg), void *arg) {
+    spinlock_acquire(&process_table_lock);
+    process_t *proc = process_find_locked(pid);
+    if (!proc || proc->sched->state == PROCESS_STATE_TERMINATED) {
+        spinlock_release(&process_table_lock);
+        return -1;
     }
-    
-    return NULL;
+    if (should_wait && !should_wait(arg)) {
+        spinlock_release(&process_table_lock);
+        return 1;
+    }
+    proc->sched->state = PROCESS_STATE_WAITING;
+    spinlock_release(&process_table_lock);
+    return 0;
+}
+
+int process_wake(kpid_t pid) {
+    spinlock_acquire(&process_table_lock);
+    process_t *proc = process_find_locked(pid);
+    if (!proc || proc->sched->state != PROCESS_STATE_WAITING) {
+        spinlock_release(&process_table_lock);
+        return -1;
+    }
+    proc->sched->state = PROCESS_STATE_READY;
+    spinlock_release(&process_table_lock);
+    return 0;
 }
 
 /* ===== PROCESS LISTING ===== */
 void process_list_all(void) {
     KINFO("=== Process Table ===");
-    KINFO("Count: %d", num_processes);
+    KINFO("Count: %d", run_queue.count);
     
-    for (uint32_t i = 0; i < num_processes; i++) {
-        process_t *p = process_table[i];
-        KINFO("  [%d] %s (UID %d, state %d)", p->pid, p->name, p->uid, p->state);
+    for (uint32_t i = 0; i < run_queue.count; i++) {
+        sched_entity_t *se = &sched_table[i];
+        KINFO("  [%d] %s (UID %d, state %d)", se->pid, se->process->name,
+              se->process->uid, se->state);
     }
 }
 
 /* ===== SCHEDULER ===== */
-static uint32_t scheduler_current = 0;
-
 void scheduler_init(void) {
+    spinlock_init(&process_table_lock);
+    
+    /* One shared queue until CPUs get their own */
+    this_cpu_write(run_queue, &run_queue);
+    
     KINFO("Scheduler initialized");
     
     /* Create idle process */
     process_create("idle", 0, 0);
 }
 
+/*
+ * Charge the running SCHED_FIFO entity as it runs rather than only when
+ * it yields, and ask for a reschedule once its budget is gone. Budgets
+ * are only touched under process_table_lock. The tick only tries for
+ * it: if it cut into code holding the lock, waiting would deadlock, so
+ * the charge is left to the next tick or switch (switch_tsc has not
+ * moved, so nothing is lost).
+ */
 void scheduler_tick(void) {
-    if (current_process) {
-        current_process->cpu_ticks++;
+    cpu_local_t *cpu = this_cpu_ptr();
+    process_t *current = cpu->current;
+    this_cpu_inc(stats.ticks);
+    if (!current) return;
+    
+    current->sched->cpu_ticks++;
+    if (current->sched->policy != SCHED_FIFO || !spinlock_try_acquire(&process_table_lock)) return;
+    
+    /* Reaping compacts the table: only the locked view of sched counts */
+    sched_entity_t *se = current->sched;
+    if (se->policy == SCHED_FIFO) {
+        uint64_t now = rdtsc();
+        se->runtime_used += now - cpu->switch_tsc;
+        cpu->switch_tsc = now;
+        if (se->runtime_used >= se->runtime_budget) {
+            cpu->need_resched = 1;
+        }
     }
+    spinlock_release(&process_table_lock);
+}
+
+/*
+ * Class of an entity for this pick: SCHED_FIFO counts as real-time
+ * only while it has budget left in its period; a throttled one
+ * competes as SCHED_NORMAL until the period ends.
+ */
+static inline int scheduler_class_rank(sched_entity_t *se, uint64_t now) {
+    if (se->policy != SCHED_FIFO) return 0;
+    
+    if (now >= se->period_end) {
+        se->runtime_used = 0;
+        se->period_end = now + se->process->rt_period;
+    }
+    return se->runtime_used < se->runtime_budget;
+}
+
+/*
+ * Pick the runnable entity with the highest (class, priority), round
+ * robin among equals starting at start. A throttled SCHED_FIFO entity
+ * competes at PROCESS_PRIORITY_DEFAULT: its real-time priority would
+ * otherwise still put it ahead of every normal one. Only entities with
+ * a kernel context can be dispatched. Only the dense hot table is read,
+ * except to replenish a real-time budget; caller holds
+ * process_table_lock.
+ */
+sched_entity_t *scheduler_pick(sched_entity_t *table, uint32_t count, uint32_t start) {
+    sched_entity_t *best = NULL;
+    int best_rank = -1;
+    int32_t best_priority = 0;
+    uint64_t now = rdtsc();
+    
+    for (uint32_t n = 0; n < count; n++) {
+        sched_entity_t *se = &table[(start + n) % count];
+        if (se->state != PROCESS_STATE_READY && se->state != PROCESS_STATE_CREATED) continue;
+        if (!(se->flags & SCHED_F_CONTEXT)) continue;
+        
+        int rank = scheduler_class_rank(se, now);
+        int32_t priority = se->policy == SCHED_FIFO && !rank ? PROCESS_PRIORITY_DEFAULT : se->priority;
+        if (rank > best_rank || (rank == best_rank && priority > best_priority)) {
+            best = se;
+            best_rank = rank;
+            best_priority = priority;
+        }
+    }
+    return best;
 }
 
+/* Caller holds process_table_lock */
+static void scheduler_wake_sleepers(uint64_t now) {
+    for (uint32_t i = 0; i < num_sleepers; ) {
+        process_t *proc = sleepers[i];
+        if (proc->wake_at > now) {
+            i++;
+            continue;
+        }
+        if (proc->sched->state == PROCESS_STATE_WAITING) {
+            proc->sched->state = PROCESS_STATE_READY;
+        }
+        proc->wake_at = 0;
+        sleepers[i] = sleepers[--num_sleepers];
+    }
+}
+
+/*
+ * Reschedule this CPU. Kernel threads switch stacks here; code that is
+ * not a kernel thread (boot, terminal, benchmarks) owns the per-CPU
+ * boot context, which runs whenever no thread is runnable.
+ */
 void scheduler_switch(void) {
+    cpu_local_t *cpu = this_cpu_ptr();
+    run_queue_t *rq = cpu->run_queue;
+    process_t *prev = cpu->current;
+    uint64_t now = rdtsc();
+    
     spinlock_acquire(&process_table_lock);
     
-    if (num_processes == 0) {
-        spinlock_release(&process_table_lock);
+    cpu->need_resched = 0;
+    scheduler_wake_sleepers(now);
+    
+    bool prev_is_thread = prev && prev->sched && (prev->sched->flags & SCHED_F_CONTEXT);
+    if (prev && prev->sched) {
+        if (prev->sched->policy == SCHED_FIFO) {
+            prev->sched->runtime_used += now - cpu->switch_tsc;
+        }
+        /* The outgoing process competes again unless it blocked or exited */
+        if (prev->sched->state == PROCESS_STATE_RUNNING) {
+            prev->sched->state = PROCESS_STATE_READY;
+        }
+    }
+    
+    /* The table shrinks when processes are reaped */
+    if (rq->last >= rq->count) rq->last = 0;
+    
+    sched_entity_t *next = rq->count ? scheduler_pick(rq->entities, rq->count, rq->last + 1) : NULL;
+    uint64_t *from = prev_is_thread ? &prev->context_rsp : &cpu->boot_rsp;
+    uint64_t *from_entry = prev_is_thread ? &prev->kernel_rsp : &cpu->boot_kernel_rsp;
+    uint64_t to, to_entry;
+    
+    if (next) {
+        rq->last = (uint32_t)(next - rq->entities);
+        next->state = PROCESS_STATE_RUNNING;
+        cpu->current = next->process;
+        to = next->process->context_rsp;
+        to_entry = next->process->kernel_rsp;
+        vdso_set_current(next->pid);
+    } else {
+        /* Nothing to run: back to (or stay in) the boot context */
+        cpu->current = NULL;
+        to = cpu->boot_rsp;
+        to_entry = cpu->boot_kernel_rsp;
+    }
+    cpu->switch_tsc = now;
+    
+    bool switching = next ? next->process != prev || !prev_is_thread : prev_is_thread;
+    if (switching) {
+        cpu->stats.context_switches++;
+        
+        /* Each context that runs user code has its own syscall entry stack */
+        *from_entry = cpu->kernel_rsp;
+        cpu->kernel_rsp = to_entry;
+        gdt_set_kernel_stack(to_entry);
+        
+        /* Kernel threads borrow whatever space is loaded; the kernel half is shared */
+        if (next && next->process->address_space) {
+            vmm_switch_address_space(next->process->address_space);
+        }
+    }
+    
+    spinlock_release(&process_table_lock);
+    
+    if (switching) {
+        context_switch(from, to);
+    }
+}
+
+void scheduler_sleep_until(uint64_t tsc) {
+    process_t *current = this_cpu_read(current);
+    
+    /* The boot context cannot be descheduled: it polls instead */
+    if (!current || !(current->sched->flags & SCHED_F_CONTEXT)) {
+        while (rdtsc() < tsc) {
+            scheduler_switch();
+            cpu_relax();
+        }
         return;
     }
     
-    /* Simple round-robin scheduling */
-    do {
-        scheduler_current = (scheduler_current + 1) % num_processes;
-    } while (process_table[scheduler_current]->state != PROCESS_STATE_READY && 
-             process_table[scheduler_current]->state != PROCESS_STATE_CREATED);
+    spinlock_acquire(&process_table_lock);
+    current->wake_at = tsc;
+    current->sched->state = PROCESS_STATE_WAITING;
+    sleepers[num_sleepers++] = current;
+    spinlock_release(&process_table_lock);
+    
+    scheduler_switch();
+}
+
+/* ===== SCHEDULING POLICY ===== */
+static uint64_t scheduler_ns_to_cycles(uint64_t ns) {
+    /* kHz keeps the product in 64 bits for periods up to hours */
+    return ns * (time_tsc_hz() / 1000) / 1000000;
+}
+
+int sched_set_realtime(kpid_t pid, int32_t priority, uint64_t runtime_ns, uint64_t period_ns) {
+    if (runtime_ns == 0 || runtime_ns > period_ns) return -1;
+    
+    uint64_t budget = scheduler_ns_to_cycles(runtime_ns);
+    uint64_t period = scheduler_ns_to_cycles(period_ns);
+    
+    spinlock_acquire(&process_table_lock);
+    process_t *proc = process_find_locked(pid);
+    if (!proc) {
+        spinlock_release(&process_table_lock);
+        return -1;
+    }
+    proc->rt_period = period;
+    proc->sched->policy = SCHED_FIFO;
+    proc->sched->priority = priority;
+    proc->sched->runtime_budget = budget;
+    proc->sched->runtime_used = 0;
+    proc->sched->period_end = rdtsc() + period;
+    spinlock_release(&process_table_lock);
+    return 0;
+}
+
+int sched_set_normal(kpid_t pid) {
+    spinlock_acquire(&process_table_lock);
+    process_t *proc = process_find_locked(pid);
+    if (!proc) {
+        spinlock_release(&process_table_lock);
+        return -1;
+    }
+    proc->sched->policy = SCHED_NORMAL;
+    proc->sched->priority = PROCESS_PRIORITY_DEFAULT;
+    spinlock_release(&process_table_lock);
+    return 0;
+}
+
+/* ===== USER MODE ===== */
+/* Kernel context of a user process: enter ring 3 and stay there until SYS_EXIT */
+static void process_user_main(void *arg) {
+    process_t *self = process_get_current();
+    
+    vmm_switch_address_space(self->address_space);
+    uint64_t code = syscall_run_user(self->entry_point, self->stack_end, (uint64_t)(uintptr_t)arg);
     
-    current_process = process_table[scheduler_current];
-    current_process->state = PROCESS_STATE_RUNNING;
+    /* SYS_EXIT has already marked us; a bad SYSRET target has not */
+    process_exit(self->pid, (int)code);
+}
+
+int process_start_user(kpid_t pid, uint64_t arg) {
+    process_t *proc = process_get_by_pid(pid);
+    if (!proc || !proc->address_space || (proc->sched->flags & SCHED_F_CONTEXT)) return -1;
     
+    return kthread_attach(pid, process_user_main, (void *)(uintptr_t)arg);
+}
+
+int process_attach_context(kpid_t pid, uint64_t rsp, paddr_t stack) {
+    spinlock_acquire(&process_table_lock);
+    process_t *proc = process_find_locked(pid);
+    if (!proc) {
+        spinlock_release(&process_table_lock);
+        return -1;
+    }
+    proc->context_rsp = rsp;
+    proc->kernel_stack = stack;
+    proc->sched->flags |= SCHED_F_CONTEXT;
+    proc->sched->state = PROCESS_STATE_READY;
     spinlock_release(&process_table_lock);
+    return 0;
 }
 
 process_t *scheduler_next_process(void) {
     scheduler_switch();
-    return current_process;
+    return this_cpu_read(current);
 }
 
 /* ===== IDLE PROCESS ===== */
@@ -0,0 +1,220 @@
+/*
+ * Sampling Profiler Implementation
+ * Frame-pointer unwinding from interrupt context and the folded dump
+ *
+ * The sampling hooks take no arguments: they find the interrupt frame
+ * themselves by following frame pointers up to the one idt_dispatch()
+ * built, recognised by its return address idt_return. The entry stubs
+ * leave rbp alone, so the rbp saved there is the interrupted one.
+ */
+
+#include <kernel/prof.h>
+#include <kernel/kernel.h>
+#include <kernel/ksyms.h>
+#include <kernel/percpu.h>
+#include <kernel/apic.h>
+#include <kernel/klog.h>
+#include <kernel/idt.h>
+#include <drivers/serial.h>
+#include <string.h>
+
+#define PROF_STACK_MASK     (PROF_STACKS - 1)
+#define PROF_PROBES         16      /* Slots tried before a sample is dropped */
+#define PROF_HANDLER_FRAMES 8       /* Our own frames between here and idt_dispatch() */
+#define PROF_LINE_MAX       768
+
+_Static_assert((PROF_STACKS & PROF_STACK_MASK) == 0, "PROF_STACKS must be a power of two");
+
+extern const uint8_t __kernel_start[], __text_end[];
+
+/* ===== STATE ===== */
+static prof_table_t prof_tables[PROF_CPUS];
+static bool prof_enabled = false;
+
+static inline uint32_t prof_cpu(void) {
+    return percpu_count() ? this_cpu_read(cpu_id) : 0;
+}
+
+static inline bool prof_kernel_text(uint64_t addr) {
+    return addr >= (uint64_t)(uintptr_t)__kernel_start &&
+           addr < (uint64_t)(uintptr_t)__text_end;
+}
+
+/* ===== UNWINDING ===== */
+/* The interrupt frame that entered the handler we are running in */
+static const interrupt_frame_t *prof_find_frame(const uint64_t **interrupted_fp) {
+    const uint64_t *fp = __builtin_frame_address(0);
+
+    for (uint32_t i = 0; i < PROF_HANDLER_FRAMES && fp; i++) {
+        if (fp[1] == (uint64_t)(uintptr_t)idt_return) {
+            *interrupted_fp = (const uint64_t *)fp[0];
+            return (const interrupt_frame_t *)&fp[2];   /* The stub's rsp at the call */
+        }
+        fp = (const uint64_t *)fp[0];
+    }
+    return NULL;
+}
+
+/*
+ * The interrupted code may be assembly using rbp for data, or stopped
+ * before its prologue. Frames are only followed upwards and within
+ * PROF_STACK_SPAN of the interrupted rsp, which stays on the (mapped)
+ * stack the interrupt arrived on.
+ */
+static uint32_t prof_unwind(const interrupt_frame_t *frame, const uint64_t *fp, uint64_t *pcs) {
+    uint32_t depth = 0;
+    pcs[depth++] = frame->rip;
+
+    uint64_t low = frame->rsp;
+    uint64_t high = frame->rsp + PROF_STACK_SPAN;
+    while (depth < PROF_MAX_DEPTH) {
+        uint64_t addr = (uint64_t)(uintptr_t)fp;
+        if (addr < low || addr + 16 > high || (addr & 7)) break;
+
+        uint64_t ret = fp[1];
+        if (!prof_kernel_text(ret)) break;
+        pcs[depth++] = ret;
+
+        low = addr + 16;
+        fp = (const uint64_t *)fp[0];
+    }
+    return depth;
+}
+
+/* ===== RECORDING ===== */
+static uint64_t prof_hash(const uint64_t *pcs, uint32_t depth) {
+    uint64_t hash = 0xCBF29CE484222325ULL;      /* FNV-1a over whole words */
+    for (uint32_t i = 0; i < depth; i++) {
+        hash = (hash ^ pcs[i]) * 0x100000001B3ULL;
+    }
+    return hash ? hash : 1;
+}
+
+static void prof_record(prof_table_t *table, const uint64_t *pcs, uint32_t depth) {
+    uint64_t hash = prof_hash(pcs, depth);
+
+    for (uint32_t probe = 0; probe < PROF_PROBES; probe++) {
+        prof_stack_t *stack = &table->stacks[(hash + probe) & PROF_STACK_MASK];
+        if (stack->hash == 0) {
+            stack->depth = depth;
+            memcpy(stack->pcs, pcs, depth * sizeof(pcs[0]));
+            stack->count = 1;
+            stack->hash = hash;
+            return;
+        }
+        if (stack->hash == hash && stack->depth == depth &&
+            memcmp(stack->pcs, pcs, depth * sizeof(pcs[0])) == 0) {
+            stack->count++;
+            return;
+        }
+    }
+    table->dropped++;
+}
+
+void prof_sample(void) {
+    if (!__atomic_load_n(&prof_enabled, __ATOMIC_RELAXED)) return;
+
+    prof_table_t *table = &prof_tables[prof_cpu() % PROF_CPUS];
+    if (__atomic_exchange_n(&table->busy, 1, __ATOMIC_ACQUIRE)) {
+        table->dropped++;
+        return;
+    }
+
+    const uint64_t *fp = NULL;
+    const interrupt_frame_t *frame = prof_find_frame(&fp);
+    if (frame) {
+        table->samples++;
+        if (interrupt_from_user(frame)) {
+            table->user++;
+        } else {
+            uint64_t pcs[PROF_MAX_DEPTH];
+            prof_record(table, pcs, prof_unwind(frame, fp, pcs));
+        }
+    }
+
+    __atomic_store_n(&table->busy, 0, __ATOMIC_RELEASE);
+}
+
+void prof_tick(void) {
+    if (!__atomic_load_n(&prof_enabled, __ATOMIC_RELAXED)) return;
+
+    prof_sample();
+
+    if (!lapic_ready()) return;
+    uint32_t self = prof_cpu();
+    for (uint32_t cpu = 0; cpu < percpu_count(); cpu++) {
+        if (cpu != self) {
+            lapic_send_nmi(percpu_get(cpu)->apic_id);
+        }
+    }
+}
+
+/* ===== CONTROL ===== */
+void prof_start(void) {
+    prof_stop();
+    memset(prof_tables, 0, sizeof(prof_tables));
+    __atomic_store_n(&prof_enabled, true, __ATOMIC_RELEASE);
+}
+
+void prof_stop(void) {
+    __atomic_store_n(&prof_enabled, false, __ATOMIC_RELEASE);
+}
+
+bool prof_running(void) {
+    return __atomic_load_n(&prof_enabled, __ATOMIC_RELAXED);
+}
+
+/* ===== FOLDED OUTPUT ===== */
+/*
+ * Callers' entries are return addresses, one past the call: look up the
+ * byte before so a call that ends a function is not charged to the next.
+ */
+static size_t prof_put_frame(char *buf, size_t size, uint64_t pc, bool caller) {
+    const char *name = ksym_lookup(caller ? pc - 1 : pc, NULL);
+    return name ? klog_format(buf, size, "%s", name) : klog_format(buf, size, "%lx", pc);
+}
+
+void prof_dump(void) {
+    bool was_running = prof_running();
+    prof_stop();
+
+    uint64_t samples = 0, user = 0, dropped = 0;
+    for (uint32_t c = 0; c < PROF_CPUS; c++) {
+        samples += prof_tables[c].samples;
+        user += prof_tables[c].user;
+        dropped += prof_tables[c].dropped;
+    }
+
+    KINFO("prof: %lu samples (%lu in user mode, %lu dropped), %lu symbols; folded stacks follow on COM1",
+          samples, user, dropped, ksyms_count);
+    klog_flush();
+
+    static char line[PROF_LINE_MAX];
+    for (uint32_t c = 0; c < PROF_CPUS; c++) {
+        const prof_table_t *table = &prof_tables[c];
+
+        for (uint32_t s = 0; s < PROF_STACKS; s++) {
+            const prof_stack_t *stack = &table->stacks[s];
+            if (!stack->count) continue;
+
+            /* Outermost caller first */
+            size_t len = 0;
+            for (uint32_t i = stack->depth; i-- > 0;) {
+                len += prof_put_frame(line + len, sizeof(line) - len, stack->pcs[i], i > 0);
+                if (i > 0 && len + 1 < sizeof(line)) line[len++] = ';';
+            }
+            klog_format(line + len, sizeof(line) - len, " %u\n", stack->count);
+            serial_write(line);
+        }
+        if (table->user) {
+            klog_format(line, sizeof(line), "[user] %lu\n", table->user);
+            serial_write(line);
+        }
+    }
+    serial_flush();
+
+    KINFO("prof: end of stacks");
+    if (was_running) {
+        __atomic_store_n(&prof_enabled, true, __ATOMIC_RELEASE);
+    }
+}
@@ -0,0 +1,269 @@
+/*
+ * System Call Implementation
+ * SYSCALL/SYSRET entry stub, per-CPU kernel stack and table dispatch
+ */
+
+#include <kernel/syscall.h>
+#include <kernel/kernel.h>
+#include <kernel/cpu.h>
+#include <kernel/gdt.h>
+#include <kernel/percpu.h>
+#include <kernel/process.h>
+#include <kernel/time.h>
+#include <kernel/vmm.h>
+
+#define SYSCALL_STR_(x) #x
+#define SYSCALL_STR(x)  SYSCALL_STR_(x)
+
+/* ===== STATE ===== */
+#define SYSCALL_STACK_SIZE 16384
+
+static uint8_t syscall_stack[SYSCALL_STACK_SIZE] __attribute__((aligned(16)));
+
+/* Every slot is valid (unused ones hold sys_enosys): no NULL check on entry */
+syscall_fn_t syscall_table[SYSCALL_MAX];
+
+void syscall_entry(void);
+void syscall_bad_rip(void) __attribute__((noreturn));
+
+/*
+ * ===== ENTRY STUB =====
+ *
+ * On SYSCALL the CPU has put the user RIP in rcx and RFLAGS in r11,
+ * masked RFLAGS with FMASK and loaded kernel CS/SS, but rsp is still
+ * the user stack. Switch to the per-CPU kernel stack through GS (see
+ * <kernel/percpu.h>), save the registers the C ABI would clobber so
+ * user code sees only rax, rcx and r11 change, and call
+ * syscall_table[rax].
+ */
+__asm__(
+    ".text\n"
+    ".globl syscall_entry\n"
+    "syscall_entry:\n"
+    "    swapgs\n"
+    "    movq %rsp, %gs:" SYSCALL_STR(PERCPU_USER_RSP) "\n"
+    "    movq %gs:" SYSCALL_STR(PERCPU_KERNEL_RSP) ", %rsp\n"
+    "    pushq %gs:" SYSCALL_STR(PERCPU_USER_RSP) "\n"
+    "    pushq %r11\n"
+    "    pushq %rcx\n"
+    "    pushq %rdi\n"
+    "    pushq %rsi\n"
+    "    pushq %rdx\n"
+    "    pushq %r10\n"
+    "    pushq %r8\n"
+    "    pushq %r9\n"
+    "    subq $8, %rsp\n"                   /* 16-byte align for the call */
+    "    incq %gs:" SYSCALL_STR(PERCPU_STATS_SYSCALLS) "\n"
+    "    sti\n"                             /* On the kernel stack with kernel GS now */
+    "    movq %r10, %rcx\n"                 /* 4th argument, C ABI */
+    "    cmpq $" SYSCALL_STR(SYSCALL_MAX) ", %rax\n"
+    "    jae 1f\n"
+    "    leaq syscall_table(%rip), %r11\n"
+    "    callq *(%r11,%rax,8)\n"
+    "    jmp 2f\n"
+    "1:  movq $-38, %rax\n"                 /* SYSCALL_ENOSYS */
+    "2:  cli\n"                          /* Until SYSRET: GS is swapped below */
+    "    addq $8, %rsp\n"
+    "    popq %r9\n"
+    "    popq %r8\n"
+    "    popq %r10\n"
+    "    popq %rdx\n"
+    "    popq %rsi\n"
+    "    popq %rdi\n"
+    "    movq (%rsp), %rcx\n"
+    "    movq %rcx, %r11\n"
+    "    shrq $47, %r11\n"                  /* SYSRET to a non-canonical RIP faults in ring 0 */
+    "    jnz syscall_bad_rip\n"
+    "    popq %rcx\n"
+    "    popq %r11\n"
+    "    popq %rsp\n"
+    "    swapgs\n"
+    "    sysretq\n"
+);
+
+/*
+ * ===== KERNEL <-> USER TRAMPOLINE =====
+ *
+ * syscall_run_user() saves the callee-saved registers, RFLAGS and the
+ * previous entry stack, then makes its own stack pointer the per-CPU
+ * entry stack (and TSS.RSP0) and drops to ring 3 with SYSRET. System
+ * calls and interrupts from that user code therefore run on the
+ * caller's stack just below the saved frame, so every kernel thread
+ * running user code has a private entry stack, and the scheduler only
+ * has to switch kernel_rsp along with threads.
+ * syscall_return_to_kernel() (called from a handler) unwinds straight
+ * back through the same per-CPU pointer, restoring the caller's IF.
+ */
+__asm__(
+    ".text\n"
+    ".globl syscall_run_user\n"
+    "syscall_run_user:\n"
+    "    pushq %rbx\n"
+    "    pushq %rbp\n"
+    "    pushq %r12\n"
+    "    pushq %r13\n"
+    "    pushq %r14\n"
+    "    pushq %r15\n"
+    "    pushfq\n"
+    "    pushq %gs:" SYSCALL_STR(PERCPU_KERNEL_RSP) "\n"
+    "    subq $8, %rsp\n"                   /* Keeps the entry stack 16-byte aligned */
+    "    movq %rsp, %gs:" SYSCALL_STR(PERCPU_KERNEL_RSP) "\n"
+    "    movq %rdi, %r12\n"
+    "    movq %rsi, %r13\n"
+    "    movq %rdx, %r14\n"
+    "    movq %rsp, %rdi\n"
+    "    call gdt_set_kernel_stack\n"
+    "    movq %r12, %rcx\n"                 /* User RIP */
+    "    movq %r14, %rdi\n"                 /* Argument */
+    "    movq $" SYSCALL_STR(USER_RFLAGS) ", %r11\n"
+    "    xorl %eax, %eax\n"                 /* Don't leak kernel values */
+    "    xorl %ebx, %ebx\n"
+    "    xorl %ebp, %ebp\n"
+    "    xorl %edx, %edx\n"
+    "    xorl %esi, %esi\n"
+    "    xorl %r8d, %r8d\n"
+    "    xorl %r9d, %r9d\n"
+    "    xorl %r10d, %r10d\n"
+    "    xorl %r12d, %r12d\n"
+    "    xorl %r14d, %r14d\n"
+    "    xorl %r15d, %r15d\n"
+    "    cli\n"                             /* No IRQ on the user stack or GS */
+    "    movq %r13, %rsp\n"
+    "    xorl %r13d, %r13d\n"
+    "    swapgs\n"
+    "    sysretq\n"
+    "\n"
+    ".globl syscall_return_to_kernel\n"
+    "syscall_return_to_kernel:\n"
+    "    movq %rdi, %rbx\n"                 /* rbx is restored from the frame anyway */
+    "    movq %gs:" SYSCALL_STR(PERCPU_KERNEL_RSP) ", %rsp\n"
+    "    addq $8, %rsp\n"
+    "    popq %gs:" SYSCALL_STR(PERCPU_KERNEL_RSP) "\n"
+    "    movq %gs:" SYSCALL_STR(PERCPU_KERNEL_RSP) ", %rdi\n"
+    "    call gdt_set_kernel_stack\n"
+    "    movq %rbx, %rax\n"
+    "    popfq\n"
+    "    popq %r15\n"
+    "    popq %r14\n"
+    "    popq %r13\n"
+    "    popq %r12\n"
+    "    popq %rbp\n"
+    "    popq %rbx\n"
+    "    ret\n"
+);
+
+/* Ring 3 is only ever entered through syscall_run_user(), so there is a frame to unwind to */
+void syscall_bad_rip(void) {
+    syscall_return_to_kernel((uint64_t)-1);
+}
+
+/* ===== CORE SYSTEM CALLS ===== */
+static uint64_t sys_enosys(uint64_t a0, uint64_t a1, uint64_t a2,
+                           uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a0; (void)a1; (void)a2; (void)a3; (void)a4; (void)a5;
+    return SYSCALL_ENOSYS;
+}
+
+static uint64_t sys_null(uint64_t a0, uint64_t a1, uint64_t a2,
+                         uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a0; (void)a1; (void)a2; (void)a3; (void)a4; (void)a5;
+    return 0;
+}
+
+static uint64_t sys_getpid(uint64_t a0, uint64_t a1, uint64_t a2,
+                           uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a0; (void)a1; (void)a2; (void)a3; (void)a4; (void)a5;
+    process_t *proc = process_get_current();
+    return proc ? proc->pid : 0;
+}
+
+static uint64_t sys_exit(uint64_t code, uint64_t a1, uint64_t a2,
+                         uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a1; (void)a2; (void)a3; (void)a4; (void)a5;
+    process_t *proc = process_get_current();
+    if (proc) {
+        process_exit(proc->pid, (int)code);
+    }
+    syscall_return_to_kernel(code);
+}
+
+static uint64_t sys_clock_ns(uint64_t a0, uint64_t a1, uint64_t a2,
+                             uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a0; (void)a1; (void)a2; (void)a3; (void)a4; (void)a5;
+    return time_ns();
+}
+
+static uint64_t sys_yield(uint64_t a0, uint64_t a1, uint64_t a2,
+                          uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a0; (void)a1; (void)a2; (void)a3; (void)a4; (void)a5;
+    scheduler_switch();
+    return 0;
+}
+
+/* Reserves address space only: each page gets a frame when first written */
+static uint64_t sys_map_anon(uint64_t addr, uint64_t len, uint64_t prot,
+                             uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a3; (void)a4; (void)a5;
+    process_t *proc = process_get_current();
+    if (!proc || !proc->address_space || !len ||
+        addr >= USER_SPACE_END || len > USER_SPACE_END - addr ||
+        (prot & ~(uint64_t)(VMA_READ | VMA_WRITE | VMA_EXEC))) {
+        return SYSCALL_EINVAL;
+    }
+
+    vm_area_t area = {
+        .start = addr,
+        .end = addr + len,
+        .prot = (uint32_t)prot | VMA_USER,
+        .type = VMA_ANON,
+    };
+    return vmm_add_area(proc->address_space, &area) == 0 ? 0 : SYSCALL_EINVAL;
+}
+
+/* Frees the frames in the range, with one TLB shootdown per batch of pages */
+static uint64_t sys_unmap(uint64_t addr, uint64_t len, uint64_t a2,
+                          uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a2; (void)a3; (void)a4; (void)a5;
+    process_t *proc = process_get_current();
+    if (!proc || !proc->address_space || !len ||
+        addr >= USER_SPACE_END || len > USER_SPACE_END - addr) {
+        return SYSCALL_EINVAL;
+    }
+    return vmm_remove_areas(proc->address_space, addr, addr + len) == 0 ? 0 : SYSCALL_EINVAL;
+}
+
+/* ===== REGISTRATION ===== */
+int syscall_register(uint32_t number, syscall_fn_t handler) {
+    if (number >= SYSCALL_MAX || !handler) return -1;
+    syscall_table[number] = handler;
+    return 0;
+}
+
+/* ===== INITIALIZATION ===== */
+void syscall_init(void) {
+    for (uint32_t i = 0; i < SYSCALL_MAX; i++) {
+        syscall_table[i] = sys_enosys;
+    }
+    syscall_register(SYS_NULL, sys_null);
+    syscall_register(SYS_GETPID, sys_getpid);
+    syscall_register(SYS_EXIT, sys_exit);
+    syscall_register(SYS_CLOCK_NS, sys_clock_ns);
+    syscall_register(SYS_YIELD, sys_yield);
+    syscall_register(SYS_MAP_ANON, sys_map_anon);
+    syscall_register(SYS_UNMAP, sys_unmap);
+
+    /* Same stack for SYSCALL and for interrupts taken in ring 3 */
+    uint64_t stack_top = (uint64_t)(uintptr_t)&syscall_stack[SYSCALL_STACK_SIZE];
+    this_cpu_write(kernel_rsp, stack_top);
+    gdt_set_kernel_stack(stack_top);
+
+    /* SYSRET: CS = base + 16, SS = base + 8 (see <kernel/gdt.h>) */
+    wrmsr(MSR_STAR, ((uint64_t)(GDT_USER_DATA - 8) << 48) |
+                    ((uint64_t)GDT_KERNEL_CODE << 32));
+    wrmsr(MSR_LSTAR, (uint64_t)(uintptr_t)syscall_entry);
+    wrmsr(MSR_FMASK, 0x47700);  /* Clear IF, TF, DF, NT, AC on entry */
+    wrmsr(MSR_EFER, rdmsr(MSR_EFER) | EFER_SCE);
+
+    KINFO("SYSCALL entry at %lx, kernel stack %lx",
+          (uint64_t)(uintptr_t)syscall_entry, stack_top);
+}
@@ -0,0 +1,70 @@
+/*
+ * Kernel Time Base Implementation
+ * Measures the TSC frequency with PIT channel 2 and converts cycles to ns
+ */
+
+#include <kernel/time.h>
+#include <kernel/kernel.h>
+#include <kernel/cpu.h>
+
+/* ===== PIT ===== */
+#define PIT_HZ              1193182
+#define PIT_CHANNEL2        0x42
+#define PIT_COMMAND         0x43
+#define PIT_GATE_PORT       0x61    /* Bit 0: ch2 gate, bit 1: speaker, bit 5: ch2 output */
+#define CALIBRATE_DIVISOR   100     /* 10 ms window */
+
+/* ===== STATE ===== */
+static uint64_t tsc_hz = 0;
+static uint64_t tsc_boot = 0;
+static uint64_t ns_mult = 0;        /* ns = (cycles * ns_mult) >> 32 */
+
+static uint64_t time_calibrate_tsc(void) {
+    uint16_t count = PIT_HZ / CALIBRATE_DIVISOR;
+    uint8_t gate = inb(PIT_GATE_PORT);
+
+    /* Gate low and speaker off while channel 2 is programmed */
+    outb(PIT_GATE_PORT, gate & ~0x03);
+    outb(PIT_COMMAND, 0xB0);  /* Channel 2, lo/hi byte, mode 0 */
+    outb(PIT_CHANNEL2, count & 0xFF);
+    outb(PIT_CHANNEL2, count >> 8);
+
+    /* Raising the gate starts the countdown; OUT goes high at zero */
+    outb(PIT_GATE_PORT, (gate & ~0x02) | 0x01);
+    uint64_t start = rdtsc();
+    while (!(inb(PIT_GATE_PORT) & 0x20)) {
+        cpu_relax();
+    }
+    uint64_t end = rdtsc();
+
+    outb(PIT_GATE_PORT, gate);
+    return (end - start) * CALIBRATE_DIVISOR;
+}
+
+void time_init(void) {
+    tsc_hz = time_calibrate_tsc();
+    if (tsc_hz == 0) {
+        tsc_hz = 1000000000ULL;  /* Keep conversions sane */
+    }
+    ns_mult = (1000000000ULL << 32) / tsc_hz;
+    tsc_boot = rdtsc();
+
+    KINFO("TSC: %lu kHz", tsc_hz / 1000);
+}
+
+uint64_t time_tsc_hz(void) {
+    return tsc_hz;
+}
+
+uint64_t time_cycles_to_ns(uint64_t cycles) {
+    return (uint64_t)(((unsigned __int128)cycles * ns_mult) >> 32);
+}
+
+uint64_t time_ns(void) {
+    return time_cycles_to_ns(rdtsc() - tsc_boot);
+}
+
+void time_get_scale(uint64_t *tsc_base, uint64_t *mult) {
+    *tsc_base = tsc_boot;
+    *mult = ns_mult;
+}
@@ -0,0 +1,124 @@
+/*
+ * Static Tracepoints Implementation
+ * Per-CPU record buffers and the Chrome trace-event exporter
+ */
+
+#include <kernel/trace.h>
+#include <kernel/kernel.h>
+#include <kernel/percpu.h>
+#include <kernel/time.h>
+#include <kernel/klog.h>
+#include <kernel/cpu.h>
+#include <drivers/serial.h>
+#include <string.h>
+
+#define TRACE_MASK          (TRACE_ENTRIES - 1)
+
+_Static_assert((TRACE_ENTRIES & TRACE_MASK) == 0, "TRACE_ENTRIES must be a power of two");
+
+/* ===== EVENT NAMES ===== */
+static const char *const trace_event_names[TRACE_NUM_EVENTS] = {
+    [TRACE_INPUT_EVENTS]    = "input_process_events",
+    [TRACE_TERMINAL_UPDATE] = "terminal_app_update",
+    [TRACE_EXPLORER_UPDATE] = "explorer_app_update",
+    [TRACE_WM_UPDATE]       = "wm_update",
+    [TRACE_WM_RENDER]       = "wm_render",
+};
+
+/* ===== STATE ===== */
+uint64_t trace_mask = 0;
+static trace_buffer_t trace_buffers[TRACE_CPUS];
+
+/* ===== RECORDING ===== */
+void trace_record(uint32_t event, uint8_t phase, uint64_t a0, uint64_t a1) {
+    uint32_t cpu = percpu_count() ? this_cpu_read(cpu_id) : 0;
+    trace_buffer_t *buf = &trace_buffers[cpu % TRACE_CPUS];
+
+    uint64_t pos = __atomic_fetch_add(&buf->head, 1, __ATOMIC_RELAXED);
+    trace_record_t *rec = &buf->records[pos & TRACE_MASK];
+    rec->tsc = rdtsc();
+    rec->cpu = (uint16_t)cpu;
+    rec->phase = phase;
+    rec->event = event;
+    rec->args[0] = a0;
+    rec->args[1] = a1;
+}
+
+void trace_start(uint64_t events) {
+    /* Timestamps are exported in microseconds */
+    if (time_tsc_hz() == 0) {
+        time_init();
+    }
+    if (TRACE_NUM_EVENTS < 64) {
+        events &= (1ULL << TRACE_NUM_EVENTS) - 1;
+    }
+    __atomic_store_n(&trace_mask, events, __ATOMIC_RELEASE);
+}
+
+void trace_stop(void) {
+    __atomic_store_n(&trace_mask, 0, __ATOMIC_RELEASE);
+}
+
+void trace_clear(void) {
+    trace_stop();
+    for (uint32_t i = 0; i < TRACE_CPUS; i++) {
+        __atomic_store_n(&trace_buffers[i].head, 0, __ATOMIC_RELAXED);
+    }
+}
+
+/* ===== EXPORT ===== */
+/* ns as microseconds with three decimals, the unit "ts" is in */
+static size_t trace_format_us(char *buf, size_t size, uint64_t ns) {
+    uint32_t frac = (uint32_t)(ns % 1000);
+    return klog_format(buf, size, "%lu.%u%u%u", ns / 1000,
+                       frac / 100, frac / 10 % 10, frac % 10);
+}
+
+/*
+ * Tracing is stopped for the dump so the buffers hold still. The JSON
+ * goes straight to the UART, after any queued log lines, so it can be
+ * cut out of the serial capture between the two marker lines.
+ */
+void trace_dump(void) {
+    uint64_t mask = trace_mask;
+    trace_stop();
+
+    uint64_t base, mult;
+    time_get_scale(&base, &mult);
+
+    KINFO("trace: Chrome JSON follows on COM1");
+    klog_flush();
+
+    char line[192];
+    char ts[32];
+    bool first = true;
+
+    serial_write("{\"traceEvents\":[\n");
+    for (uint32_t c = 0; c < TRACE_CPUS; c++) {
+        trace_buffer_t *buf = &trace_buffers[c];
+        uint64_t head = buf->head;
+        uint64_t start = head > TRACE_ENTRIES ? head - TRACE_ENTRIES : 0;
+
+        for (uint64_t pos = start; pos < head; pos++) {
+            const trace_record_t *rec = &buf->records[pos & TRACE_MASK];
+            if (rec->event >= TRACE_NUM_EVENTS) continue;
+
+            trace_format_us(ts, sizeof(ts),
+                            rec->tsc > base ? time_cycles_to_ns(rec->tsc - base) : 0);
+            klog_format(line, sizeof(line),
+                        "%s{\"name\":\"%s\",\"ph\":\"%s\",\"ts\":%s,\"pid\":0,\"tid\":%u"
+                        ",\"args\":{\"a0\":%lu,\"a1\":%lu}}",
+                        first ? "" : ",\n", trace_event_names[rec->event],
+                        rec->phase == TRACE_PHASE_BEGIN ? "B" :
+                        rec->phase == TRACE_PHASE_END ? "E" : "i",
+                        ts, (uint32_t)rec->cpu, rec->args[0], rec->args[1]);
+            serial_write(line);
+            first = false;
+        }
+    }
+    serial_write("\n],\"displayTimeUnit\":\"ns\"}\n");
+    serial_flush();
+
+    KINFO("trace: end of JSON");
+    __atomic_store_n(&trace_mask, mask, __ATOMIC_RELEASE);
+}
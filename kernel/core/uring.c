@@ -0,0 +1,402 @@
+/*
+ * Batched Submission Ring Implementation
+ * SQE dispatch, SYS_URING_SETUP/ENTER and the SQPOLL kernel thread
+ */
+
+#include <kernel/uring.h>
+#include <kernel/kernel.h>
+#include <kernel/process.h>
+#include <kernel/syscall.h>
+#include <kernel/ipc.h>
+#include <kernel/fd.h>
+#include <ui/wm.h>
+#include <string.h>
+
+/* ===== STATE ===== */
+static uring_t uring_table[URING_MAX_RINGS];
+static spinlock_t uring_lock;
+static kpid_t uring_poller = 0;     /* SQPOLL thread, while any SQPOLL ring exists */
+static kpid_t uring_poller_stopping = 0;    /* Told to exit, not reaped yet */
+
+_Static_assert(sizeof(uring_sqe_t) == 64, "SQEs are one cache line");
+
+/* ===== USER MEMORY ===== */
+/*
+ * Make [addr, addr + len) of the owner's space present (and writable
+ * if the kernel will store to it) before touching it: a request names
+ * lazily mapped buffers, and a kernel-mode fault is not recoverable.
+ */
+static bool uring_user_range(uring_t *ring, uint64_t addr, uint64_t len, bool write) {
+    if (len == 0) return true;
+    if (addr >= USER_SPACE_END || len > USER_SPACE_END - addr) return false;
+
+    for (vaddr_t page = ALIGN_DOWN(addr, PAGE_SIZE); page < addr + len; page += PAGE_SIZE) {
+        /* The owner may be faulting or unmapping the same tables */
+        spinlock_acquire(&ring->as->lock);
+        uint64_t *pte = vmm_walk(ring->as->pml4, page, false);
+        uint64_t entry = pte ? *pte : 0;
+        spinlock_release(&ring->as->lock);
+
+        bool present = entry & PTE_PRESENT;
+        if (present && (!write || (entry & PTE_WRITABLE))) continue;
+
+        uint64_t error = PF_USER | (present ? PF_PRESENT : 0) | (write ? PF_WRITE : 0);
+        if (vmm_handle_fault(ring->as, page, error) != VMM_FAULT_RESOLVED) return false;
+    }
+    return true;
+}
+
+/* ===== OPERATIONS ===== */
+static int64_t uring_rw(uring_t *ring, const uring_sqe_t *sqe) {
+    file_t *file = fd_get(ring->files, sqe->fd);
+    if (!file || !file->ops) return (int64_t)SYSCALL_EBADF;
+
+    bool write = sqe->opcode == URING_OP_WRITE;
+    if (write ? !file->ops->write : !file->ops->read) return (int64_t)SYSCALL_EINVAL;
+
+    /* A read stores into the user buffer, a write loads from it */
+    if (!uring_user_range(ring, sqe->addr, sqe->len, !write)) return (int64_t)SYSCALL_EFAULT;
+
+    uint64_t off = sqe->off == URING_OFF_CURRENT ? file->offset : sqe->off;
+    int64_t res = write
+        ? file->ops->write(file, off, (const void *)(uintptr_t)sqe->addr, sqe->len)
+        : file->ops->read(file, off, (void *)(uintptr_t)sqe->addr, sqe->len);
+
+    if (res > 0 && sqe->off == URING_OFF_CURRENT) file->offset += (uint64_t)res;
+    return res;
+}
+
+static int64_t uring_window_op(uring_t *ring, const uring_sqe_t *sqe) {
+    uint32_t id = (uint32_t)sqe->fd;
+    uint32_t lo = (uint32_t)sqe->off;
+    uint32_t hi = (uint32_t)(sqe->off >> 32);
+
+    kpid_t owner = wm_window_owner(id);
+    if (owner == 0) return (int64_t)SYSCALL_EBADF;
+    if (owner != ring->owner) return (int64_t)SYSCALL_EPERM;
+
+    switch (sqe->opcode) {
+        case URING_OP_WIN_MOVE:   wm_move_window(id, lo, hi); break;
+        case URING_OP_WIN_RESIZE: wm_resize_window(id, lo, hi); break;
+        case URING_OP_WIN_SHOW:   wm_show_window(id); break;
+        case URING_OP_WIN_HIDE:   wm_hide_window(id); break;
+        case URING_OP_WIN_RAISE:  wm_raise_window(id); break;
+        case URING_OP_WIN_FOCUS:  wm_focus_window(id); break;
+        default: return (int64_t)SYSCALL_EINVAL;
+    }
+    return 0;
+}
+
+static int64_t uring_execute(uring_t *ring, const uring_sqe_t *sqe) {
+    switch (sqe->opcode) {
+        case URING_OP_NOP:
+            return 0;
+        case URING_OP_READ:
+        case URING_OP_WRITE:
+            return uring_rw(ring, sqe);
+        case URING_OP_IPC_NOTIFY:
+            return ipc_notify(sqe->addr) == 0 ? 0 : (int64_t)SYSCALL_EINVAL;
+        case URING_OP_WIN_MOVE:
+        case URING_OP_WIN_RESIZE:
+        case URING_OP_WIN_SHOW:
+        case URING_OP_WIN_HIDE:
+        case URING_OP_WIN_RAISE:
+        case URING_OP_WIN_FOCUS:
+            return uring_window_op(ring, sqe);
+        default:
+            return (int64_t)SYSCALL_EINVAL;
+    }
+}
+
+/* ===== SUBMISSION ===== */
+/* Caller runs with the owner's address space loaded */
+uint32_t uring_submit(uring_t *ring, uint32_t max) {
+    uring_shared_t *shared = ring->shared;
+    uint32_t tail = __atomic_load_n(&shared->sq_tail, __ATOMIC_ACQUIRE);
+    uint32_t done = 0;
+
+    /* A tail more than a ring ahead is garbage; take one ring's worth */
+    if (tail - ring->sq_head > ring->sq_entries) tail = ring->sq_head + ring->sq_entries;
+
+    while (done < max && ring->sq_head != tail) {
+        uint32_t cq_head = __atomic_load_n(&shared->cq_head, __ATOMIC_ACQUIRE);
+        if (ring->cq_tail - cq_head >= ring->cq_entries) {
+            __atomic_or_fetch(&shared->flags, URING_F_CQ_FULL, __ATOMIC_RELEASE);
+            break;
+        }
+
+        /* Copy first: the process may rewrite the slot at any time */
+        uring_sqe_t sqe = ring->sqes[ring->sq_head & (ring->sq_entries - 1)];
+        int64_t res = uring_execute(ring, &sqe);
+
+        uring_cqe_t *cqe = &ring->cqes[ring->cq_tail & (ring->cq_entries - 1)];
+        cqe->user_data = sqe.user_data;
+        cqe->res = res;
+
+        ring->cq_tail++;
+        ring->sq_head++;
+        __atomic_store_n(&shared->cq_tail, ring->cq_tail, __ATOMIC_RELEASE);
+        done++;
+    }
+
+    __atomic_store_n(&shared->sq_head, ring->sq_head, __ATOMIC_RELEASE);
+    if (done && ring->sq_head == tail) {
+        __atomic_and_fetch(&shared->flags, ~URING_F_CQ_FULL, __ATOMIC_RELEASE);
+    }
+    return done;
+}
+
+/* ===== SQPOLL THREAD ===== */
+static bool uring_poll_pending(void) {
+    for (uint32_t i = 0; i < URING_MAX_RINGS; i++) {
+        uring_t *ring = &uring_table[i];
+        if (!ring->in_use || !(ring->flags & URING_SETUP_SQPOLL)) continue;
+        if (__atomic_load_n(&ring->shared->sq_tail, __ATOMIC_ACQUIRE) != ring->sq_head) return true;
+    }
+    return false;
+}
+
+static void uring_poll_set_flag(bool need_wakeup) {
+    for (uint32_t i = 0; i < URING_MAX_RINGS; i++) {
+        uring_t *ring = &uring_table[i];
+        if (!ring->in_use || !(ring->flags & URING_SETUP_SQPOLL)) continue;
+        if (need_wakeup) {
+            __atomic_or_fetch(&ring->shared->flags, URING_F_NEED_WAKEUP, __ATOMIC_SEQ_CST);
+        } else {
+            __atomic_and_fetch(&ring->shared->flags, ~URING_F_NEED_WAKEUP, __ATOMIC_SEQ_CST);
+        }
+    }
+}
+
+/*
+ * Drains every SQPOLL ring, yielding between passes. After
+ * URING_POLL_IDLE empty passes it advertises URING_F_NEED_WAKEUP and
+ * blocks until a SYS_URING_ENTER kicks it. Rings are only created and
+ * destroyed by other threads, never while this one is running, so the
+ * table needs no lock here. It returns, and so exits, once the last
+ * SQPOLL ring is destroyed.
+ */
+static void uring_poll_thread(void *arg) {
+    (void)arg;
+    kpid_t self = process_get_current()->pid;
+    uint32_t idle = 0;
+
+    for (;;) {
+        uint32_t work = 0;
+
+        if (__atomic_load_n(&uring_poller_stopping, __ATOMIC_ACQUIRE) == self) return;
+
+        for (uint32_t i = 0; i < URING_MAX_RINGS; i++) {
+            uring_t *ring = &uring_table[i];
+            if (!ring->in_use || !(ring->flags & URING_SETUP_SQPOLL)) continue;
+
+            vmm_switch_address_space(ring->as);
+            work += uring_submit(ring, ring->sq_entries);
+        }
+
+        if (work) {
+            idle = 0;
+        } else if (++idle >= URING_POLL_IDLE) {
+            /* Publish the flag, then look once more: a submitter may have missed it */
+            uring_poll_set_flag(true);
+            if (!uring_poll_pending()) {
+                process_block(self);
+            }
+            scheduler_switch();
+            uring_poll_set_flag(false);
+            idle = 0;
+            continue;
+        }
+
+        scheduler_switch();
+    }
+}
+
+static void uring_poll_kick(void) {
+    if (uring_poller) process_wake(uring_poller);
+}
+
+/* ===== RING LIFETIME ===== */
+uring_t *uring_create(process_t *proc, vaddr_t addr, uint32_t entries, uint32_t flags) {
+    if (entries == 0 || entries > URING_MAX_ENTRIES || (entries & (entries - 1)) ||
+        (addr & (PAGE_SIZE - 1)) || (flags & ~URING_SETUP_SQPOLL) || !proc->address_space) {
+        return NULL;
+    }
+
+    uint32_t sqes_offset = PAGE_SIZE;
+    uint32_t cqes_offset = sqes_offset + entries * sizeof(uring_sqe_t);
+    uint64_t size = ALIGN_UP(cqes_offset + 2 * entries * sizeof(uring_cqe_t), PAGE_SIZE);
+    if (addr >= USER_SPACE_END || size > USER_SPACE_END - addr) return NULL;
+
+    uint32_t num_frames = (uint32_t)(size / PAGE_SIZE);
+    paddr_t frames = vmm_alloc_frames(num_frames);
+    if (!frames) return NULL;
+
+    uint8_t *base = (uint8_t *)phys_to_virt(frames);
+    memset(base, 0, size);
+
+    uring_shared_t *shared = (uring_shared_t *)base;
+    shared->sq_entries = entries;
+    shared->cq_entries = 2 * entries;
+    shared->sqes_offset = sqes_offset;
+    shared->cqes_offset = cqes_offset;
+
+    vm_area_t area = {
+        .start = addr,
+        .end = addr + size,
+        .prot = VMA_READ | VMA_WRITE | VMA_USER,
+        .type = VMA_SHARED,
+    };
+
+    spinlock_acquire(&uring_lock);
+    uring_t *ring = NULL;
+    for (uint32_t i = 0; i < URING_MAX_RINGS; i++) {
+        if (!uring_table[i].in_use) {
+            ring = &uring_table[i];
+            ring->in_use = true;
+            break;
+        }
+    }
+    spinlock_release(&uring_lock);
+
+    if (!ring || vmm_map_shared(proc->address_space, &area, frames) != 0) {
+        if (ring) ring->in_use = false;
+        for (uint32_t i = 0; i < num_frames; i++) {
+            vmm_free_frame(frames + (paddr_t)i * PAGE_SIZE);
+        }
+        return NULL;
+    }
+
+    ring->shared = shared;
+    ring->sqes = (uring_sqe_t *)(base + sqes_offset);
+    ring->cqes = (uring_cqe_t *)(base + cqes_offset);
+    ring->sq_entries = entries;
+    ring->cq_entries = 2 * entries;
+    ring->sq_head = 0;
+    ring->cq_tail = 0;
+    ring->frames = frames;
+    ring->num_frames = num_frames;
+    ring->owner = proc->pid;
+    ring->as = proc->address_space;
+    ring->files = proc->files;
+
+    /* Last: the poller picks up rings whose flags say SQPOLL */
+    __atomic_store_n(&ring->flags, flags, __ATOMIC_RELEASE);
+    return ring;
+}
+
+/* Caller holds uring_lock */
+static bool uring_sqpoll_in_use_locked(void) {
+    for (uint32_t i = 0; i < URING_MAX_RINGS; i++) {
+        if (uring_table[i].in_use && (uring_table[i].flags & URING_SETUP_SQPOLL)) return true;
+    }
+    return false;
+}
+
+/* Caller holds uring_lock; returns the poller to wake once it is released */
+static kpid_t uring_poller_retire_locked(void) {
+    if (!uring_poller || uring_sqpoll_in_use_locked()) return 0;
+
+    kpid_t stop = uring_poller;
+    uring_poller = 0;
+    __atomic_store_n(&uring_poller_stopping, stop, __ATOMIC_RELEASE);
+    return stop;
+}
+
+/* The owner's mapping keeps its own frame references until its space goes */
+void uring_destroy(uring_t *ring) {
+    if (!ring) return;
+
+    kpid_t stop = 0;
+
+    spinlock_acquire(&uring_lock);
+    bool polled = ring->flags & URING_SETUP_SQPOLL;
+    ring->flags = 0;
+    ring->in_use = false;
+    if (polled) stop = uring_poller_retire_locked();
+    spinlock_release(&uring_lock);
+
+    /* It sees the request on its next pass and exits; SYS_URING_SETUP reaps it */
+    if (stop) process_wake(stop);
+
+    for (uint32_t i = 0; i < ring->num_frames; i++) {
+        vmm_free_frame(ring->frames + (paddr_t)i * PAGE_SIZE);
+    }
+}
+
+/* ===== SYSTEM CALLS ===== */
+static uint64_t sys_uring_setup(uint64_t entries, uint64_t addr, uint64_t flags,
+                                uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a3; (void)a4; (void)a5;
+    process_t *proc = process_get_current();
+    if (!proc || !proc->address_space) return SYSCALL_EINVAL;
+    if (proc->uring) return SYSCALL_EBUSY;
+
+    if ((flags & URING_SETUP_SQPOLL) && !uring_poller) {
+        /* The previous poller was woken to exit: let it run until it has */
+        if (uring_poller_stopping) {
+            while (process_get_by_pid(uring_poller_stopping) &&
+                   process_reap(uring_poller_stopping, NULL) != 0) {
+                scheduler_switch();
+            }
+            uring_poller_stopping = 0;
+        }
+        uring_poller = kthread_create("uring-sqpoll", uring_poll_thread, NULL);
+        if (uring_poller == (kpid_t)-1) {
+            uring_poller = 0;
+            return SYSCALL_ENOMEM;
+        }
+    }
+
+    uring_t *ring = uring_create(proc, addr, (uint32_t)entries, (uint32_t)flags);
+    if (!ring) {
+        /* Don't leave a poller behind with no ring to poll */
+        if (flags & URING_SETUP_SQPOLL) {
+            spinlock_acquire(&uring_lock);
+            kpid_t stop = uring_poller_retire_locked();
+            spinlock_release(&uring_lock);
+            if (stop) process_wake(stop);
+        }
+        return SYSCALL_EINVAL;
+    }
+
+    proc->uring = ring;
+    if (flags & URING_SETUP_SQPOLL) uring_poll_kick();
+    return 0;
+}
+
+static uint64_t sys_uring_enter(uint64_t to_submit, uint64_t min_complete, uint64_t flags,
+                                uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a3; (void)a4; (void)a5;
+    process_t *proc = process_get_current();
+    uring_t *ring = proc ? proc->uring : NULL;
+    if (!ring) return SYSCALL_EBADF;
+
+    bool polled = ring->flags & URING_SETUP_SQPOLL;
+    uint32_t submitted = 0;
+
+    if (!polled) {
+        submitted = uring_submit(ring, (uint32_t)to_submit);
+    } else if (flags & URING_ENTER_SQ_WAKEUP) {
+        uring_poll_kick();
+    }
+
+    /* Without SQPOLL every consumed SQE has completed by now */
+    if ((flags & URING_ENTER_GETEVENTS) && polled) {
+        while (ring->cq_tail - __atomic_load_n(&ring->shared->cq_head, __ATOMIC_ACQUIRE) < min_complete &&
+               __atomic_load_n(&ring->shared->sq_tail, __ATOMIC_ACQUIRE) != ring->sq_head) {
+            uring_poll_kick();
+            scheduler_switch();
+        }
+    }
+
+    return submitted;
+}
+
+/* ===== INITIALIZATION ===== */
+void uring_init(void) {
+    spinlock_init(&uring_lock);
+
+    syscall_register(SYS_URING_SETUP, sys_uring_setup);
+    syscall_register(SYS_URING_ENTER, sys_uring_enter);
+}
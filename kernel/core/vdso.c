@@ -0,0 +1,81 @@
+/*
+ * vDSO Data Page Implementation
+ * One kernel-written page, mapped read-only into every address space
+ */
+
+#include <kernel/vdso.h>
+#include <kernel/kernel.h>
+#include <kernel/vmm.h>
+#include <kernel/cpu.h>
+#include <kernel/percpu.h>
+#include <kernel/time.h>
+#include <string.h>
+
+/* ===== STATE ===== */
+static paddr_t vdso_frame = 0;          /* The kernel keeps one reference forever */
+static vdso_data_t *vdso_page = NULL;
+static spinlock_t vdso_lock;
+
+static bool vdso_setup(void) {
+    if (vdso_frame) return true;
+    if (!vmm_ready()) return false;
+
+    paddr_t frame = vmm_alloc_frame();
+    if (!frame) return false;
+    memset(phys_to_virt(frame), 0, PAGE_SIZE);
+
+    vdso_page = (vdso_data_t *)phys_to_virt(frame);
+    vdso_page->version = VDSO_VERSION;
+    vdso_frame = frame;
+
+    vdso_update_clock();
+    return true;
+}
+
+/* ===== WRITERS ===== */
+void vdso_update_clock(void) {
+    if (!vdso_page) return;
+
+    if (time_tsc_hz() == 0) {
+        time_init();
+    }
+
+    uint64_t base, mult;
+    time_get_scale(&base, &mult);
+
+    /* Readers retry while the sequence is odd or has moved */
+    __atomic_add_fetch(&vdso_page->sequence, 1, __ATOMIC_RELEASE);
+    vdso_page->tsc_base = base;
+    vdso_page->ns_mult = mult;
+    vdso_page->tsc_hz = time_tsc_hz();
+    __atomic_add_fetch(&vdso_page->sequence, 1, __ATOMIC_RELEASE);
+}
+
+void vdso_set_current(kpid_t pid) {
+    if (vdso_page) {
+        vdso_page->current_pid[this_cpu_read(cpu_id)] = pid;
+    }
+}
+
+/* ===== MAPPING ===== */
+int vdso_map(address_space_t *as) {
+    spinlock_acquire(&vdso_lock);
+    bool ready = vdso_setup();
+    spinlock_release(&vdso_lock);
+    if (!ready) return -1;
+
+    uint64_t flags = PTE_USER;
+    if (rdmsr(MSR_EFER) & EFER_NXE) flags |= PTE_NX;
+
+    /* Each mapping holds a reference, dropped when the space is destroyed */
+    vmm_get_frame(vdso_frame);
+
+    spinlock_acquire(&as->lock);
+    int result = vmm_map_page(as, VDSO_BASE, vdso_frame, flags);
+    spinlock_release(&as->lock);
+
+    if (result != 0) {
+        vmm_free_frame(vdso_frame);
+    }
+    return result;
+}
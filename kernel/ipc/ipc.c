@@ -0,0 +1,250 @@
+/*
+ * IPC Channel Implementation
+ * Channel allocation, capability checks, mapping and doorbells
+ */
+
+#include <kernel/ipc.h>
+#include <kernel/kernel.h>
+#include <kernel/vmm.h>
+#include <kernel/cpu.h>
+#include <kernel/process.h>
+#include <kernel/syscall.h>
+#include <string.h>
+
+/* ===== CHANNEL TABLE ===== */
+typedef struct {
+    paddr_t frames;             /* Header page + data area, physically contiguous */
+    uint32_t num_frames;
+    uint32_t key;               /* Upper half of the handle */
+    kpid_t end_owner[2];        /* Indexed by ipc_end_t */
+    bool end_bound[2];
+    bool in_use;
+} ipc_channel_t;
+
+static ipc_channel_t ipc_channels[IPC_MAX_CHANNELS];
+static spinlock_t ipc_lock;
+
+static uint32_t ipc_new_key(uint32_t index) {
+    uint64_t k = (rdtsc() ^ ((uint64_t)index << 40)) * 0x9E3779B97F4A7C15ULL;
+    uint32_t key = (uint32_t)(k >> 32);
+    return key ? key : 1;
+}
+
+static inline ipc_handle_t ipc_make_handle(uint32_t index, uint32_t key) {
+    return ((uint64_t)key << 32) | (index + 1);
+}
+
+/* Caller holds ipc_lock */
+static ipc_channel_t *ipc_lookup_locked(ipc_handle_t handle) {
+    uint32_t index = (uint32_t)handle - 1;
+    if (index >= IPC_MAX_CHANNELS) return NULL;
+
+    ipc_channel_t *chan = &ipc_channels[index];
+    if (!chan->in_use || chan->key != (uint32_t)(handle >> 32)) return NULL;
+    return chan;
+}
+
+/* ===== CHANNEL LIFETIME ===== */
+ipc_handle_t ipc_channel_create(uint64_t data_size) {
+    if (data_size < IPC_MIN_RING_SIZE || data_size > IPC_MAX_RING_SIZE ||
+        (data_size & (data_size - 1))) {
+        return IPC_INVALID_HANDLE;
+    }
+
+    uint32_t num_frames = (uint32_t)((IPC_RING_HEADER + data_size) / PAGE_SIZE);
+    paddr_t frames = vmm_alloc_frames(num_frames);
+    if (!frames) return IPC_INVALID_HANDLE;
+
+    ipc_ring_t *ring = (ipc_ring_t *)phys_to_virt(frames);
+    memset(ring, 0, IPC_RING_HEADER);
+    ring->data_size = data_size;
+
+    spinlock_acquire(&ipc_lock);
+    for (uint32_t i = 0; i < IPC_MAX_CHANNELS; i++) {
+        ipc_channel_t *chan = &ipc_channels[i];
+        if (chan->in_use) continue;
+
+        chan->frames = frames;
+        chan->num_frames = num_frames;
+        chan->key = ipc_new_key(i);
+        chan->end_owner[IPC_END_PRODUCER] = chan->end_owner[IPC_END_CONSUMER] = 0;
+        chan->end_bound[IPC_END_PRODUCER] = chan->end_bound[IPC_END_CONSUMER] = false;
+        chan->in_use = true;
+
+        ipc_handle_t handle = ipc_make_handle(i, chan->key);
+        spinlock_release(&ipc_lock);
+        return handle;
+    }
+    spinlock_release(&ipc_lock);
+
+    for (uint32_t i = 0; i < num_frames; i++) {
+        vmm_free_frame(frames + (paddr_t)i * PAGE_SIZE);
+    }
+    return IPC_INVALID_HANDLE;
+}
+
+/* Frames live on while any address space still maps them */
+void ipc_channel_close(ipc_handle_t handle) {
+    spinlock_acquire(&ipc_lock);
+    ipc_channel_t *chan = ipc_lookup_locked(handle);
+    if (!chan) {
+        spinlock_release(&ipc_lock);
+        return;
+    }
+    paddr_t frames = chan->frames;
+    uint32_t num_frames = chan->num_frames;
+    chan->in_use = false;
+    spinlock_release(&ipc_lock);
+
+    for (uint32_t i = 0; i < num_frames; i++) {
+        vmm_free_frame(frames + (paddr_t)i * PAGE_SIZE);
+    }
+}
+
+ipc_ring_t *ipc_channel_ring(ipc_handle_t handle) {
+    spinlock_acquire(&ipc_lock);
+    ipc_channel_t *chan = ipc_lookup_locked(handle);
+    ipc_ring_t *ring = chan ? (ipc_ring_t *)phys_to_virt(chan->frames) : NULL;
+    spinlock_release(&ipc_lock);
+    return ring;
+}
+
+/* ===== MAPPING ===== */
+int ipc_channel_map(ipc_handle_t handle, address_space_t *as, vaddr_t addr,
+                    ipc_end_t end, kpid_t owner) {
+    if ((end != IPC_END_PRODUCER && end != IPC_END_CONSUMER) ||
+        (addr & (PAGE_SIZE - 1))) {
+        return -1;
+    }
+
+    spinlock_acquire(&ipc_lock);
+    ipc_channel_t *chan = ipc_lookup_locked(handle);
+    if (!chan || chan->end_bound[end] ||
+        addr >= USER_SPACE_END ||
+        (vaddr_t)chan->num_frames * PAGE_SIZE > USER_SPACE_END - addr) {
+        spinlock_release(&ipc_lock);
+        return -1;
+    }
+    chan->end_bound[end] = true;
+    chan->end_owner[end] = owner;
+    paddr_t frames = chan->frames;
+    uint32_t num_frames = chan->num_frames;
+    spinlock_release(&ipc_lock);
+
+    /* Both ends write the header; only the producer writes the data area */
+    vm_area_t header = {
+        .start = addr,
+        .end = addr + IPC_RING_HEADER,
+        .prot = VMA_READ | VMA_WRITE | VMA_USER,
+        .type = VMA_SHARED,
+    };
+    vm_area_t data = {
+        .start = header.end,
+        .end = addr + (vaddr_t)num_frames * PAGE_SIZE,
+        .prot = VMA_READ | VMA_USER | (end == IPC_END_PRODUCER ? VMA_WRITE : 0),
+        .type = VMA_SHARED,
+    };
+
+    if (vmm_map_shared(as, &header, frames) == 0) {
+        if (vmm_map_shared(as, &data, frames + IPC_RING_HEADER) == 0) {
+            return 0;
+        }
+        vmm_remove_areas(as, header.start, header.end);
+    }
+
+    /* The end can be bound again, by this process or another */
+    spinlock_acquire(&ipc_lock);
+    chan = ipc_lookup_locked(handle);
+    if (chan) {
+        chan->end_bound[end] = false;
+        chan->end_owner[end] = 0;
+    }
+    spinlock_release(&ipc_lock);
+    return -1;
+}
+
+/* ===== DOORBELL ===== */
+int ipc_notify(ipc_handle_t handle) {
+    spinlock_acquire(&ipc_lock);
+    ipc_channel_t *chan = ipc_lookup_locked(handle);
+    if (!chan) {
+        spinlock_release(&ipc_lock);
+        return -1;
+    }
+    ipc_ring_t *ring = (ipc_ring_t *)phys_to_virt(chan->frames);
+    kpid_t consumer = chan->end_owner[IPC_END_CONSUMER];
+    spinlock_release(&ipc_lock);
+
+    __atomic_store_n(&ring->consumer_waiting, 0, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&ring->doorbell, 1, __ATOMIC_RELEASE);
+    if (consumer) {
+        process_wake(consumer);
+    }
+    return 0;
+}
+
+/* Nothing committed since prepare_wait, and no doorbell rung */
+static bool ipc_ring_empty(void *arg) {
+    ipc_ring_t *ring = (ipc_ring_t *)arg;
+    return __atomic_load_n(&ring->consumer_waiting, __ATOMIC_ACQUIRE) &&
+           __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == ring->tail;
+}
+
+int ipc_wait(ipc_handle_t handle, kpid_t pid) {
+    ipc_ring_t *ring = ipc_channel_ring(handle);
+    if (!ring) return -1;
+
+    /*
+     * The producer may commit at any point up to the block: checked
+     * again under the lock its process_wake() takes, so a notify after
+     * the check finds us WAITING and one before it stops the block.
+     */
+    int blocked = process_block_if(pid, ipc_ring_empty, ring);
+    if (blocked == 0) {
+        scheduler_switch();
+    } else if (blocked > 0) {
+        __atomic_store_n(&ring->consumer_waiting, 0, __ATOMIC_RELAXED);
+    }
+    return 0;
+}
+
+/* ===== SYSTEM CALLS ===== */
+static uint64_t sys_ipc_create(uint64_t size, uint64_t a1, uint64_t a2,
+                               uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a1; (void)a2; (void)a3; (void)a4; (void)a5;
+    ipc_handle_t handle = ipc_channel_create(size);
+    return handle != IPC_INVALID_HANDLE ? handle : SYSCALL_EINVAL;
+}
+
+static uint64_t sys_ipc_map(uint64_t handle, uint64_t addr, uint64_t end,
+                            uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a3; (void)a4; (void)a5;
+    process_t *proc = process_get_current();
+    if (!proc || !proc->address_space || addr >= USER_SPACE_END) return SYSCALL_EINVAL;
+    return ipc_channel_map(handle, proc->address_space, addr, (ipc_end_t)end, proc->pid) == 0
+           ? 0 : SYSCALL_EINVAL;
+}
+
+static uint64_t sys_ipc_notify(uint64_t handle, uint64_t a1, uint64_t a2,
+                               uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a1; (void)a2; (void)a3; (void)a4; (void)a5;
+    return ipc_notify(handle) == 0 ? 0 : SYSCALL_EINVAL;
+}
+
+static uint64_t sys_ipc_wait(uint64_t handle, uint64_t a1, uint64_t a2,
+                             uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a1; (void)a2; (void)a3; (void)a4; (void)a5;
+    process_t *proc = process_get_current();
+    if (!proc) return SYSCALL_EINVAL;
+    return ipc_wait(handle, proc->pid) == 0 ? 0 : SYSCALL_EINVAL;
+}
+
+/* ===== INITIALIZATION ===== */
+void ipc_init(void) {
+    spinlock_init(&ipc_lock);
+
+    syscall_register(SYS_IPC_CREATE, sys_ipc_create);
+    syscall_register(SYS_IPC_MAP, sys_ipc_map);
+    syscall_register(SYS_IPC_NOTIFY, sys_ipc_notify);
+    syscall_register(SYS_IPC_WAIT, sys_ipc_wait);
+}
@@ -0,0 +1,208 @@
+/*
+ * Lock Contention Statistics Implementation
+ * Records acquisitions, contention, wait and hold times per lock site
+ */
+
+#include <kernel/lockstat.h>
+#include <kernel/kernel.h>
+#include <kernel/cpu.h>
+#include <stddef.h>
+
+#ifdef CONFIG_LOCKSTAT
+
+/* ===== SITE TABLE ===== */
+static lockstat_site_t lockstat_sites[LOCKSTAT_MAX_SITES];
+static volatile uint32_t lockstat_table_lock;  /* Raw flag: must not recurse into lockstat */
+static uint64_t lockstat_dropped;              /* Acquisitions with no free slot */
+
+static inline uint32_t lockstat_hash(const char *name, const char *file, int line) {
+    uint64_t h = (uint64_t)(uintptr_t)name * 0x9E3779B97F4A7C15ULL;
+    h ^= (uint64_t)(uintptr_t)file + (uint64_t)line * 0xC2B2AE3D27D4EB4FULL;
+    h ^= h >> 29;
+    return (uint32_t)h % LOCKSTAT_MAX_SITES;
+}
+
+static inline bool lockstat_site_matches(lockstat_site_t *s, const char *name,
+                                         const char *file, int line) {
+    return s->name == name && s->file == file && s->line == line;
+}
+
+static lockstat_site_t *lockstat_lookup(const char *name, const char *file, int line) {
+    uint32_t start = lockstat_hash(name, file, line);
+
+    /* Fast path: published slots are immutable, no locking needed */
+    for (uint32_t i = 0; i < LOCKSTAT_MAX_SITES; i++) {
+        lockstat_site_t *s = &lockstat_sites[(start + i) % LOCKSTAT_MAX_SITES];
+        if (!__atomic_load_n(&s->ready, __ATOMIC_ACQUIRE)) break;
+        if (lockstat_site_matches(s, name, file, line)) return s;
+    }
+
+    /* Slow path: claim a slot (first time this site is seen) */
+    while (__atomic_test_and_set(&lockstat_table_lock, __ATOMIC_ACQUIRE)) {
+        cpu_relax();
+    }
+
+    lockstat_site_t *found = NULL;
+    for (uint32_t i = 0; i < LOCKSTAT_MAX_SITES; i++) {
+        lockstat_site_t *s = &lockstat_sites[(start + i) % LOCKSTAT_MAX_SITES];
+        if (!s->ready) {
+            s->name = name;
+            s->file = file;
+            s->line = line;
+            __atomic_store_n(&s->ready, 1, __ATOMIC_RELEASE);
+            found = s;
+            break;
+        }
+        if (lockstat_site_matches(s, name, file, line)) {
+            found = s;
+            break;
+        }
+    }
+
+    __atomic_clear(&lockstat_table_lock, __ATOMIC_RELEASE);
+    return found;
+}
+
+static inline void lockstat_update_max(uint64_t *slot, uint64_t value) {
+    uint64_t cur = __atomic_load_n(slot, __ATOMIC_RELAXED);
+    while (value > cur &&
+           !__atomic_compare_exchange_n(slot, &cur, value, false,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+/* ===== SPINLOCK HOOKS ===== */
+void lockstat_lock_init(spinlock_t *lock, const char *name) {
+    /* spinlock_init(&foo) stringifies to "&foo" */
+    if (name && name[0] == '&') name++;
+
+    lock->locked = 0;
+    lock->name = name;
+    lock->acquired_at = 0;
+    lock->holder_site = NULL;
+}
+
+/* Account an acquisition that has just succeeded */
+static void lockstat_acquired(spinlock_t *lock, const char *file, int line,
+                              bool contended, uint64_t wait) {
+    /* Statically zeroed locks that never saw spinlock_init() */
+    const char *name = lock->name ? lock->name : "<unnamed>";
+    lockstat_site_t *site = lockstat_lookup(name, file, line);
+
+    if (site) {
+        __atomic_fetch_add(&site->acquisitions, 1, __ATOMIC_RELAXED);
+        if (contended) {
+            __atomic_fetch_add(&site->contended, 1, __ATOMIC_RELAXED);
+            __atomic_fetch_add(&site->wait_total, wait, __ATOMIC_RELAXED);
+            lockstat_update_max(&site->wait_max, wait);
+        }
+    } else {
+        __atomic_fetch_add(&lockstat_dropped, 1, __ATOMIC_RELAXED);
+    }
+
+    lock->holder_site = site;
+    lock->acquired_at = rdtsc();
+}
+
+void lockstat_acquire(spinlock_t *lock, const char *file, int line) {
+    uint64_t wait = 0;
+    bool contended = false;
+
+    if (__atomic_test_and_set(&lock->locked, __ATOMIC_ACQUIRE)) {
+        uint64_t start = rdtsc();
+        contended = true;
+        do {
+            cpu_relax();
+        } while (__atomic_test_and_set(&lock->locked, __ATOMIC_ACQUIRE));
+        wait = rdtsc() - start;
+    }
+    lockstat_acquired(lock, file, line, contended, wait);
+}
+
+/* A failed attempt is not an acquisition and is not counted */
+bool lockstat_try_acquire(spinlock_t *lock, const char *file, int line) {
+    if (__atomic_test_and_set(&lock->locked, __ATOMIC_ACQUIRE)) return false;
+    lockstat_acquired(lock, file, line, false, 0);
+    return true;
+}
+
+void lockstat_release(spinlock_t *lock) {
+    lockstat_site_t *site = lock->holder_site;
+
+    if (site) {
+        lockstat_update_max(&site->hold_max, rdtsc() - lock->acquired_at);
+    }
+    lock->holder_site = NULL;
+
+    __atomic_clear(&lock->locked, __ATOMIC_RELEASE);
+}
+
+/* ===== REPORTING ===== */
+bool lockstat_enabled(void) {
+    return true;
+}
+
+void lockstat_dump(void) {
+    lockstat_site_t *ranked[LOCKSTAT_MAX_SITES];
+    size_t count = 0;
+
+    for (uint32_t i = 0; i < LOCKSTAT_MAX_SITES; i++) {
+        if (__atomic_load_n(&lockstat_sites[i].ready, __ATOMIC_ACQUIRE)) {
+            ranked[count++] = &lockstat_sites[i];
+        }
+    }
+
+    /* Rank by total wait cycles, then by acquisitions (insertion sort) */
+    for (size_t i = 1; i < count; i++) {
+        lockstat_site_t *s = ranked[i];
+        size_t j = i;
+        while (j > 0 &&
+               (ranked[j - 1]->wait_total < s->wait_total ||
+                (ranked[j - 1]->wait_total == s->wait_total &&
+                 ranked[j - 1]->acquisitions < s->acquisitions))) {
+            ranked[j] = ranked[j - 1];
+            j--;
+        }
+        ranked[j] = s;
+    }
+
+    KINFO("=== Lock Statistics (%d sites, cycles) ===", (int)count);
+    for (size_t i = 0; i < count; i++) {
+        lockstat_site_t *s = ranked[i];
+        KINFO("%s @ %s:%d acq=%lu cont=%lu wait=%lu wait_max=%lu hold_max=%lu",
+              s->name, s->file, s->line,
+              s->acquisitions, s->contended, s->wait_total,
+              s->wait_max, s->hold_max);
+    }
+    if (lockstat_dropped) {
+        KINFO("lockstat: %lu acquisitions not recorded (site table full)",
+              lockstat_dropped);
+    }
+}
+
+void lockstat_reset(void) {
+    for (uint32_t i = 0; i < LOCKSTAT_MAX_SITES; i++) {
+        lockstat_site_t *s = &lockstat_sites[i];
+        __atomic_store_n(&s->acquisitions, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&s->contended, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&s->wait_total, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&s->wait_max, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&s->hold_max, 0, __ATOMIC_RELAXED);
+    }
+    lockstat_dropped = 0;
+}
+
+#else /* !CONFIG_LOCKSTAT */
+
+bool lockstat_enabled(void) {
+    return false;
+}
+
+void lockstat_dump(void) {
+    KINFO("lockstat: not enabled (rebuild with LOCKSTAT=1)");
+}
+
+void lockstat_reset(void) {
+}
+
+#endif /* CONFIG_LOCKSTAT */
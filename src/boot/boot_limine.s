@@ -1,8 +1,8 @@
 bits 64
 
 ; Limine Boot Protocol Entry Point
-; Limine bootloader provides complete 64-bit environment
-; and passes boot information via RDI (bootloader info pointer)
+; Limine bootloader provides complete 64-bit environment;
+; boot information comes back through the requests in main_limine.c
 
 section .text
 global _start
@@ -21,8 +21,10 @@ _start:
     cli                         ; Disable interrupts
     cld                         ; Clear direction flag
     
-    ; RDI contains pointer to bootloader info structure
-    ; This is already set by Limine
+    ; Our own stack, in the image: paging_enable() drops the
+    ; bootloader's mappings, Limine's stack among them
+    lea rsp, [rel kernel_stack_top]
+    xor rbp, rbp                ; Terminates frame-pointer unwinds
     
     ; Call C kernel entry point
     call kernel_main_limine
@@ -37,6 +39,6 @@ _start:
 section .bss
 align 16
 kernel_stack:
-    resq 1024              ; 8KB kernel stack
+    resb 65536             ; 64KB kernel stack
 kernel_stack_top:
 
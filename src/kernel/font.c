@@ -1,11 +1,12 @@
 /* PuppetOS Font System - Bitmap fonts */
 #include <stdint.h>
-#include <graphics.h>
+#include <font.h>
+#include <drivers/display.h>
 
 /* 8x8 bitmap font - each character is 8x8 pixels */
 /* Each byte represents one row of pixels (1 = white, 0 = transparent) */
 
-static const uint8_t font_bitmap[128][8] = {
+const uint8_t font_bitmap[128][FONT_HEIGHT] = {
     /* 32: space */
     { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
     /* 33: ! */
@@ -201,10 +202,7 @@ static const uint8_t font_bitmap[128][8] = {
 };
 
 void font_draw_char(uint32_t x, uint32_t y, char c, uint32_t fg_color, uint32_t bg_color) {
-    unsigned char uc = (unsigned char)c;
-    if (uc > 127) return;
-    
-    const uint8_t *char_bitmap = font_bitmap[uc];
+    const uint8_t *char_bitmap = font_glyph(c);
     
     for (int row = 0; row < 8; row++) {
         uint8_t byte = char_bitmap[row];
@@ -213,9 +211,9 @@ void font_draw_char(uint32_t x, uint32_t y, char c, uint32_t fg_color, uint32_t
             uint32_t pixel_y = y + row;
             
             if (byte & (1 << (7 - col))) {
-                graphics_set_pixel(pixel_x, pixel_y, fg_color);
+                graphics_draw_pixel(pixel_x, pixel_y, fg_color);
             } else {
-                graphics_set_pixel(pixel_x, pixel_y, bg_color);
+                graphics_draw_pixel(pixel_x, pixel_y, bg_color);
             }
         }
     }
@@ -101,11 +101,6 @@ void kernel_main(multiboot_tag_t *mbi, uint32_t magic) {
     idt_init();
     vga_println(&terminal, "  IDT initialized");
     
-    /* Initialize Paging */
-    vga_println(&terminal, "Initializing Paging...");
-    paging_init();
-    vga_println(&terminal, "  Paging initialized");
-    
     vga_println(&terminal, "");
     
     vga_set_color(&terminal, VGA_COLOR_LIGHT_CYAN, VGA_COLOR_BLACK);
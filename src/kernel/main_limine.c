@@ -7,57 +7,44 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <vga.h>
+#include <limine.h>
+#include <kernel/kernel.h>
+#include <kernel/process.h>
+#include <kernel/time.h>
+#include <kernel/cpu.h>
 
-/* ====== LIMINE PROTOCOL STRUCTURES ====== */
-
-struct limine_framebuffer {
-    uint64_t address;
-    uint64_t width;
-    uint64_t height;
-    uint64_t pitch;
-    uint16_t bpp;
-    uint8_t red_mask_size;
-    uint8_t red_mask_shift;
-    uint8_t green_mask_size;
-    uint8_t green_mask_shift;
-    uint8_t blue_mask_size;
-    uint8_t blue_mask_shift;
-};
+/* ====== LIMINE REQUESTS ====== */
 
-struct limine_framebuffer_response {
-    uint64_t revision;
-    uint64_t framebuffer_count;
-    struct limine_framebuffer **framebuffers;
-};
+LIMINE_REQUESTS_START
+static volatile uint64_t limine_requests_start[4] = LIMINE_REQUESTS_START_MARKER;
 
-struct limine_memmap_entry {
-    uint64_t base;
-    uint64_t length;
-    uint32_t type;
-    uint32_t unused;
+LIMINE_REQUESTS_SECTION
+static volatile struct limine_framebuffer_request framebuffer_request = {
+    .id = LIMINE_FRAMEBUFFER_REQUEST,
+    .revision = 0,
 };
 
-struct limine_memmap_response {
-    uint64_t revision;
-    uint64_t entry_count;
-    struct limine_memmap_entry **entries;
+LIMINE_REQUESTS_SECTION
+static volatile struct limine_hhdm_request hhdm_request = {
+    .id = LIMINE_HHDM_REQUEST,
+    .revision = 0,
 };
 
-struct limine_boot_info {
-    uint64_t bootloader_brand;
-    uint64_t bootloader_version;
-    struct limine_framebuffer_response *framebuffer;
-    struct limine_memmap_response *memmap;
+LIMINE_REQUESTS_SECTION
+static volatile struct limine_memmap_request memmap_request = {
+    .id = LIMINE_MEMMAP_REQUEST,
+    .revision = 0,
 };
 
+LIMINE_REQUESTS_END
+static volatile uint64_t limine_requests_end[2] = LIMINE_REQUESTS_END_MARKER;
+
 /* ====== KERNEL STATE ====== */
 
 static struct limine_framebuffer *fb = NULL;
 static uint32_t screen_width = 0;
 static uint32_t screen_height = 0;
 static uint32_t screen_pitch = 0;
-static uint64_t total_memory = 0;
-static uint64_t usable_memory = 0;
 
 /* ====== GRAPHICS FUNCTIONS ====== */
 
@@ -147,23 +134,54 @@ static void draw_system_clock(void) {
 
 /* ====== MEMORY MANAGEMENT ====== */
 
+/* Bootloader-reclaimable memory holds Limine's page tables and our stack: it stays reserved */
 static void process_memmap(struct limine_memmap_response *memmap) {
     if (!memmap) return;
     
     for (uint64_t i = 0; i < memmap->entry_count; i++) {
         struct limine_memmap_entry *entry = memmap->entries[i];
-        total_memory += entry->length;
+        bootinfo.memory_size += entry->length;
+        if (entry->base + entry->length > bootinfo.phys_top) {
+            bootinfo.phys_top = entry->base + entry->length;
+        }
         
-        if (entry->type == 0) {  // LIMINE_MEMMAP_USABLE
-            usable_memory += entry->length;
+        if (entry->type != LIMINE_MEMMAP_USABLE) continue;
+        bootinfo.usable_memory += entry->length;
+        if (bootinfo.num_usable < BOOT_MAX_REGIONS) {
+            bootinfo.usable[bootinfo.num_usable].base = entry->base;
+            bootinfo.usable[bootinfo.num_usable].length = entry->length;
+            bootinfo.num_usable++;
         }
     }
 }
 
+/* ====== BOOT INFORMATION ====== */
+
+/* kernel_init() finds memory in bootinfo; the display driver and window manager, the screen */
+static void read_boot_info(void) {
+    if (hhdm_request.response) {
+        bootinfo.phys_offset = hhdm_request.response->offset;
+    }
+    process_memmap(memmap_request.response);
+
+    struct limine_framebuffer_response *response = framebuffer_request.response;
+    if (!response || response->framebuffer_count == 0) {
+        return;
+    }
+
+    struct limine_framebuffer *boot_fb = response->framebuffers[0];
+    bootinfo.framebuffer = (vaddr_t)(uintptr_t)boot_fb->address;
+    bootinfo.framebuffer_width = (uint32_t)boot_fb->width;
+    bootinfo.framebuffer_height = (uint32_t)boot_fb->height;
+    bootinfo.framebuffer_pitch = (uint32_t)boot_fb->pitch;
+    bootinfo.framebuffer_bpp = boot_fb->bpp;
+}
+
 /* ====== KERNEL ENTRY POINT ====== */
 // Forward declarations
-extern void kernel_init(void *limine_bootloader_info);
+extern void kernel_init(void);
 extern void scheduler_init(void);
+extern int klog_start(void);
 extern void graphics_init(void);
 extern void wm_init(void);
 extern void input_init(void);
@@ -172,27 +190,98 @@ extern void terminal_app_update(void);
 extern void wm_update(void);
 extern void wm_render(void);
 extern void input_process_events(void);
+#ifdef CONFIG_BENCH_BOOT
+extern void bench_boot(void) __attribute__((noreturn));
+#endif
+
+/* ====== UI THREADS ====== */
+/*
+ * Input and the window manager run as SCHED_FIFO kernel threads, so a
+ * CPU-bound process cannot delay a frame or a keypress by more than a
+ * slice; the budgets keep either from starving everything else.
+ */
+#define UI_INPUT_PERIOD_US  4000
+#define UI_INPUT_BUDGET_US  1000
+#define UI_INPUT_PRIORITY   20
+#define UI_FRAME_PERIOD_US  16000
+#define UI_FRAME_BUDGET_US  8000
+#define UI_FRAME_PRIORITY   10
 
-void kernel_main_limine(void *limine_boot_info) {
-    /* Write directly to VGA text buffer */
-    uint16_t *vga_buffer = (uint16_t *)0xB8000;
+static void ui_input_thread(void *arg) {
+    (void)arg;
+    uint64_t period = time_tsc_hz() / 1000000 * UI_INPUT_PERIOD_US;
     
-    /* Clear screen */
-    for (int i = 0; i < 80 * 25; i++) {
-        vga_buffer[i] = 0x0020;
+    for (;;) {
+        input_process_events();
+        scheduler_sleep_until(rdtsc() + period);
     }
+}
+
+/* Apps draw first, then the window manager composites and presents */
+static void ui_frame_thread(void *arg) {
+    (void)arg;
+    uint64_t period = time_tsc_hz() / 1000000 * UI_FRAME_PERIOD_US;
+    uint64_t next = rdtsc();
+    
+    for (;;) {
+        terminal_app_update();
+        wm_update();
+        next += period;
+        scheduler_sleep_until(next);
+    }
+}
+
+static int ui_start_thread(const char *name, kthread_fn_t fn, int32_t priority,
+                           uint64_t budget_us, uint64_t period_us) {
+    kpid_t pid = kthread_create(name, fn, NULL);
+    if (pid == (kpid_t)-1) return -1;
+    
+    if (sched_set_realtime(pid, priority, budget_us * 1000, period_us * 1000) != 0) {
+        KWARN("%s: staying in SCHED_NORMAL", name);
+    }
+    return 0;
+}
+
+/* Limine passes nothing in registers: everything comes from the requests above */
+void kernel_main_limine(void) {
+    read_boot_info();
+    
+#ifdef CONFIG_BENCH_BOOT
+    /* Headless benchmark run: results go to COM1, then QEMU exits */
+    kernel_init();
+    scheduler_init();
+    klog_start();
+    bench_boot();
+#endif
+    
+    kernel_init();
+    scheduler_init();
+    klog_start();
     
-    /* Write boot message */
-    const char *msg = "PuppetOS Booted Successfully!";
-    uint16_t color = 0x0A00;  /* Green on black */
+    if (!bootinfo.framebuffer) {
+        /* kernel_init() put the log on the VGA text screen */
+        for (;;) {
+            __asm__("hlt");
+        }
+    }
     
-    for (int i = 0; msg[i] != '\0'; i++) {
-        vga_buffer[i] = color | msg[i];
+    kernel_console_detach();
+    graphics_init();
+    wm_init();
+    wm_render();
+    input_init();
+    terminal_app_init();
+    
+    if (ui_start_thread("input", ui_input_thread, UI_INPUT_PRIORITY,
+                        UI_INPUT_BUDGET_US, UI_INPUT_PERIOD_US) != 0 ||
+        ui_start_thread("wm", ui_frame_thread, UI_FRAME_PRIORITY,
+                        UI_FRAME_BUDGET_US, UI_FRAME_PERIOD_US) != 0) {
+        KPANIC("Could not start the UI threads");
     }
     
-    /* Halt forever */
+    /* The boot context is the idle loop: run threads until none is due, then wait for a tick */
     for (;;) {
+        scheduler_switch();
         __asm__("hlt");
     }
 }
-
@@ -1,34 +1,234 @@
 #include <memory.h>
+#include <kernel/gdt.h>
+#include <kernel/idt.h>
+#include <kernel/cpu.h>
 
 /* GDT - Global Descriptor Table */
+#define GDT_ENTRIES 7   /* null, 4 code/data, TSS (2 slots) */
+
+/* Access byte | flags: present, DPL, code/data, long mode */
+#define GDT_SEG_KERNEL_CODE 0x00209A0000000000ULL
+#define GDT_SEG_KERNEL_DATA 0x0000920000000000ULL
+#define GDT_SEG_USER_DATA   0x0000F20000000000ULL
+#define GDT_SEG_USER_CODE   0x0020FA0000000000ULL
+#define GDT_SEG_TSS_TYPE    0x89ULL                 /* Present, 64-bit available TSS */
+
+static uint64_t gdt[GDT_ENTRIES] __attribute__((aligned(16)));
+static tss_t tss __attribute__((aligned(16)));
+
+static void gdt_set_tss(void) {
+    uint64_t base = (uint64_t)(uintptr_t)&tss;
+    uint64_t limit = sizeof(tss) - 1;
+
+    gdt[GDT_TSS / 8] = (limit & 0xFFFF) |
+                       ((base & 0xFFFFFF) << 16) |
+                       (GDT_SEG_TSS_TYPE << 40) |
+                       (((limit >> 16) & 0xF) << 48) |
+                       (((base >> 24) & 0xFF) << 56);
+    gdt[GDT_TSS / 8 + 1] = base >> 32;
+}
+
 void gdt_init(void) {
-    /* TODO: Implement full GDT setup */
-    /* For now, the bootloader has already set up a basic 64-bit GDT */
+    gdt[0] = 0;
+    gdt[GDT_KERNEL_CODE / 8] = GDT_SEG_KERNEL_CODE;
+    gdt[GDT_KERNEL_DATA / 8] = GDT_SEG_KERNEL_DATA;
+    gdt[GDT_USER_DATA / 8] = GDT_SEG_USER_DATA;
+    gdt[GDT_USER_CODE / 8] = GDT_SEG_USER_CODE;
+
+    tss.iomap_base = sizeof(tss);   /* No I/O permission bitmap */
+    gdt_set_tss();
+
+    struct __attribute__((packed)) {
+        uint16_t limit;
+        uint64_t base;
+    } gdtr = { sizeof(gdt) - 1, (uint64_t)(uintptr_t)gdt };
+
+    /* Replace the bootloader's GDT; CS can only be reloaded with a far return */
+    __asm__ volatile(
+        "lgdt %0\n\t"
+        "pushq %1\n\t"
+        "leaq 1f(%%rip), %%rax\n\t"
+        "pushq %%rax\n\t"
+        "lretq\n"
+        "1:\n\t"
+        "movw %w2, %%ax\n\t"
+        "movw %%ax, %%ds\n\t"
+        "movw %%ax, %%es\n\t"
+        "movw %%ax, %%ss\n\t"
+        "xorl %%eax, %%eax\n\t"
+        "movw %%ax, %%fs\n\t"
+        "movw %w3, %%ax\n\t"
+        "ltr %%ax"
+        :: "m"(gdtr), "i"(GDT_KERNEL_CODE), "i"(GDT_KERNEL_DATA), "i"(GDT_TSS)
+        : "rax", "memory");
+    /* GS is left alone: its base is the per-CPU pointer (see percpu_init) */
+}
+
+void gdt_set_kernel_stack(uint64_t rsp0) {
+    tss.rsp[0] = rsp0;
 }
 
 /* IDT - Interrupt Descriptor Table */
+#define IDT_STR_(x)         #x
+#define IDT_STR(x)          IDT_STR_(x)
+
+#define IDT_GATE_INTERRUPT  0x8E    /* Present, DPL 0, 64-bit interrupt gate (clears IF) */
+#define IDT_STUB_SIZE       16
+
+typedef struct __attribute__((packed)) {
+    uint16_t offset_low;
+    uint16_t selector;
+    uint8_t ist;
+    uint8_t type_attr;
+    uint16_t offset_mid;
+    uint32_t offset_high;
+    uint32_t reserved;
+} idt_gate_t;
+
+static idt_gate_t idt[IDT_VECTORS] __attribute__((aligned(16)));
+static interrupt_handler_t idt_handlers[IDT_VECTORS];
+
+/* Single CPU for now: plain increments, no per-CPU split */
+static idt_vector_stats_t idt_stats[IDT_VECTORS];
+
+static uint8_t ist_stacks[3][IST_STACK_SIZE] __attribute__((aligned(16)));
+
+extern const uint8_t idt_stubs[];
+void idt_dispatch(interrupt_frame_t *frame);
+
+/*
+ * Entry stubs, IDT_STUB_SIZE bytes apart so the gate for vector v is
+ * idt_stubs + v * IDT_STUB_SIZE. The CPU pushes an error code only for
+ * vectors 8, 10-14, 17, 21, 29 and 30; the others push a zero so every
+ * frame has the same layout.
+ *
+ * The common path saves the nine caller-saved registers and nothing
+ * else: idt_dispatch() preserves the rest by the C ABI. The CPU has
+ * aligned rsp to 16 before pushing its five words, so the stub's two
+ * plus nine pushes leave it aligned for the call. swapgs happens only
+ * for frames from ring 3, and the return to ring 3 does it with IF
+ * clear so nothing runs on the user GS in between. rbp is not touched:
+ * an unwinder that reaches the frame returning to idt_return finds the
+ * interrupted rbp saved in it.
+ */
+__asm__(
+    ".text\n"
+    ".globl idt_stubs, idt_return\n"
+    ".balign " IDT_STR(IDT_STUB_SIZE) "\n"
+    "idt_stubs:\n"
+    ".set idt_vec, 0\n"
+    ".rept " IDT_STR(IDT_VECTORS) "\n"
+    "    .balign " IDT_STR(IDT_STUB_SIZE) "\n"
+    "    .if !(idt_vec == 8 || (idt_vec >= 10 && idt_vec <= 14) || idt_vec == 17 || "
+    "idt_vec == 21 || idt_vec == 29 || idt_vec == 30)\n"
+    "    pushq $0\n"
+    "    .endif\n"
+    "    pushq $idt_vec\n"
+    "    jmp idt_common\n"
+    "    .set idt_vec, idt_vec + 1\n"
+    ".endr\n"
+    "\n"
+    "idt_common:\n"
+    "    testb $3, 24(%rsp)\n"              /* CS of the interrupted context */
+    "    jz 1f\n"
+    "    swapgs\n"
+    "1:  pushq %rax\n"
+    "    pushq %rcx\n"
+    "    pushq %rdx\n"
+    "    pushq %rsi\n"
+    "    pushq %rdi\n"
+    "    pushq %r8\n"
+    "    pushq %r9\n"
+    "    pushq %r10\n"
+    "    pushq %r11\n"
+    "    cld\n"
+    "    movq %rsp, %rdi\n"
+    "    call idt_dispatch\n"
+    "idt_return:\n"
+    "    popq %r11\n"
+    "    popq %r10\n"
+    "    popq %r9\n"
+    "    popq %r8\n"
+    "    popq %rdi\n"
+    "    popq %rsi\n"
+    "    popq %rdx\n"
+    "    popq %rcx\n"
+    "    popq %rax\n"
+    "    testb $3, 24(%rsp)\n"
+    "    jz 2f\n"
+    "    cli\n"
+    "    swapgs\n"
+    "2:  addq $16, %rsp\n"                  /* Vector and error code */
+    "    iretq\n"
+);
+
+/* Without a registered handler an exception cannot be resumed */
+static void idt_unhandled_exception(void) {
+    for (;;) {
+        __asm__ volatile("cli; hlt");
+    }
+}
+
+void idt_dispatch(interrupt_frame_t *frame) {
+    uint64_t start = rdtsc();
+    uint32_t vector = (uint8_t)frame->vector;
+    interrupt_handler_t handler = idt_handlers[vector];
+
+    /* Counted up front: a handler may not return (user fault unwinding) */
+    idt_stats[vector].count++;
+    if (handler) {
+        handler(frame);
+    } else if (vector < IDT_EXCEPTIONS) {
+        idt_unhandled_exception();
+    }
+    idt_stats[vector].cycles += rdtsc() - start;
+}
+
+static void idt_set_gate(uint32_t vector, uint64_t handler, uint8_t ist) {
+    idt[vector].offset_low = handler & 0xFFFF;
+    idt[vector].selector = GDT_KERNEL_CODE;
+    idt[vector].ist = ist;
+    idt[vector].type_attr = IDT_GATE_INTERRUPT;
+    idt[vector].offset_mid = (handler >> 16) & 0xFFFF;
+    idt[vector].offset_high = handler >> 32;
+    idt[vector].reserved = 0;
+}
+
 void idt_init(void) {
-    /* TODO: Implement IDT setup with exception handlers */
-    /* This will include:
-     * - Divide by zero handler
-     * - General protection fault handler
-     * - Page fault handler
-     * - Timer interrupt handler
-     * - etc.
-     */
-}
-
-/* Paging - Virtual Memory */
-void paging_init(void) {
-    /* TODO: Implement paging initialization */
-    /* This will include:
-     * - Page table structure setup
-     * - Identity mapping for kernel
-     * - Recursive page table entry
-     * - Enable paging via CR3 and CR0
-     */
-}
-
-void paging_enable(void) {
-    /* TODO: Enable paging */
+    uint64_t stubs = (uint64_t)(uintptr_t)idt_stubs;
+    for (uint32_t v = 0; v < IDT_VECTORS; v++) {
+        idt_set_gate(v, stubs + (uint64_t)v * IDT_STUB_SIZE, 0);
+    }
+
+    /* These can arrive on a bad or half-switched stack: give them known-good ones */
+    tss.ist[IST_NMI - 1] = (uint64_t)(uintptr_t)&ist_stacks[0][IST_STACK_SIZE];
+    tss.ist[IST_DOUBLE_FAULT - 1] = (uint64_t)(uintptr_t)&ist_stacks[1][IST_STACK_SIZE];
+    tss.ist[IST_MACHINE_CHECK - 1] = (uint64_t)(uintptr_t)&ist_stacks[2][IST_STACK_SIZE];
+    idt[VEC_NMI].ist = IST_NMI;
+    idt[VEC_DOUBLE_FAULT].ist = IST_DOUBLE_FAULT;
+    idt[VEC_MACHINE_CHECK].ist = IST_MACHINE_CHECK;
+
+    struct __attribute__((packed)) {
+        uint16_t limit;
+        uint64_t base;
+    } idtr = { sizeof(idt) - 1, (uint64_t)(uintptr_t)idt };
+
+    __asm__ volatile("lidt %0" :: "m"(idtr) : "memory");
+}
+
+int idt_register_handler(uint32_t vector, interrupt_handler_t handler) {
+    if (vector >= IDT_VECTORS) return -1;
+    idt_handlers[vector] = handler;
+    return 0;
+}
+
+const idt_vector_stats_t *idt_get_stats(uint32_t vector) {
+    return vector < IDT_VECTORS ? &idt_stats[vector] : NULL;
+}
+
+void idt_reset_stats(void) {
+    for (uint32_t v = 0; v < IDT_VECTORS; v++) {
+        idt_stats[v].count = 0;
+        idt_stats[v].cycles = 0;
+    }
 }
@@ -0,0 +1,325 @@
+/*
+ * Kernel Page Tables
+ * Direct map of physical memory and the higher-half kernel image
+ *
+ * paging_init() builds the kernel's own PML4 while still running on the
+ * bootloader's tables: all physical memory below phys_top at
+ * phys_offset, the same place Limine's HHDM shows it (1 GiB pages where
+ * the CPU has them, else 2 MiB), and the kernel image at its link
+ * address with 4 KiB pages, text read-only and executable, everything
+ * else NX. Every kernel mapping is global, so CR3 switches between
+ * address spaces never evict them. paging_enable() loads the tables and
+ * turns on CR4.PGE and, when supported, CR4.PCIDE (see
+ * vmm_switch_address_space()).
+ *
+ * paging_set_cache() changes the memory type of a kernel range in the
+ * tables currently loaded, reading them through the direct map, and
+ * splits large pages at its edges. The PAT keeps its power-on layout
+ * except entry 1, which becomes WC instead of WT, so every type is
+ * reachable with PWT/PCD alone in any page size:
+ * WB = none, WC = PWT, UC = PWT|PCD.
+ */
+
+#include <memory.h>
+#include <kernel/vmm.h>
+#include <kernel/cpu.h>
+
+#define CPUID_EXT_EDX_NX        (1U << 20)
+
+#define PML4_INDEX(va)          (((va) >> 39) & 0x1FF)
+#define PDPT_INDEX(va)          (((va) >> 30) & 0x1FF)
+#define PD_INDEX(va)            (((va) >> 21) & 0x1FF)
+#define PT_INDEX(va)            (((va) >> 12) & 0x1FF)
+
+/* PA0-PA7 = WB, WC, UC-, UC, WB, WT, UC-, UC */
+#define PAT_LAYOUT              0x0007040600070106ULL
+#define PAGING_CACHE_MASK       (PTE_PWT | PTE_PCD)
+#define PAGING_SPLIT_TABLES     8
+
+extern const uint8_t __kernel_start[], __text_end[], __kernel_end[];
+
+/* ===== STATE ===== */
+static pmm_t *paging_pmm = NULL;
+static uint64_t paging_phys_offset = 0;     /* Direct map base, in both the bootloader's tables and ours */
+static paddr_t paging_pml4 = 0;
+static bool paging_pcid_capable = false;
+static bool paging_pcid = false;            /* CR4.PCIDE set by paging_enable() */
+static uint64_t paging_nx = 0;
+static bool paging_pat = false;
+
+/* Tables for splitting large pages, which may happen before any allocator */
+static uint64_t paging_split_pool[PAGING_SPLIT_TABLES][PT_ENTRIES] __attribute__((aligned(PAGE_SIZE)));
+static uint32_t paging_split_used = 0;
+
+static inline void *paging_virt(paddr_t addr) {
+    return (void *)(uintptr_t)(addr + paging_phys_offset);
+}
+
+/* ===== TABLE HELPERS ===== */
+static paddr_t paging_alloc_table(void) {
+    uint32_t frame = pmm_alloc_frame(paging_pmm);
+    if (frame == (uint32_t)-1) return 0;
+
+    paddr_t table = (paddr_t)frame * PAGE_SIZE;
+    uint64_t *entries = (uint64_t *)paging_virt(table);
+    for (int i = 0; i < PT_ENTRIES; i++) {
+        entries[i] = 0;
+    }
+    return table;
+}
+
+/* Table below an entry, allocated on first use; NULL when out of frames */
+static uint64_t *paging_next(uint64_t *entry) {
+    if (!(*entry & PTE_PRESENT)) {
+        paddr_t table = paging_alloc_table();
+        if (!table) return NULL;
+        *entry = table | PTE_PRESENT | PTE_WRITABLE;
+    }
+    return (uint64_t *)paging_virt(*entry & PTE_ADDR_MASK);
+}
+
+/*
+ * Physical address behind virt in the tables currently loaded, reading
+ * them where physical memory shows at phys_offset; 0 if unmapped
+ */
+static paddr_t paging_translate(vaddr_t virt, uint64_t phys_offset) {
+    uint64_t *table = (uint64_t *)(uintptr_t)((read_cr3() & PTE_ADDR_MASK) + phys_offset);
+
+    for (int level = 3; level >= 0; level--) {
+        uint64_t entry = table[(virt >> (12 + 9 * level)) & 0x1FF];
+        if (!(entry & PTE_PRESENT)) return 0;
+
+        if (level == 0 || (entry & PTE_HUGE)) {
+            uint64_t offset_mask = (1ULL << (12 + 9 * level)) - 1;
+            return (entry & PTE_ADDR_MASK & ~offset_mask) + (virt & offset_mask);
+        }
+        table = (uint64_t *)(uintptr_t)((entry & PTE_ADDR_MASK) + phys_offset);
+    }
+    return 0;
+}
+
+static paddr_t paging_boot_translate(vaddr_t virt) {
+    return paging_translate(virt, paging_phys_offset);
+}
+
+/* ===== MAPPINGS ===== */
+static int paging_map_direct(uint64_t phys_top, bool huge_1g) {
+    uint64_t *pml4 = (uint64_t *)paging_virt(paging_pml4);
+    uint64_t flags = PTE_PRESENT | PTE_WRITABLE | PTE_GLOBAL | PTE_HUGE | paging_nx;
+    uint64_t step = huge_1g ? PAGE_SIZE_1G : PAGE_SIZE_2M;
+
+    for (paddr_t addr = 0; addr < phys_top; addr += step) {
+        vaddr_t virt = paging_phys_offset + addr;
+
+        uint64_t *pdpt = paging_next(&pml4[PML4_INDEX(virt)]);
+        if (!pdpt) return -1;
+        if (huge_1g) {
+            pdpt[PDPT_INDEX(virt)] = addr | flags;
+            continue;
+        }
+
+        uint64_t *pd = paging_next(&pdpt[PDPT_INDEX(virt)]);
+        if (!pd) return -1;
+        pd[PD_INDEX(virt)] = addr | flags;
+    }
+    return 0;
+}
+
+/* Page by page, wherever the loader put each one */
+static int paging_map_image(void) {
+    uint64_t *pml4 = (uint64_t *)paging_virt(paging_pml4);
+    vaddr_t start = ALIGN_DOWN((vaddr_t)(uintptr_t)__kernel_start, PAGE_SIZE);
+    vaddr_t end = ALIGN_UP((vaddr_t)(uintptr_t)__kernel_end, PAGE_SIZE);
+    vaddr_t text_end = (vaddr_t)(uintptr_t)__text_end;
+
+    for (vaddr_t virt = start; virt < end; virt += PAGE_SIZE) {
+        paddr_t phys = paging_boot_translate(virt);
+        if (!phys) return -1;
+
+        uint64_t *pdpt = paging_next(&pml4[PML4_INDEX(virt)]);
+        uint64_t *pd = pdpt ? paging_next(&pdpt[PDPT_INDEX(virt)]) : NULL;
+        uint64_t *pt = pd ? paging_next(&pd[PD_INDEX(virt)]) : NULL;
+        if (!pt) return -1;
+
+        uint64_t flags = PTE_PRESENT | PTE_GLOBAL;
+        if (virt >= text_end) {
+            flags |= PTE_WRITABLE | paging_nx;
+        }
+        pt[PT_INDEX(virt)] = phys | flags;
+    }
+    return 0;
+}
+
+/* ===== INITIALIZATION ===== */
+int paging_init(pmm_t *pmm, uint64_t phys_top, uint64_t phys_offset) {
+    uint32_t eax, ebx, ecx, edx;
+    uint32_t ext_edx = 0;
+
+    paging_pmm = pmm;
+    paging_phys_offset = phys_offset;
+
+    cpuid(0x80000000, &eax, &ebx, &ecx, &edx);
+    if (eax >= 0x80000001) {
+        cpuid(0x80000001, &eax, &ebx, &ecx, &ext_edx);
+    }
+    cpuid(1, &eax, &ebx, &ecx, &edx);
+    paging_pcid_capable = (ecx & CPUID_1_ECX_PCID) != 0;
+
+    if (ext_edx & CPUID_EXT_EDX_NX) {
+        wrmsr(MSR_EFER, rdmsr(MSR_EFER) | EFER_NXE);
+        paging_nx = PTE_NX;
+    }
+
+    /* Low MMIO (VGA, framebuffer, APICs) sits below 4 GiB: always cover it */
+    if (phys_top < 4 * PAGE_SIZE_1G) {
+        phys_top = 4 * PAGE_SIZE_1G;
+    }
+
+    paging_pml4 = paging_alloc_table();
+    if (!paging_pml4 ||
+        paging_map_direct(phys_top, (ext_edx & CPUID_EXT_EDX_PAGE1GB) != 0) != 0 ||
+        paging_map_image() != 0) {
+        paging_pml4 = 0;
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * The caller's stack and everything it still needs must live in the
+ * image or the direct map; the bootloader's low identity mapping and
+ * anything else it mapped are gone afterwards. Pointers into the HHDM
+ * stay valid: the direct map is at the same offset.
+ */
+void paging_enable(void) {
+    if (!paging_pml4) return;
+
+    /* Toggling PGE drops any global entries the bootloader left behind */
+    uint64_t cr4 = read_cr4();
+    write_cr3(paging_pml4);
+    write_cr4(cr4 & ~CR4_PGE);
+    write_cr4(cr4 | CR4_PGE);
+    paging_init_pat();
+    if (paging_pcid_capable) {
+        write_cr4(read_cr4() | CR4_PCIDE);   /* Needs CR3[11:0] == 0, true for PCID 0 */
+        paging_pcid = true;
+    }
+}
+
+bool paging_pcid_supported(void) {
+    return paging_pcid;
+}
+
+/* ===== MEMORY TYPES ===== */
+/* Also drops global entries; with CR4.PCIDE, every PCID's */
+static void paging_flush_global(void) {
+    uint64_t cr4 = read_cr4();
+    if (cr4 & CR4_PGE) {
+        write_cr4(cr4 & ~CR4_PGE);
+        write_cr4(cr4);
+    } else {
+        write_cr3(read_cr3());
+    }
+}
+
+int paging_init_pat(void) {
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(1, &eax, &ebx, &ecx, &edx);
+    if (!(edx & CPUID_1_EDX_PAT)) return -1;
+
+    /* Nothing maps with PWT alone yet, so no line changes type under us */
+    wbinvd();
+    wrmsr(MSR_PAT, PAT_LAYOUT);
+    wbinvd();
+    paging_flush_global();
+
+    paging_pat = true;
+    return 0;
+}
+
+/*
+ * Replace the large page at entry (level 2: 1 GiB, level 1: 2 MiB) by a
+ * table of the next size down with the same attributes
+ */
+static uint64_t *paging_split(uint64_t *entry, int level) {
+    if (paging_split_used == PAGING_SPLIT_TABLES) return NULL;
+
+    uint64_t *table = paging_split_pool[paging_split_used];
+    paddr_t table_phys = paging_translate((vaddr_t)(uintptr_t)table, paging_phys_offset);
+    if (!table_phys) return NULL;
+    paging_split_used++;
+
+    uint64_t size = 1ULL << (12 + 9 * level);
+    uint64_t step = size >> 9;
+    paddr_t base = *entry & PTE_ADDR_MASK & ~(size - 1);
+    uint64_t flags = *entry & ~PTE_ADDR_MASK;
+    uint64_t pat = *entry & PTE_PAT_HUGE;
+
+    if (level == 1) {
+        flags = (flags & ~PTE_HUGE) | (pat ? PTE_PAT : 0);
+    } else {
+        flags |= pat;
+    }
+    for (int i = 0; i < PT_ENTRIES; i++) {
+        table[i] = (base + (uint64_t)i * step) | flags;
+    }
+
+    *entry = table_phys | PTE_PRESENT | PTE_WRITABLE | (*entry & PTE_USER);
+    return table;
+}
+
+int paging_set_cache(uint64_t virt, uint64_t size, paging_cache_t type) {
+    /* Before paging_init() there is no telling where the tables are mapped */
+    if (!paging_pat || !paging_pmm || !size) return -1;
+
+    static const uint64_t cache_bits[] = {
+        [PAGING_CACHE_WB] = 0,
+        [PAGING_CACHE_WC] = PTE_PWT,
+        [PAGING_CACHE_UC] = PTE_PWT | PTE_PCD,
+    };
+    vaddr_t va = ALIGN_DOWN(virt, PAGE_SIZE);
+    vaddr_t end = ALIGN_UP(virt + size, PAGE_SIZE);
+    int result = 0;
+
+    while (va < end) {
+        uint64_t *table = (uint64_t *)paging_virt(read_cr3() & PTE_ADDR_MASK);
+        int level = 3;
+
+        for (;;) {
+            uint64_t *entry = &table[(va >> (12 + 9 * level)) & 0x1FF];
+            if (!(*entry & PTE_PRESENT)) {
+                result = -1;
+                goto out;
+            }
+
+            if (level > 0 && !(*entry & PTE_HUGE)) {
+                table = (uint64_t *)paging_virt(*entry & PTE_ADDR_MASK);
+                level--;
+                continue;
+            }
+
+            uint64_t page = 1ULL << (12 + 9 * level);
+            if (level > 0 && ((va & (page - 1)) || end - va < page)) {
+                /* Only part of this large page is in range */
+                table = paging_split(entry, level);
+                if (!table) {
+                    result = -1;
+                    goto out;
+                }
+                level--;
+                continue;
+            }
+
+            uint64_t pat_bit = level > 0 ? PTE_PAT_HUGE : PTE_PAT;
+            *entry = (*entry & ~(PAGING_CACHE_MASK | pat_bit)) | cache_bits[type];
+            va += page;
+            break;
+        }
+    }
+
+out:
+    /* No stale lines or TLB entries may keep the old type */
+    wbinvd();
+    paging_flush_global();
+    return result;
+}
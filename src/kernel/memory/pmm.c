@@ -41,6 +41,18 @@ void pmm_init(pmm_t *pmm, uint32_t total_frames) {
     }
 }
 
+/* For a memory map with holes: the caller frees each usable region */
+void pmm_init_used(pmm_t *pmm, uint8_t *bitmap, uint32_t total_frames) {
+    pmm->bitmap = bitmap;
+    pmm->num_frames = total_frames;
+    pmm->used_frames = total_frames;
+    
+    uint32_t bitmap_size = (total_frames + 7) / 8;
+    for (uint32_t i = 0; i < bitmap_size; i++) {
+        pmm->bitmap[i] = 0xFF;
+    }
+}
+
 uint32_t pmm_alloc_frame(pmm_t *pmm) {
     uint32_t frame = pmm_find_free_block(pmm->bitmap, pmm->num_frames);
     
@@ -54,6 +66,29 @@ uint32_t pmm_alloc_frame(pmm_t *pmm) {
     return frame;
 }
 
+uint32_t pmm_alloc_frames(pmm_t *pmm, uint32_t count) {
+    uint32_t run = 0;
+    
+    /* First fit for a physically contiguous run */
+    for (uint32_t i = 0; i < pmm->num_frames; i++) {
+        if (pmm_test_bit(pmm->bitmap, i)) {
+            run = 0;
+            continue;
+        }
+        
+        if (++run == count) {
+            uint32_t first = i + 1 - count;
+            for (uint32_t j = first; j <= i; j++) {
+                pmm_set_bit(pmm->bitmap, j);
+            }
+            pmm->used_frames += count;
+            return first;
+        }
+    }
+    
+    return (uint32_t)-1;  /* No run long enough */
+}
+
 void pmm_free_frame(pmm_t *pmm, uint32_t frame) {
     if (frame >= pmm->num_frames) {
         return;
@@ -91,6 +126,20 @@ void pmm_mark_frame_free(pmm_t *pmm, uint32_t frame) {
     }
 }
 
+void pmm_mark_region_used(pmm_t *pmm, uint64_t base, uint64_t length) {
+    uint64_t end = ALIGN_UP(base + length, PAGE_SIZE) / PAGE_SIZE;
+    for (uint64_t frame = base / PAGE_SIZE; frame < end && frame < pmm->num_frames; frame++) {
+        pmm_mark_frame_used(pmm, (uint32_t)frame);
+    }
+}
+
+void pmm_mark_region_free(pmm_t *pmm, uint64_t base, uint64_t length) {
+    uint64_t end = (base + length) / PAGE_SIZE;
+    for (uint64_t frame = ALIGN_UP(base, PAGE_SIZE) / PAGE_SIZE; frame < end && frame < pmm->num_frames; frame++) {
+        pmm_mark_frame_free(pmm, (uint32_t)frame);
+    }
+}
+
 uint32_t pmm_get_free_frames(pmm_t *pmm) {
     return pmm->num_frames - pmm->used_frames;
 }
@@ -0,0 +1,140 @@
+/*
+ * TLB Shootdown Implementation
+ * Lazy remote invalidation: IPIs only to CPUs running the space
+ */
+
+#include <kernel/tlb.h>
+#include <kernel/vmm.h>
+#include <kernel/percpu.h>
+#include <kernel/apic.h>
+#include <kernel/idt.h>
+#include <kernel/cpu.h>
+
+/* ===== STATE ===== */
+/* One remote shootdown at a time; the initiator spins until every target acked */
+static spinlock_t tlb_lock;
+static const tlb_batch_t *tlb_request = NULL;
+static volatile uint64_t tlb_pending = 0;       /* CPUs that have not acked yet */
+
+/* ===== LOCAL FLUSH ===== */
+/* Apply a batch on this CPU, or defer it if the space isn't loaded here */
+static void tlb_flush_local(const tlb_batch_t *batch) {
+    address_space_t *as = batch->as;
+    uint64_t bit = 1ULL << this_cpu_read(cpu_id);
+
+    if (this_cpu_read(active_as) != as) {
+        __atomic_or_fetch(&as->tlb_stale_mask, bit, __ATOMIC_SEQ_CST);
+        return;
+    }
+
+    if (batch->full) {
+        write_cr3(read_cr3());      /* No CR3_NOFLUSH: drops the current PCID's entries */
+        this_cpu_inc(stats.tlb_full_flushes);
+        return;
+    }
+    for (uint32_t i = 0; i < batch->count; i++) {
+        invlpg(batch->pages[i]);
+    }
+    __asm__ volatile("addq %0, %%gs:%c1"
+                     :: "r"((uint64_t)batch->count),
+                        "i"(offsetof(cpu_local_t, stats.tlb_pages))
+                     : "memory");
+}
+
+static void tlb_shootdown_interrupt(interrupt_frame_t *frame) {
+    (void)frame;
+    tlb_flush_local(tlb_request);
+    __atomic_and_fetch(&tlb_pending, ~(1ULL << this_cpu_read(cpu_id)), __ATOMIC_RELEASE);
+    lapic_eoi();
+}
+
+/* ===== BATCHES ===== */
+void tlb_batch_init(tlb_batch_t *batch, address_space_t *as) {
+    batch->as = as;
+    batch->count = 0;
+    batch->full = false;
+}
+
+void tlb_batch_add(tlb_batch_t *batch, vaddr_t addr) {
+    if (batch->full) return;
+    if (batch->count == TLB_BATCH_MAX) {
+        batch->full = true;
+        return;
+    }
+    batch->pages[batch->count++] = ALIGN_DOWN(addr, PAGE_SIZE);
+}
+
+void tlb_batch_add_all(tlb_batch_t *batch) {
+    batch->full = true;
+}
+
+/*
+ * Every other CPU that has run the space is first marked stale, then
+ * interrupted only if it has the space loaded right now. The order
+ * matters against vmm_switch_address_space(), which publishes
+ * active_as before it clears its stale bit: either that CPU sees the
+ * bit and flushes on load, or this one sees it active and sends an IPI.
+ */
+void tlb_batch_flush(tlb_batch_t *batch) {
+    if (!batch->count && !batch->full) return;
+
+    address_space_t *as = batch->as;
+    uint32_t self = this_cpu_read(cpu_id);
+    uint64_t others = __atomic_load_n(&as->cpu_mask, __ATOMIC_SEQ_CST) & ~(1ULL << self);
+
+    uint64_t targets = 0;
+    if (others) {
+        __atomic_or_fetch(&as->tlb_stale_mask, others, __ATOMIC_SEQ_CST);
+        for (uint32_t cpu = 0; cpu < MAX_CPUS; cpu++) {
+            if (!(others & (1ULL << cpu))) continue;
+            cpu_local_t *remote = percpu_get(cpu);
+            if (remote && __atomic_load_n(&remote->active_as, __ATOMIC_SEQ_CST) == as) {
+                targets |= 1ULL << cpu;
+            }
+        }
+        /* The idle ones drop out until they load the space again */
+        __atomic_and_fetch(&as->cpu_mask, ~(others & ~targets), __ATOMIC_SEQ_CST);
+    }
+
+    tlb_flush_local(batch);
+
+    if (targets && lapic_ready()) {
+        spinlock_acquire(&tlb_lock);
+        tlb_request = batch;
+        __atomic_store_n(&tlb_pending, targets, __ATOMIC_RELEASE);
+        for (uint32_t cpu = 0; cpu < MAX_CPUS; cpu++) {
+            if (!(targets & (1ULL << cpu))) continue;
+            lapic_send_ipi(percpu_get(cpu)->apic_id, VEC_TLB_SHOOTDOWN);
+            this_cpu_inc(stats.tlb_ipis);
+        }
+        while (__atomic_load_n(&tlb_pending, __ATOMIC_ACQUIRE)) {
+            cpu_relax();
+        }
+        tlb_request = NULL;
+        spinlock_release(&tlb_lock);
+    }
+
+    batch->count = 0;
+    batch->full = false;
+}
+
+/* ===== ONE-SHOT HELPERS ===== */
+void tlb_flush_page(address_space_t *as, vaddr_t addr) {
+    tlb_batch_t batch;
+    tlb_batch_init(&batch, as);
+    tlb_batch_add(&batch, addr);
+    tlb_batch_flush(&batch);
+}
+
+void tlb_flush_all(address_space_t *as) {
+    tlb_batch_t batch;
+    tlb_batch_init(&batch, as);
+    tlb_batch_add_all(&batch);
+    tlb_batch_flush(&batch);
+}
+
+/* ===== INITIALIZATION ===== */
+void tlb_init(void) {
+    spinlock_init(&tlb_lock);
+    idt_register_handler(VEC_TLB_SHOOTDOWN, tlb_shootdown_interrupt);
+}
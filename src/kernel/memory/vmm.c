@@ -0,0 +1,650 @@
+/*
+ * Virtual Memory Manager Implementation
+ * Page table management and demand paging for memory areas
+ */
+
+#include <kernel/vmm.h>
+#include <kernel/kernel.h>
+#include <kernel/cpu.h>
+#include <kernel/percpu.h>
+#include <kernel/tlb.h>
+#include <string.h>
+
+/* ===== STATE ===== */
+uint64_t vmm_phys_offset = 0;
+
+static pmm_t *vmm_pmm = NULL;
+static paddr_t kernel_pml4 = 0;     /* Template for the kernel half */
+static paddr_t zero_frame = 0;      /* Shared, never written, never counted */
+static uint64_t vmm_nx_bit = 0;     /* PTE_NX if EFER.NXE is on */
+static bool vmm_pcid = false;       /* Tag each space's TLB entries (CR4.PCIDE is on) */
+
+/*
+ * Reference counts for every frame the VMM hands out, both data pages
+ * and page tables. fork() shares whole page-table subtrees, so a count
+ * above one on a table means every entry below it is shared too.
+ */
+static uint16_t *frame_refs = NULL;
+
+#define VMM_MAX_SPACES 64
+static address_space_t address_spaces[VMM_MAX_SPACES];
+static spinlock_t address_spaces_lock;
+
+/* ===== FRAME HELPERS ===== */
+static inline uint64_t *table_of(uint64_t entry) {
+    return (uint64_t *)phys_to_virt(entry & PTE_ADDR_MASK);
+}
+
+static inline void frame_clear(paddr_t frame) {
+    memset(phys_to_virt(frame), 0, PAGE_SIZE);
+}
+
+static inline uint16_t *frame_ref(paddr_t frame) {
+    return &frame_refs[frame / PAGE_SIZE];
+}
+
+paddr_t vmm_alloc_frame(void) {
+    uint32_t frame = pmm_alloc_frame(vmm_pmm);
+    if (frame == (uint32_t)-1) return 0;
+    frame_refs[frame] = 1;
+    return (paddr_t)frame * PAGE_SIZE;
+}
+
+paddr_t vmm_alloc_frames(uint32_t count) {
+    uint32_t first = pmm_alloc_frames(vmm_pmm, count);
+    if (first == (uint32_t)-1) return 0;
+    for (uint32_t i = 0; i < count; i++) {
+        frame_refs[first + i] = 1;
+    }
+    return (paddr_t)first * PAGE_SIZE;
+}
+
+void vmm_free_frame(paddr_t frame) {
+    if (frame == zero_frame) return;
+    if (__atomic_sub_fetch(frame_ref(frame), 1, __ATOMIC_ACQ_REL) == 0) {
+        pmm_free_frame(vmm_pmm, (uint32_t)(frame / PAGE_SIZE));
+    }
+}
+
+void vmm_get_frame(paddr_t frame) {
+    if (frame == zero_frame) return;
+    __atomic_add_fetch(frame_ref(frame), 1, __ATOMIC_RELAXED);
+}
+
+static inline bool frame_is_shared(paddr_t frame) {
+    return frame == zero_frame || __atomic_load_n(frame_ref(frame), __ATOMIC_ACQUIRE) > 1;
+}
+
+paddr_t vmm_zero_frame(void) {
+    return zero_frame;
+}
+
+bool vmm_ready(void) {
+    return vmm_pmm != NULL;
+}
+
+static inline bool vmm_is_loaded(const address_space_t *as) {
+    return (read_cr3() & PTE_ADDR_MASK) == as->pml4;
+}
+
+/* ===== INITIALIZATION ===== */
+void vmm_init(pmm_t *pmm, uint64_t phys_offset) {
+    vmm_pmm = pmm;
+    vmm_phys_offset = phys_offset;
+    kernel_pml4 = read_cr3() & PTE_ADDR_MASK;
+    spinlock_init(&address_spaces_lock);
+
+    if (rdmsr(MSR_EFER) & EFER_NXE) {
+        vmm_nx_bit = PTE_NX;
+    }
+    vmm_pcid = paging_pcid_supported();
+
+    uint32_t ref_bytes = pmm->num_frames * sizeof(uint16_t);
+    uint32_t ref_frames = (ref_bytes + PAGE_SIZE - 1) / PAGE_SIZE;
+    uint32_t first = pmm_alloc_frames(pmm, ref_frames);
+    if (first == (uint32_t)-1) {
+        KPANIC("VMM: cannot allocate frame reference counts");
+    }
+    frame_refs = (uint16_t *)phys_to_virt((paddr_t)first * PAGE_SIZE);
+    memset(frame_refs, 0, ref_bytes);
+
+    zero_frame = vmm_alloc_frame();
+    if (!zero_frame) {
+        KPANIC("VMM: cannot allocate the zero page");
+    }
+    frame_clear(zero_frame);
+
+    KINFO("VMM initialized (zero page at %lx, NX %s, PCID %s)",
+          zero_frame, vmm_nx_bit ? "on" : "off", vmm_pcid ? "on" : "off");
+}
+
+/* Drop one reference to a table (level 0 = page table); free it when unused */
+static void vmm_put_table(paddr_t table, int level) {
+    if (__atomic_sub_fetch(frame_ref(table), 1, __ATOMIC_ACQ_REL) > 0) {
+        return;  /* Still shared */
+    }
+
+    uint64_t *entries = (uint64_t *)phys_to_virt(table);
+    for (int i = 0; i < PT_ENTRIES; i++) {
+        uint64_t entry = entries[i];
+        if (!(entry & PTE_PRESENT)) continue;
+
+        if (level == 0) {
+            vmm_free_frame(entry & PTE_ADDR_MASK);
+        } else {
+            vmm_put_table(entry & PTE_ADDR_MASK, level - 1);
+        }
+    }
+    pmm_free_frame(vmm_pmm, (uint32_t)(table / PAGE_SIZE));
+}
+
+/* ===== COPY-ON-WRITE SHARING ===== */
+/*
+ * Share what an entry points to with one more owner. Writable entries
+ * become read-only + PTE_COW; for a table entry that write-protects
+ * the whole subtree below it. PTE_SHARED pages keep write access: the
+ * first write through a protected table just unshares the path.
+ */
+static inline void vmm_share_entry(uint64_t *entry) {
+    if (!(*entry & PTE_PRESENT)) return;
+
+    if ((*entry & PTE_WRITABLE) && !(*entry & PTE_SHARED)) {
+        *entry = (*entry & ~PTE_WRITABLE) | PTE_COW;
+    }
+    vmm_get_frame(*entry & PTE_ADDR_MASK);
+}
+
+/*
+ * Make the table behind a PTE_COW table entry private to this owner.
+ * A shared table is copied and every child becomes shared between the
+ * two copies; a table we already own exclusively is just made writable.
+ */
+static bool vmm_unshare_table(uint64_t *entry, int level) {
+    paddr_t table = *entry & PTE_ADDR_MASK;
+
+    if (frame_is_shared(table)) {
+        paddr_t copy = vmm_alloc_frame();
+        if (!copy) return false;
+
+        uint64_t *src = (uint64_t *)phys_to_virt(table);
+        for (int i = 0; i < PT_ENTRIES; i++) {
+            vmm_share_entry(&src[i]);
+        }
+        memcpy(phys_to_virt(copy), src, PAGE_SIZE);
+
+        vmm_put_table(table, level);
+        *entry = copy | (*entry & ~PTE_ADDR_MASK);
+    }
+
+    *entry = (*entry | PTE_WRITABLE) & ~PTE_COW;
+    return true;
+}
+
+/* ===== PAGE TABLE WALK ===== */
+uint64_t *vmm_walk(paddr_t pml4, vaddr_t addr, bool create) {
+    uint64_t *table = (uint64_t *)phys_to_virt(pml4);
+
+    for (int level = 3; level > 0; level--) {
+        uint64_t *entry = &table[(addr >> (12 + 9 * level)) & 0x1FF];
+
+        if (!(*entry & PTE_PRESENT)) {
+            if (!create) return NULL;
+
+            paddr_t frame = vmm_alloc_frame();
+            if (!frame) return NULL;
+            frame_clear(frame);
+
+            /* Leaf entries carry the real permissions */
+            *entry = frame | PTE_PRESENT | PTE_WRITABLE | PTE_USER;
+        } else if (*entry & PTE_HUGE) {
+            return NULL;  /* Large pages are never demand-paged */
+        } else if (create && (*entry & PTE_COW)) {
+            /* About to modify the leaf: the path must be private */
+            if (!vmm_unshare_table(entry, level - 1)) return NULL;
+        }
+
+        table = table_of(*entry);
+    }
+
+    return &table[(addr >> 12) & 0x1FF];
+}
+
+int vmm_map_page(address_space_t *as, vaddr_t addr, paddr_t frame, uint64_t flags) {
+    uint64_t *pte = vmm_walk(as->pml4, addr, true);
+    if (!pte) return -1;
+
+    *pte = (frame & PTE_ADDR_MASK) | flags | PTE_PRESENT;
+    tlb_flush_page(as, addr);
+    return 0;
+}
+
+/* ===== ADDRESS SPACES ===== */
+address_space_t *vmm_create_address_space(void) {
+    address_space_t *as = NULL;
+    size_t slot = 0;
+
+    spinlock_acquire(&address_spaces_lock);
+    for (slot = 0; slot < VMM_MAX_SPACES; slot++) {
+        if (!address_spaces[slot].in_use) {
+            as = &address_spaces[slot];
+            as->in_use = true;
+            break;
+        }
+    }
+    spinlock_release(&address_spaces_lock);
+
+    if (!as) return NULL;
+
+    paddr_t pml4 = vmm_alloc_frame();
+    if (!pml4) {
+        as->in_use = false;
+        return NULL;
+    }
+
+    /* Empty user half, shared kernel half */
+    uint64_t *dst = (uint64_t *)phys_to_virt(pml4);
+    uint64_t *src = (uint64_t *)phys_to_virt(kernel_pml4);
+    memset(dst, 0, PT_ENTRIES / 2 * sizeof(uint64_t));
+    memcpy(&dst[PT_ENTRIES / 2], &src[PT_ENTRIES / 2], PT_ENTRIES / 2 * sizeof(uint64_t));
+
+    as->pml4 = pml4;
+    as->num_areas = 0;
+    as->resident_pages = 0;
+    spinlock_init(&as->lock);
+
+    /* One PCID per slot; the previous owner's entries may still be cached anywhere */
+    as->pcid = (uint16_t)(slot + 1);
+    as->cpu_mask = 0;
+    as->tlb_stale_mask = ~0ULL;
+
+    return as;
+}
+
+address_space_t *vmm_clone_address_space(address_space_t *parent) {
+    address_space_t *child = vmm_create_address_space();
+    if (!child) return NULL;
+
+    spinlock_acquire(&parent->lock);
+
+    for (size_t i = 0; i < parent->num_areas; i++) {
+        child->areas[i] = parent->areas[i];
+    }
+    child->num_areas = parent->num_areas;
+    child->resident_pages = parent->resident_pages;
+
+    /*
+     * Share each populated top-level subtree instead of walking it:
+     * cost is bounded by the 256 user PML4 entries, not by how much
+     * memory the parent has touched. Lower levels are copied lazily by
+     * vmm_unshare_table() on the first write fault beneath them.
+     */
+    uint64_t *src = (uint64_t *)phys_to_virt(parent->pml4);
+    uint64_t *dst = (uint64_t *)phys_to_virt(child->pml4);
+    for (int i = 0; i < PT_ENTRIES / 2; i++) {
+        vmm_share_entry(&src[i]);
+        dst[i] = src[i];
+    }
+
+    spinlock_release(&parent->lock);
+
+    /* The parent just lost write access to everything it had mapped */
+    tlb_flush_all(parent);
+
+    return child;
+}
+
+void vmm_destroy_address_space(address_space_t *as) {
+    if (!as) return;
+
+    /* Never free the tables this CPU is running on */
+    if (vmm_is_loaded(as)) {
+        write_cr3(kernel_pml4);
+        this_cpu_write(active_as, NULL);
+    }
+
+    /* Only the user half is private */
+    uint64_t *pml4 = (uint64_t *)phys_to_virt(as->pml4);
+    for (int i = 0; i < PT_ENTRIES / 2; i++) {
+        if (pml4[i] & PTE_PRESENT) {
+            vmm_put_table(pml4[i] & PTE_ADDR_MASK, 2);
+        }
+    }
+    vmm_free_frame(as->pml4);
+
+    as->pml4 = 0;
+    as->num_areas = 0;
+    as->resident_pages = 0;
+
+    spinlock_acquire(&address_spaces_lock);
+    as->in_use = false;
+    spinlock_release(&address_spaces_lock);
+}
+
+/*
+ * With PCIDs each space keeps its TLB entries across switches: CR3 is
+ * loaded with CR3_NOFLUSH unless this CPU's bit in tlb_stale_mask says
+ * the tables changed since it last had them loaded. The kernel tables
+ * (PCID 0) hold only global entries. active_as is published before the
+ * stale bit is consumed; tlb_batch_flush() relies on that order.
+ */
+void vmm_switch_address_space(address_space_t *as) {
+    this_cpu_write(active_as, as);
+
+    if (!as) {
+        write_cr3(kernel_pml4 | (vmm_pcid ? CR3_NOFLUSH : 0));
+        return;
+    }
+
+    uint64_t bit = 1ULL << this_cpu_read(cpu_id);
+    __atomic_or_fetch(&as->cpu_mask, bit, __ATOMIC_SEQ_CST);
+    bool stale = __atomic_fetch_and(&as->tlb_stale_mask, ~bit, __ATOMIC_SEQ_CST) & bit;
+
+    if (!vmm_pcid) {
+        write_cr3(as->pml4);
+    } else {
+        write_cr3(as->pml4 | as->pcid | (stale ? 0 : CR3_NOFLUSH));
+    }
+}
+
+bool vmm_set_pcid(bool enabled) {
+    bool previous = vmm_pcid;
+    if (enabled && !paging_pcid_supported()) return previous;
+
+    /* Entries cached under a PCID went unflushed while PCIDs were off */
+    if (enabled && !previous) {
+        spinlock_acquire(&address_spaces_lock);
+        for (size_t i = 0; i < VMM_MAX_SPACES; i++) {
+            address_spaces[i].tlb_stale_mask = ~0ULL;
+        }
+        spinlock_release(&address_spaces_lock);
+    }
+    vmm_pcid = enabled;
+    return previous;
+}
+
+/* ===== MEMORY AREAS ===== */
+int vmm_add_area(address_space_t *as, const vm_area_t *area) {
+    if (area->start >= area->end ||
+        (area->start | area->end) & (PAGE_SIZE - 1)) {
+        return -1;
+    }
+
+    spinlock_acquire(&as->lock);
+
+    if (as->num_areas >= VMM_MAX_AREAS) {
+        spinlock_release(&as->lock);
+        return -1;
+    }
+
+    /* Keep sorted; reject overlaps */
+    size_t pos = 0;
+    while (pos < as->num_areas && as->areas[pos].start < area->start) pos++;
+
+    if ((pos > 0 && as->areas[pos - 1].end > area->start) ||
+        (pos < as->num_areas && as->areas[pos].start < area->end)) {
+        spinlock_release(&as->lock);
+        return -1;
+    }
+
+    for (size_t i = as->num_areas; i > pos; i--) {
+        as->areas[i] = as->areas[i - 1];
+    }
+    as->areas[pos] = *area;
+    as->num_areas++;
+
+    spinlock_release(&as->lock);
+    return 0;
+}
+
+vm_area_t *vmm_find_area(address_space_t *as, vaddr_t addr) {
+    size_t lo = 0, hi = as->num_areas;
+
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        vm_area_t *area = &as->areas[mid];
+        if (addr < area->start) {
+            hi = mid;
+        } else if (addr >= area->end) {
+            lo = mid + 1;
+        } else {
+            return area;
+        }
+    }
+    return NULL;
+}
+
+/* ===== DEMAND PAGING ===== */
+static uint64_t vmm_area_pte_flags(const vm_area_t *area) {
+    uint64_t flags = PTE_PRESENT;
+    if (area->prot & VMA_WRITE) flags |= PTE_WRITABLE;
+    if (area->prot & VMA_USER) flags |= PTE_USER;
+    if (!(area->prot & VMA_EXEC)) flags |= vmm_nx_bit;
+    return flags;
+}
+
+/*
+ * Map physically contiguous frames over a new VMA_SHARED area. Each
+ * page takes a reference, so the frames outlive whoever allocated them
+ * until every space mapping them is gone. On failure the area and any
+ * pages already mapped are gone again.
+ */
+int vmm_map_shared(address_space_t *as, const vm_area_t *area, paddr_t frame) {
+    if (area->type != VMA_SHARED || vmm_add_area(as, area) != 0) return -1;
+
+    uint64_t flags = vmm_area_pte_flags(area) | PTE_SHARED;
+    int result = 0;
+
+    spinlock_acquire(&as->lock);
+    for (vaddr_t page = area->start; page < area->end; page += PAGE_SIZE) {
+        paddr_t f = frame + (page - area->start);
+        vmm_get_frame(f);
+        if (vmm_map_page(as, page, f, flags) != 0) {
+            vmm_free_frame(f);
+            result = -1;
+            break;
+        }
+    }
+    spinlock_release(&as->lock);
+
+    if (result != 0) {
+        vmm_remove_areas(as, area->start, area->end);
+    }
+    return result;
+}
+
+/*
+ * Drop the pages of [start, end) so they fault back in from their area.
+ * Frames are only freed once no CPU can still reach them through its
+ * TLB, so invalidations are gathered and flushed at most once per
+ * VMM_UNMAP_BATCH frames (a whole-PCID flush past TLB_BATCH_MAX pages).
+ */
+#define VMM_UNMAP_BATCH 128
+
+static void vmm_unmap_flush(tlb_batch_t *batch, paddr_t *frames, uint32_t *num_frames) {
+    tlb_batch_flush(batch);
+    for (uint32_t i = 0; i < *num_frames; i++) {
+        vmm_free_frame(frames[i]);
+    }
+    *num_frames = 0;
+}
+
+int vmm_unmap_range(address_space_t *as, vaddr_t start, vaddr_t end) {
+    if ((start | end) & (PAGE_SIZE - 1) || start >= end) return -1;
+
+    tlb_batch_t batch;
+    paddr_t frames[VMM_UNMAP_BATCH];
+    uint32_t num_frames = 0;
+    int result = 0;
+
+    tlb_batch_init(&batch, as);
+    spinlock_acquire(&as->lock);
+
+    for (vaddr_t page = start; page < end; page += PAGE_SIZE) {
+        uint64_t *pte = vmm_walk(as->pml4, page, false);
+        if (!pte || !(*pte & PTE_PRESENT)) continue;
+
+        /* The table may be shared with a fork child: make the path private first */
+        pte = vmm_walk(as->pml4, page, true);
+        if (!pte) {
+            result = -1;
+            break;
+        }
+
+        paddr_t frame = *pte & PTE_ADDR_MASK;
+        if (frame != zero_frame && !(*pte & PTE_SHARED)) {
+            as->resident_pages--;
+        }
+        *pte = 0;
+        tlb_batch_add(&batch, page);
+
+        frames[num_frames++] = frame;
+        if (num_frames == VMM_UNMAP_BATCH) {
+            vmm_unmap_flush(&batch, frames, &num_frames);
+        }
+    }
+    vmm_unmap_flush(&batch, frames, &num_frames);
+
+    spinlock_release(&as->lock);
+    return result;
+}
+
+/*
+ * munmap: drop the pages of [start, end), then the areas inside it. An
+ * area reaching past either end is refused rather than split, and
+ * nothing changes.
+ */
+int vmm_remove_areas(address_space_t *as, vaddr_t start, vaddr_t end) {
+    if ((start | end) & (PAGE_SIZE - 1) || start >= end) return -1;
+
+    spinlock_acquire(&as->lock);
+    for (size_t i = 0; i < as->num_areas; i++) {
+        const vm_area_t *area = &as->areas[i];
+        if (area->end > start && area->start < end &&
+            (area->start < start || area->end > end)) {
+            spinlock_release(&as->lock);
+            return -1;
+        }
+    }
+    spinlock_release(&as->lock);
+
+    if (vmm_unmap_range(as, start, end) != 0) return -1;
+
+    spinlock_acquire(&as->lock);
+    size_t kept = 0;
+    for (size_t i = 0; i < as->num_areas; i++) {
+        if (as->areas[i].start >= start && as->areas[i].end <= end) continue;
+        as->areas[kept++] = as->areas[i];
+    }
+    as->num_areas = kept;
+    spinlock_release(&as->lock);
+    return 0;
+}
+
+/* True if no byte of the page comes from the image */
+static bool vmm_page_is_zero(const vm_area_t *area, vaddr_t page) {
+    if (area->type == VMA_ANON) return true;
+    return page + PAGE_SIZE <= area->file_start || page >= area->file_end;
+}
+
+/* Copy the image bytes that overlap the page, zero the rest */
+static void vmm_fill_from_image(const vm_area_t *area, vaddr_t page, paddr_t frame) {
+    uint8_t *dst = (uint8_t *)phys_to_virt(frame);
+    vaddr_t from = page > area->file_start ? page : area->file_start;
+    vaddr_t to = page + PAGE_SIZE < area->file_end ? page + PAGE_SIZE : area->file_end;
+
+    memset(dst, 0, PAGE_SIZE);
+    memcpy(dst + (from - page), area->image + (from - area->file_start), to - from);
+}
+
+vmm_fault_result_t vmm_handle_fault(address_space_t *as, vaddr_t addr, uint64_t error) {
+    vaddr_t page = ALIGN_DOWN(addr, PAGE_SIZE);
+    vmm_fault_result_t result = VMM_FAULT_RESOLVED;
+
+    spinlock_acquire(&as->lock);
+
+    vm_area_t *area = vmm_find_area(as, addr);
+    if (!area ||
+        ((error & PF_WRITE) && !(area->prot & VMA_WRITE)) ||
+        ((error & PF_FETCH) && !(area->prot & VMA_EXEC)) ||
+        ((error & PF_USER) && !(area->prot & VMA_USER)) ||
+        (error & PF_RESERVED)) {
+        spinlock_release(&as->lock);
+        this_cpu_inc(stats.fault_invalid);
+        return VMM_FAULT_INVALID;
+    }
+
+    /*
+     * Only a write or a new leaf entry needs the path private: a read
+     * of a page another CPU already mapped leaves fork-shared tables be.
+     */
+    uint64_t *pte = vmm_walk(as->pml4, page, false);
+    bool present = pte && (*pte & PTE_PRESENT);
+    if ((error & PF_WRITE) || (!present && area->type != VMA_SHARED)) {
+        pte = vmm_walk(as->pml4, page, true);
+        if (!pte) {
+            spinlock_release(&as->lock);
+            this_cpu_inc(stats.fault_invalid);
+            return VMM_FAULT_OOM;
+        }
+    }
+
+    uint64_t flags = vmm_area_pte_flags(area);
+
+    if (!present && area->type == VMA_SHARED) {
+        result = VMM_FAULT_INVALID;  /* Unmapped hole in a shared area */
+    } else if (!present) {
+        if (vmm_page_is_zero(area, page) && !(error & PF_WRITE)) {
+            /* Read of untouched zero memory: share the zero page */
+            *pte = zero_frame | (flags & ~PTE_WRITABLE) |
+                   ((area->prot & VMA_WRITE) ? PTE_COW : 0);
+            this_cpu_inc(stats.fault_minor);
+        } else {
+            paddr_t frame = vmm_alloc_frame();
+            if (!frame) {
+                result = VMM_FAULT_OOM;
+            } else {
+                if (vmm_page_is_zero(area, page)) {
+                    frame_clear(frame);
+                    this_cpu_inc(stats.fault_minor);
+                } else {
+                    vmm_fill_from_image(area, page, frame);
+                    this_cpu_inc(stats.fault_major);
+                }
+                *pte = frame | flags;
+                as->resident_pages++;
+            }
+        }
+    } else if ((error & PF_WRITE) && (*pte & PTE_COW)) {
+        /* First write to a shared frame (zero page or after fork) */
+        paddr_t shared = *pte & PTE_ADDR_MASK;
+        this_cpu_inc(stats.fault_cow);
+
+        if (!frame_is_shared(shared)) {
+            *pte = (*pte | PTE_WRITABLE) & ~PTE_COW;  /* Last owner keeps it */
+        } else {
+            paddr_t frame = vmm_alloc_frame();
+            if (!frame) {
+                result = VMM_FAULT_OOM;
+            } else {
+                if (shared == zero_frame) {
+                    frame_clear(frame);
+                    as->resident_pages++;
+                } else {
+                    memcpy(phys_to_virt(frame), phys_to_virt(shared), PAGE_SIZE);
+                }
+                *pte = frame | flags;
+                vmm_free_frame(shared);
+            }
+        }
+    } else {
+        /* Another CPU already resolved it: just refresh the TLB */
+        this_cpu_inc(stats.fault_minor);
+    }
+
+    tlb_flush_page(as, page);
+    spinlock_release(&as->lock);
+    if (result != VMM_FAULT_RESOLVED) {
+        this_cpu_inc(stats.fault_invalid);
+    }
+    return result;
+}
@@ -1,97 +1,191 @@
 #include <vga.h>
 #include <types.h>
+#include <kernel/cpu.h>
+
+static inline uint16_t vga_blank(const vga_terminal_t *term) {
+    return (term->bg_color << 12) | (term->fg_color << 8) | ' ';
+}
+
+/* Hardware scrolling needs the CRTC to be showing text */
+static bool vga_text_mode(void) {
+    outb(VGA_GC_INDEX, VGA_GC_MISC);
+    return !(inb(VGA_GC_DATA) & VGA_GC_MISC_GRAPHICS);
+}
+
+static void vga_set_start(uint32_t cell) {
+    outb(VGA_CRTC_INDEX, VGA_CRTC_START_HI);
+    outb(VGA_CRTC_DATA, (cell >> 8) & 0xFF);
+    outb(VGA_CRTC_INDEX, VGA_CRTC_START_LO);
+    outb(VGA_CRTC_DATA, cell & 0xFF);
+}
+
+static inline uint16_t *vga_shadow_row(vga_terminal_t *term, uint32_t row) {
+    return &term->shadow[((term->top + row) % term->height) * term->width];
+}
+
+static inline void vga_mark(vga_terminal_t *term, uint32_t start, uint32_t end) {
+    if (term->dirty_start >= term->dirty_end) {
+        term->dirty_start = start;
+        term->dirty_end = end;
+        return;
+    }
+    if (start < term->dirty_start) term->dirty_start = start;
+    if (end > term->dirty_end) term->dirty_end = end;
+}
+
+void vga_flush(vga_terminal_t *term) {
+    uint32_t cell = term->dirty_start;
+    uint32_t end = term->dirty_end;
+    volatile uint16_t *vram = term->buffer + term->origin;
+
+    while (cell < end) {
+        uint32_t row = cell / term->width;
+        uint32_t col = cell % term->width;
+        uint32_t run = term->width - col;
+        if (run > end - cell) run = end - cell;
+
+        const uint16_t *src = vga_shadow_row(term, row) + col;
+        for (uint32_t i = 0; i < run; i++) {
+            vram[cell + i] = src[i];
+        }
+        cell += run;
+    }
+    term->dirty_start = term->dirty_end = 0;
+
+    /* Only once the rows it reveals are written */
+    if (term->origin != term->shown_origin) {
+        vga_set_start(term->origin);
+        term->shown_origin = term->origin;
+    }
+}
 
 void vga_initilize(vga_terminal_t *term, uint16_t *buffer, uint32_t width, uint32_t height) {
     term->buffer = buffer;
     term->width = width;
     term->height = height;
+    if (width * height > VGA_SHADOW_CELLS) {
+        term->height = VGA_SHADOW_CELLS / width;
+    }
     term->row = 0;
     term->col = 0;
     term->fg_color = VGA_COLOR_WHITE;
     term->bg_color = VGA_COLOR_BLACK;
-    
+
+    /* Without a text-mode CRTC every scroll is a rewrite of the one screen */
+    term->window_cells = vga_text_mode() ? VGA_WINDOW_CELLS : term->width * term->height;
+    term->origin = 0;
+    term->shown_origin = 0;
+    term->dirty_start = term->dirty_end = 0;
+    if (term->window_cells != term->width * term->height) {
+        vga_set_start(0);
+    }
+
     vga_clear_screen(term);
 }
 
 void vga_clear_screen(vga_terminal_t *term) {
-    uint16_t blank = (term->bg_color << 12) | (term->fg_color << 8) | ' ';
-    
+    uint16_t blank = vga_blank(term);
+
     for (uint32_t i = 0; i < term->width * term->height; i++) {
-        term->buffer[i] = blank;
+        term->shadow[i] = blank;
     }
-    
+
+    term->top = 0;
     term->row = 0;
     term->col = 0;
+    vga_mark(term, 0, term->width * term->height);
+    vga_flush(term);
 }
 
+/*
+ * The screen moves one row down the VRAM window; what was visible
+ * stays where it is in VRAM. Past the end of the window it starts over
+ * at the top, rewritten from the shadow.
+ */
 static void vga_scroll(vga_terminal_t *term) {
-    uint16_t blank = (term->bg_color << 12) | (term->fg_color << 8) | ' ';
-    
-    /* Shift lines up */
-    for (uint32_t i = 0; i < (term->height - 1) * term->width; i++) {
-        term->buffer[i] = term->buffer[i + term->width];
-    }
-    
-    /* Clear last line */
-    for (uint32_t i = (term->height - 1) * term->width; i < term->height * term->width; i++) {
-        term->buffer[i] = blank;
-    }
-    
+    uint16_t blank = vga_blank(term);
+    uint32_t screen = term->width * term->height;
+
+    vga_flush(term);
+
+    term->top = (term->top + 1) % term->height;
+    uint16_t *last = vga_shadow_row(term, term->height - 1);
+    for (uint32_t i = 0; i < term->width; i++) {
+        last[i] = blank;
+    }
+
+    if (term->origin + screen + term->width <= term->window_cells) {
+        term->origin += term->width;
+        vga_mark(term, screen - term->width, screen);
+    } else {
+        term->origin = 0;
+        vga_mark(term, 0, screen);
+    }
+
     term->row = term->height - 1;
     term->col = 0;
 }
 
-void vga_putchar(vga_terminal_t *term, char c) {
+static void vga_newline(vga_terminal_t *term) {
+    term->col = 0;
+    term->row++;
+    if (term->row >= term->height) {
+        vga_scroll(term);
+    }
+}
+
+/* Shadow only; callers flush */
+static void vga_put(vga_terminal_t *term, char c) {
     if (c == '\n') {
-        term->col = 0;
-        term->row++;
-        if (term->row >= term->height) {
-            vga_scroll(term);
-        }
+        vga_newline(term);
         return;
     }
-    
+
     if (c == '\t') {
         term->col += 4;
         if (term->col >= term->width) {
-            term->col = 0;
-            term->row++;
-            if (term->row >= term->height) {
-                vga_scroll(term);
-            }
+            vga_newline(term);
         }
         return;
     }
-    
+
     if (c == '\r') {
         term->col = 0;
         return;
     }
-    
-    uint32_t index = term->row * term->width + term->col;
+
     uint16_t entry = (term->bg_color << 12) | (term->fg_color << 8) | (uint8_t)c;
-    term->buffer[index] = entry;
-    
+    vga_shadow_row(term, term->row)[term->col] = entry;
+
+    uint32_t index = term->row * term->width + term->col;
+    vga_mark(term, index, index + 1);
+
     term->col++;
     if (term->col >= term->width) {
-        term->col = 0;
-        term->row++;
-        if (term->row >= term->height) {
-            vga_scroll(term);
-        }
+        vga_newline(term);
     }
 }
 
+void vga_putchar(vga_terminal_t *term, char c) {
+    vga_put(term, c);
+    vga_flush(term);
+}
+
 void vga_print(vga_terminal_t *term, const char *str) {
     while (*str) {
-        vga_putchar(term, *str);
+        vga_put(term, *str);
         str++;
     }
+    vga_flush(term);
 }
 
 void vga_println(vga_terminal_t *term, const char *str) {
-    vga_print(term, str);
-    vga_putchar(term, '\n');
+    while (*str) {
+        vga_put(term, *str);
+        str++;
+    }
+    vga_put(term, '\n');
+    vga_flush(term);
 }
 
 void vga_print_hex(vga_terminal_t *term, uint64_t value) {
@@ -99,18 +193,18 @@ void vga_print_hex(vga_terminal_t *term, uint64_t value) {
     char buffer[17];
     int i = 15;
     buffer[16] = 0;
-    
+
     if (value == 0) {
         vga_print(term, "0");
         return;
     }
-    
+
     while (value > 0 && i >= 0) {
         buffer[i] = hex[value & 0xF];
         value >>= 4;
         i--;
     }
-    
+
     vga_print(term, "0x");
     vga_print(term, &buffer[i + 1]);
 }
@@ -29,3 +29,37 @@ size_t strlen(const char *s) {
     while (*p) p++;
     return p - s;
 }
+
+/* Memory primitives use string instructions so GCC cannot turn the
+ * loop back into a call to itself. */
+void *memset(void *dst, int c, size_t n) {
+    void *ret = dst;
+    __asm__ volatile("rep stosb" : "+D"(dst), "+c"(n) : "a"(c) : "memory");
+    return ret;
+}
+
+void *memcpy(void *dst, const void *src, size_t n) {
+    void *ret = dst;
+    __asm__ volatile("rep movsb" : "+D"(dst), "+S"(src), "+c"(n) :: "memory");
+    return ret;
+}
+
+void *memmove(void *dst, const void *src, size_t n) {
+    unsigned char *d = dst;
+    const unsigned char *s = src;
+    if (d <= s || d >= s + n) {
+        return memcpy(dst, src, n);
+    }
+    /* Overlapping with dst above src: copy backwards */
+    d += n - 1;
+    s += n - 1;
+    __asm__ volatile("std; rep movsb; cld" : "+D"(d), "+S"(s), "+c"(n) :: "memory");
+    return dst;
+}
+
+int memcmp(const void *a, const void *b, size_t n) {
+    const unsigned char *p = a, *q = b;
+    while (n && *p == *q) { p++; q++; n--; }
+    if (n == 0) return 0;
+    return *p - *q;
+}
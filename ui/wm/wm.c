@@ -1,23 +1,53 @@
 /*
  * Window Manager Implementation
  * Windows 7 Aero-inspired desktop environment
+ *
+ * Locking:
+ *   wm_lock           (rwlock)  - membership and z-order of desktop.windows,
+ *                                 and the window framebuffers. Traversals
+ *                                 take it for reading; only create/destroy/
+ *                                 raise/resize take it for writing.
+ *   wm_geometry_lock  (seqlock) - window x/y/width/height/flags/has_focus and
+ *                                 desktop.focused_window. Readers snapshot
+ *                                 and retry instead of blocking.
+ *   needs_redraw is set and cleared with atomics.
+ *
+ * Lock order: wm_lock before wm_geometry_lock.
  */
 
 #include <ui/wm.h>
 #include <drivers/display.h>
 #include <drivers/input.h>
 #include <kernel/kernel.h>
+#include <kernel/trace.h>
+#include <kernel/sync.h>
 #include <string.h>
 #include <stdlib.h>
 
 /* ===== DESKTOP STATE ===== */
 static desktop_t desktop = {0};
 static uint32_t next_window_id = 1;
-static spinlock_t wm_lock;
+static rwlock_t wm_lock;
+static seqlock_t wm_geometry_lock;
+
+/* Caller must hold wm_lock (read or write) */
+static window_t *wm_find_window(uint32_t window_id) {
+    for (uint32_t i = 0; i < desktop.num_windows; i++) {
+        if (desktop.windows[i]->window_id == window_id) {
+            return desktop.windows[i];
+        }
+    }
+    return NULL;
+}
+
+static inline void wm_mark_dirty(window_t *window) {
+    __atomic_store_n(&window->needs_redraw, true, __ATOMIC_RELEASE);
+}
 
 /* ===== WINDOW MANAGEMENT ===== */
 void wm_init(void) {
-    spinlock_init(&wm_lock);
+    rwlock_init(&wm_lock);
+    seqlock_init(&wm_geometry_lock);
     
     desktop.windows = (window_t **)malloc(sizeof(window_t *) * 256);
     desktop.num_windows = 0;
@@ -32,16 +62,16 @@ void wm_init(void) {
 
 window_t *wm_create_window(const char *title, uint32_t x, uint32_t y, 
                            uint32_t width, uint32_t height, kpid_t owner) {
-    spinlock_acquire(&wm_lock);
+    write_lock(&wm_lock);
     
     if (desktop.num_windows >= 256) {
-        spinlock_release(&wm_lock);
+        write_unlock(&wm_lock);
         return NULL;
     }
     
     window_t *window = (window_t *)malloc(sizeof(window_t));
     if (!window) {
-        spinlock_release(&wm_lock);
+        write_unlock(&wm_lock);
         return NULL;
     }
     
@@ -71,149 +101,177 @@ window_t *wm_create_window(const char *title, uint32_t x, uint32_t y,
     KINFO("Window created: %s (ID %d, %ux%u @ %u,%u)", 
           title, window->window_id, width, height, x, y);
     
-    spinlock_release(&wm_lock);
+    write_unlock(&wm_lock);
     return window;
 }
 
 void wm_destroy_window(uint32_t window_id) {
-    spinlock_acquire(&wm_lock);
+    write_lock(&wm_lock);
     
     for (uint32_t i = 0; i < desktop.num_windows; i++) {
         if (desktop.windows[i]->window_id == window_id) {
-            free(desktop.windows[i]->framebuffer);
-            free(desktop.windows[i]);
+            window_t *window = desktop.windows[i];
+
+            write_seqlock(&wm_geometry_lock);
+            if (desktop.focused_window == window) {
+                desktop.focused_window = NULL;
+            }
+            write_sequnlock(&wm_geometry_lock);
             
             for (uint32_t j = i; j < desktop.num_windows - 1; j++) {
                 desktop.windows[j] = desktop.windows[j + 1];
             }
             desktop.num_windows--;
             
+            free(window->framebuffer);
+            free(window);
+
             KINFO("Window destroyed (ID %d)", window_id);
             break;
         }
     }
     
-    spinlock_release(&wm_lock);
+    write_unlock(&wm_lock);
 }
 
 void wm_show_window(uint32_t window_id) {
-    spinlock_acquire(&wm_lock);
-    
-    for (uint32_t i = 0; i < desktop.num_windows; i++) {
-        if (desktop.windows[i]->window_id == window_id) {
-            desktop.windows[i]->flags |= WINDOW_FLAG_VISIBLE;
-            desktop.windows[i]->needs_redraw = true;
-            break;
-        }
+    read_lock(&wm_lock);
+
+    window_t *window = wm_find_window(window_id);
+    if (window) {
+        write_seqlock(&wm_geometry_lock);
+        window->flags |= WINDOW_FLAG_VISIBLE;
+        write_sequnlock(&wm_geometry_lock);
+        wm_mark_dirty(window);
     }
     
-    spinlock_release(&wm_lock);
+    read_unlock(&wm_lock);
 }
 
 void wm_hide_window(uint32_t window_id) {
-    spinlock_acquire(&wm_lock);
-    
-    for (uint32_t i = 0; i < desktop.num_windows; i++) {
-        if (desktop.windows[i]->window_id == window_id) {
-            desktop.windows[i]->flags &= ~WINDOW_FLAG_VISIBLE;
-            break;
-        }
+    read_lock(&wm_lock);
+
+    window_t *window = wm_find_window(window_id);
+    if (window) {
+        write_seqlock(&wm_geometry_lock);
+        window->flags &= ~WINDOW_FLAG_VISIBLE;
+        write_sequnlock(&wm_geometry_lock);
     }
     
-    spinlock_release(&wm_lock);
+    read_unlock(&wm_lock);
 }
 
 void wm_focus_window(uint32_t window_id) {
-    spinlock_acquire(&wm_lock);
+    read_lock(&wm_lock);
+
+    window_t *window = wm_find_window(window_id);
+    window_t *previous;
+
+    write_seqlock(&wm_geometry_lock);
     
     /* Remove focus from current window */
-    if (desktop.focused_window) {
-        desktop.focused_window->has_focus = false;
-        desktop.focused_window->needs_redraw = true;
+    previous = desktop.focused_window;
+    if (previous) {
+        previous->has_focus = false;
     }
     
     /* Set focus to new window */
-    for (uint32_t i = 0; i < desktop.num_windows; i++) {
-        if (desktop.windows[i]->window_id == window_id) {
-            desktop.windows[i]->has_focus = true;
-            desktop.windows[i]->needs_redraw = true;
-            desktop.focused_window = desktop.windows[i];
-            break;
-        }
+    if (window) {
+        window->has_focus = true;
+        desktop.focused_window = window;
     }
     
-    spinlock_release(&wm_lock);
+    write_sequnlock(&wm_geometry_lock);
+
+    /* Refocusing the focused window changes nothing on screen */
+    if (previous != window) {
+        if (previous) wm_mark_dirty(previous);
+        if (window) wm_mark_dirty(window);
+    }
+
+    read_unlock(&wm_lock);
 }
 
 void wm_move_window(uint32_t window_id, uint32_t x, uint32_t y) {
-    spinlock_acquire(&wm_lock);
-    
-    for (uint32_t i = 0; i < desktop.num_windows; i++) {
-        if (desktop.windows[i]->window_id == window_id) {
-            desktop.windows[i]->x = x;
-            desktop.windows[i]->y = y;
-            desktop.windows[i]->needs_redraw = true;
-            break;
-        }
+    read_lock(&wm_lock);
+
+    window_t *window = wm_find_window(window_id);
+    if (window) {
+        write_seqlock(&wm_geometry_lock);
+        window->x = x;
+        window->y = y;
+        write_sequnlock(&wm_geometry_lock);
+        wm_mark_dirty(window);
     }
     
-    spinlock_release(&wm_lock);
+    read_unlock(&wm_lock);
 }
 
 void wm_resize_window(uint32_t window_id, uint32_t width, uint32_t height) {
-    spinlock_acquire(&wm_lock);
-    
-    for (uint32_t i = 0; i < desktop.num_windows; i++) {
-        if (desktop.windows[i]->window_id == window_id) {
-            window_t *w = desktop.windows[i];
-            
-            /* Reallocate framebuffer */
-            if (w->framebuffer) free(w->framebuffer);
-            w->framebuffer = (color_t *)malloc(width * height * sizeof(color_t));
-            w->framebuffer_stride = width;
-            
-            w->width = width;
-            w->height = height;
-            w->needs_redraw = true;
-            break;
-        }
+    /* Larger than the screen is refused; it also keeps the size from overflowing */
+    if (!width || !height ||
+        (uint64_t)width * height > (uint64_t)desktop.screen_width * desktop.screen_height) {
+        return;
+    }
+
+    /*
+     * Write side: the compositor reads the pixels under the read lock,
+     * and the seqlock only covers the pointer, so the old buffer may be
+     * freed only once no reader can still be drawing from it.
+     */
+    write_lock(&wm_lock);
+
+    window_t *w = wm_find_window(window_id);
+    color_t *framebuffer = w ? (color_t *)malloc((size_t)width * height * sizeof(color_t)) : NULL;
+    if (framebuffer) {
+        color_t *old = w->framebuffer;
+
+        write_seqlock(&wm_geometry_lock);
+        w->framebuffer = framebuffer;
+        w->framebuffer_stride = width;
+        w->width = width;
+        w->height = height;
+        write_sequnlock(&wm_geometry_lock);
+
+        if (old) free(old);
+        wm_mark_dirty(w);
     }
     
-    spinlock_release(&wm_lock);
+    write_unlock(&wm_lock);
 }
 
 void wm_minimize_window(uint32_t window_id) {
-    spinlock_acquire(&wm_lock);
-    
-    for (uint32_t i = 0; i < desktop.num_windows; i++) {
-        if (desktop.windows[i]->window_id == window_id) {
-            desktop.windows[i]->flags |= WINDOW_FLAG_MINIMIZED;
-            break;
-        }
+    read_lock(&wm_lock);
+
+    window_t *window = wm_find_window(window_id);
+    if (window) {
+        write_seqlock(&wm_geometry_lock);
+        window->flags |= WINDOW_FLAG_MINIMIZED;
+        write_sequnlock(&wm_geometry_lock);
     }
     
-    spinlock_release(&wm_lock);
+    read_unlock(&wm_lock);
 }
 
 void wm_maximize_window(uint32_t window_id) {
-    spinlock_acquire(&wm_lock);
-    
-    for (uint32_t i = 0; i < desktop.num_windows; i++) {
-        if (desktop.windows[i]->window_id == window_id) {
-            desktop.windows[i]->flags |= WINDOW_FLAG_MAXIMIZED;
-            desktop.windows[i]->x = 0;
-            desktop.windows[i]->y = 0;
-            desktop.windows[i]->width = desktop.screen_width;
-            desktop.windows[i]->height = desktop.screen_height - 48;  /* Reserve taskbar */
-            break;
-        }
+    read_lock(&wm_lock);
+
+    window_t *window = wm_find_window(window_id);
+    if (window) {
+        write_seqlock(&wm_geometry_lock);
+        window->flags |= WINDOW_FLAG_MAXIMIZED;
+        window->x = 0;
+        window->y = 0;
+        window->width = desktop.screen_width;
+        window->height = desktop.screen_height - 48;  /* Reserve taskbar */
+        write_sequnlock(&wm_geometry_lock);
     }
     
-    spinlock_release(&wm_lock);
+    read_unlock(&wm_lock);
 }
 
 void wm_raise_window(uint32_t window_id) {
-    spinlock_acquire(&wm_lock);
+    write_lock(&wm_lock);
     
     /* Find window and move to end (rendered last = on top) */
     window_t *target = NULL;
@@ -229,28 +287,90 @@ void wm_raise_window(uint32_t window_id) {
         }
     }
     
-    spinlock_release(&wm_lock);
+    write_unlock(&wm_lock);
+}
+
+kpid_t wm_window_owner(uint32_t window_id) {
+    read_lock(&wm_lock);
+    window_t *window = wm_find_window(window_id);
+    kpid_t owner = window ? window->owner_pid : 0;
+    read_unlock(&wm_lock);
+    return owner;
+}
+
+/* ===== LOCK-FREE QUERIES ===== */
+void wm_get_window_geometry(window_t *window, window_geometry_t *out) {
+    uint32_t seq;
+
+    do {
+        seq = read_seqbegin(&wm_geometry_lock);
+        out->x = window->x;
+        out->y = window->y;
+        out->width = window->width;
+        out->height = window->height;
+        out->flags = window->flags;
+        out->has_focus = window->has_focus;
+    } while (read_seqretry(&wm_geometry_lock, seq));
+}
+
+window_t *wm_get_focused_window(void) {
+    window_t *focused;
+    uint32_t seq;
+
+    do {
+        seq = read_seqbegin(&wm_geometry_lock);
+        focused = desktop.focused_window;
+    } while (read_seqretry(&wm_geometry_lock, seq));
+
+    return focused;
+}
+
+uint32_t wm_window_at(uint32_t x, uint32_t y) {
+    uint32_t hit = 0;
+
+    read_lock(&wm_lock);
+
+    /* Topmost first: the list is ordered back to front */
+    for (size_t i = desktop.num_windows; i > 0; i--) {
+        window_t *window = desktop.windows[i - 1];
+        window_geometry_t g;
+        wm_get_window_geometry(window, &g);
+
+        if (!(g.flags & WINDOW_FLAG_VISIBLE) || (g.flags & WINDOW_FLAG_MINIMIZED)) {
+            continue;
+        }
+        if (x >= g.x && x < g.x + g.width && y >= g.y && y < g.y + g.height) {
+            hit = window->window_id;
+            break;
+        }
+    }
+
+    read_unlock(&wm_lock);
+    return hit;
 }
 
 /* ===== RENDERING ===== */
 void wm_draw_window(window_t *window) {
-    if (!window || !(window->flags & WINDOW_FLAG_VISIBLE)) return;
+    if (!window) return;
+
+    window_geometry_t g;
+    wm_get_window_geometry(window, &g);
+    if (!(g.flags & WINDOW_FLAG_VISIBLE)) return;
     
     /* Draw window background */
-    graphics_fill_rect(window->x, window->y, window->width, window->height, 
-                      window->background_color);
+    graphics_fill_rect(g.x, g.y, g.width, g.height, window->background_color);
     
     /* Draw title bar */
-    color_t title_color = window->has_focus ? 0xFF0078D4 : 0xFF808080;
-    graphics_fill_rect(window->x, window->y, window->width, 25, title_color);
+    color_t title_color = g.has_focus ? 0xFF0078D4 : 0xFF808080;
+    graphics_fill_rect(g.x, g.y, g.width, 25, title_color);
     
     /* Draw title text */
-    graphics_draw_string(window->x + 5, window->y + 5, window->title, 
+    graphics_draw_string(g.x + 5, g.y + 5, window->title,
                         COLOR_WHITE, title_color);
     
     /* Draw window border */
-    graphics_draw_rect(window->x, window->y, window->width, window->height, 
-                      window->has_focus ? COLOR_WHITE : 0xFF808080);
+    graphics_draw_rect(g.x, g.y, g.width, g.height,
+                      g.has_focus ? COLOR_WHITE : 0xFF808080);
 }
 
 void wm_draw_taskbar(void) {
@@ -265,10 +385,15 @@ void wm_draw_taskbar(void) {
     graphics_draw_string(10, taskbar_y + 12, "Start", COLOR_WHITE, 0xFF008000);
     
     /* Window buttons in taskbar (simplified) */
+    read_lock(&wm_lock);
+
     uint32_t btn_x = 60;
     for (uint32_t i = 0; i < desktop.num_windows; i++) {
-        if (desktop.windows[i]->flags & WINDOW_FLAG_VISIBLE &&
-            !(desktop.windows[i]->flags & WINDOW_FLAG_MINIMIZED)) {
+        window_geometry_t g;
+        wm_get_window_geometry(desktop.windows[i], &g);
+
+        if (g.flags & WINDOW_FLAG_VISIBLE &&
+            !(g.flags & WINDOW_FLAG_MINIMIZED)) {
             
             graphics_fill_rect(btn_x, taskbar_y + 5, 150, 38, 0xFF464646);
             graphics_draw_rect(btn_x, taskbar_y + 5, 150, 38, 0xFF808080);
@@ -280,6 +405,8 @@ void wm_draw_taskbar(void) {
         }
     }
     
+    read_unlock(&wm_lock);
+
     /* System clock area */
     graphics_draw_rect(desktop.screen_width - 75, taskbar_y + 10, 70, 30, 0xFF808080);
 }
@@ -289,38 +416,55 @@ void wm_draw_desktop(void) {
     graphics_clear(desktop.background_color);
     
     /* Draw all windows (back to front) */
+    read_lock(&wm_lock);
     for (uint32_t i = 0; i < desktop.num_windows; i++) {
         wm_draw_window(desktop.windows[i]);
     }
-    
-    /* Draw taskbar */
+    read_unlock(&wm_lock);
+
+    /* Draw taskbar (takes wm_lock itself; read locks don't nest) */
     wm_draw_taskbar();
 }
 
 void wm_update(void) {
-    spinlock_acquire(&wm_lock);
+    TRACE_BEGIN(TRACE_WM_UPDATE, desktop.num_windows, 0);
+    read_lock(&wm_lock);
     
     bool needs_redraw = false;
     for (uint32_t i = 0; i < desktop.num_windows; i++) {
-        if (desktop.windows[i]->needs_redraw) {
+        if (__atomic_exchange_n(&desktop.windows[i]->needs_redraw, false, __ATOMIC_ACQ_REL)) {
             needs_redraw = true;
-            desktop.windows[i]->needs_redraw = false;
         }
     }
     
-    spinlock_release(&wm_lock);
+    read_unlock(&wm_lock);
     
     if (needs_redraw) {
         wm_render();
     }
+
+    /* Apps draw between frames too; put that on screen */
+    graphics_present();
+    TRACE_END(TRACE_WM_UPDATE);
 }
 
 void wm_render(void) {
+    TRACE_BEGIN(TRACE_WM_RENDER, desktop.num_windows, 0);
     wm_draw_desktop();
+    graphics_present();
+    TRACE_END(TRACE_WM_RENDER);
 }
 
 void wm_handle_mouse_event(uint32_t x, uint32_t y, uint8_t buttons) {
-    /* TODO: Hit-testing and window focus */
+    /* Left button: focus and raise the window under the cursor */
+    if (!(buttons & 0x01)) return;
+
+    uint32_t window_id = wm_window_at(x, y);
+    if (!window_id) return;
+
+    /* By id: the window may be destroyed before these look it up */
+    wm_focus_window(window_id);
+    wm_raise_window(window_id);
 }
 
 void wm_handle_key_event(keycode_t key, bool pressed) {